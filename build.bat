@@ -59,7 +59,7 @@ set GraphicsLibs=%VulkanLibs%
 set HostCompilerFlags=%CompilerDefines% %CompilerFlags% 
 REM Removed the CRT
 REM set HostLinkerFlags=/NODEFAULTLIB /SUBSYSTEM:windows -STACK:0x100000,0x100000 %LinkerFlags% kernel32.lib ole32.lib uuid.lib user32.lib gdi32.lib winmm.lib %GraphicsLibs% -out:project_super.exe
-set HostLinkerFlags=-STACK:0x100000,0x100000 %LinkerFlags% ole32.lib user32.lib gdi32.lib winmm.lib %GraphicsLibs% -out:project_super.exe
+set HostLinkerFlags=-STACK:0x100000,0x100000 %LinkerFlags% ole32.lib user32.lib gdi32.lib winmm.lib advapi32.lib %GraphicsLibs% -out:project_super.exe
 
 
 REM clang++ %CompilerDefines% -I..\src -Oi -Od -std=c++17 -I%VulkanIncludeDir% ..\src\win32\win32_platform.cpp  
@@ -1,14 +1,22 @@
 #!/bin/bash
 
 CompilerFlags="-fno-exceptions -fno-rtti  -g -std=c++20 -Wall -Wno-format -Wno-switch -Wno-write-strings -Wno-multichar -Wno-unused-function -Wno-unused-variable -Wno-missing-braces -Wno-unused-value -Wno-nullability-completeness -Wno-reorder-ctor"
-CompilerDefines="-DPROJECTSUPER_INTERNAL=1 -DPROJECTSUPER_SLOW=1 -DPROJECTSUPER_MACOS=1"
+CompilerDefines="-DPROJECTSUPER_INTERNAL=1 -DPROJECTSUPER_SLOW=1"
 
-LinkerFlags="-lstdc++ -framework Cocoa -framework IOKit -framework AudioUnit"
+if [ "$(uname)" == "Linux" ]; then
+    # NOTE: headless only for now, no window or gpu required
+    CompilerFlags="$CompilerFlags -msse4.2 -maes -Wno-unknown-warning-option"
+    CompilerDefines="$CompilerDefines -DPROJECTSUPER_LINUX=1"
+    LinkerFlags="-lstdc++ -ldl -lpthread"
+else
+    CompilerDefines="$CompilerDefines -DPROJECTSUPER_MACOS=1"
+    LinkerFlags="-lstdc++ -framework Cocoa -framework IOKit -framework AudioUnit"
 
-pushd data
-echo Building Shaders...
-./build.sh
-popd
+    pushd data
+    echo Building Shaders...
+    ./build.sh
+    popd
+fi
 
 
 if [ ! -d "./build/" ]; then
@@ -16,8 +24,13 @@ if [ ! -d "./build/" ]; then
 fi
 
 pushd build
+if [ "$(uname)" == "Linux" ]; then
+clang++ $CompilerFlags $CompilerDefines -I../src -I../src/libs -fPIC -shared ../src/ps_game.cpp ../src/libs/tinyobjloader/tiny_obj_loader.cc -o ps_game.so
+clang++ $CompilerFlags $CompilerDefines -I../src -I../src/libs ../src/linux/linux_platform.cpp -o project_super $LinkerFlags
+else
 clang++ $CompilerFlags $CompilerDefines -I../src -I../src/libs -lstdc++ -dynamiclib ../src/ps_game.cpp ../src/libs/tinyobjloader/tiny_obj_loader.cc -o ps_game.dylib
 clang++ $CompilerFlags $CompilerDefines $LinkerFlags -lvulkan -I../src -I../src/libs ../src/macos/macos_platform.mm ../src/vulkan/vma.cpp -o project_super 
+fi
 popd
 
 # {
@@ -0,0 +1,695 @@
+
+inline internal time_t
+LinuxGetFileWriteTime(const char* szFilepath)
+{
+    time_t lastWriteTime = 0;
+
+    struct stat fileStats;
+    if(stat(szFilepath, &fileStats) == 0)
+    {
+        lastWriteTime = fileStats.st_mtime;
+    }
+
+    return lastWriteTime;
+}
+
+internal void
+LinuxGetExecutablePath(linux_state& state)
+{
+    char filepath[LINUX_STATE_FILE_NAME_COUNT] = {};
+    ssize_t pathSize = readlink("/proc/self/exe", filepath, LINUX_STATE_FILE_NAME_COUNT - 1);
+    ASSERT(pathSize > 0);
+
+    string strPath = MakeString((umm)pathSize, filepath);
+    umm pathIndex = ReverseIndexOf(strPath, '/');
+    ASSERT(pathIndex != INDEX_NOT_FOUND);
+
+    // add 1 back to preserve the slash
+    Copy(pathIndex+1, filepath, state.EXEFolder);
+    Copy(strPath.size-pathIndex+1, &filepath[pathIndex+1], state.EXEFilename);
+}
+
+internal b32
+LinuxCopyFile(const char* szSource, const char* szDest)
+{
+    int sourceFd = open(szSource, O_RDONLY);
+    if(sourceFd == -1)
+    {
+        return false;
+    }
+
+    // NOTE(james): unlink first so a currently mapped copy keeps its old inode
+    unlink(szDest);
+    int destFd = open(szDest, O_WRONLY|O_CREAT|O_TRUNC, 0700);
+    if(destFd == -1)
+    {
+        close(sourceFd);
+        return false;
+    }
+
+    b32 success = true;
+    char copyBuffer[Kilobytes(64)];
+    for(;;)
+    {
+        ssize_t bytesRead = read(sourceFd, copyBuffer, sizeof(copyBuffer));
+        if(bytesRead <= 0)
+        {
+            success = (bytesRead == 0);
+            break;
+        }
+
+        if(write(destFd, copyBuffer, bytesRead) != bytesRead)
+        {
+            success = false;
+            break;
+        }
+    }
+
+    close(destFd);
+    close(sourceFd);
+
+    return success;
+}
+
+internal void
+LinuxLoadCode(linux_state& state, linux_loaded_code& code)
+{
+    char szSourceLibraryPath[LINUX_STATE_FILE_NAME_COUNT] = {};
+    FormatString(szSourceLibraryPath, LINUX_STATE_FILE_NAME_COUNT, "%s%s", state.EXEFolder, code.pszSOName);
+    char szTempLibraryPath[LINUX_STATE_FILE_NAME_COUNT] = {};
+    FormatString(szTempLibraryPath, LINUX_STATE_FILE_NAME_COUNT, "%s%s", state.EXEFolder, code.pszTransientSOName);
+
+    code.lastFileWriteTime = LinuxGetFileWriteTime(szSourceLibraryPath);
+
+    // NOTE(james): dlopen caches by path, so always load from a fresh copy
+    // to let the build overwrite the original while we are running
+    void* hLibrary = 0;
+    if(LinuxCopyFile(szSourceLibraryPath, szTempLibraryPath))
+    {
+        hLibrary = dlopen(szTempLibraryPath, RTLD_NOW|RTLD_LOCAL);
+    }
+
+    code.hSO = hLibrary;
+    if(hLibrary)
+    {
+        code.isValid = true;
+        for(u32 index = 0; index < code.nFunctionCount; ++index)
+        {
+            void* pFunc = dlsym(hLibrary, code.ppszFunctionNames[index]);
+            code.ppFunctions[index] = pFunc;
+
+            if(!pFunc)
+            {
+                code.isValid = false;
+            }
+        }
+    }
+    else
+    {
+        LOG_ERROR("Error loading %s: %s", szTempLibraryPath, dlerror());
+        code.isValid = false;
+    }
+}
+
+internal void
+LinuxUnloadCode(linux_loaded_code& code)
+{
+    for(u32 index = 0; index < code.nFunctionCount; ++index)
+    {
+        code.ppFunctions[index] = 0;
+    }
+    code.isValid = false;
+    if(code.hSO)
+    {
+        dlclose(code.hSO);
+    }
+    code.hSO = 0;
+    code.lastFileWriteTime = 0;
+}
+
+internal platform_file
+LinuxOpenFile(FileLocation location, const char* filename, FileUsage usage)
+{
+    platform_file result { .error = 1 };
+    int flags = 0;
+
+    char filepath[LINUX_STATE_FILE_NAME_COUNT];
+    FormatString(filepath, LINUX_STATE_FILE_NAME_COUNT, "%s%s", FileLocationsTable[(u32)location].szFolder, filename);
+
+    if(usage == FileUsage::ReadWrite) { flags = O_RDWR|O_CREAT; }
+    else if(usage == FileUsage::Write) { flags = O_WRONLY|O_CREAT|O_TRUNC; }
+    else { flags = O_RDONLY; }
+
+    int fd = open(filepath, flags, 0644);
+    if(fd != -1)
+    {
+        struct stat fileStats;
+        if(fstat(fd, &fileStats) == 0)
+        {
+            result.size = fileStats.st_size;
+        }
+
+        result.error = 0;
+        result.platform = (void*)(umm)fd;
+    }
+
+    return result;
+}
+
+internal u64
+LinuxReadFile(platform_file& file, void* buffer, u64 size)
+{
+    if(file.error)
+    {
+        ASSERT(false);
+        return 0;
+    }
+
+    u64 amountRead = 0;
+    int fd = (int)(umm)file.platform;
+
+    // read can return short counts, so loop until we have it all
+    while(amountRead < size)
+    {
+        ssize_t bytesRead = read(fd, (u8*)buffer + amountRead, size - amountRead);
+        if(bytesRead > 0)
+        {
+            amountRead += bytesRead;
+        }
+        else if(bytesRead == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    return amountRead;
+}
+
+internal u64
+LinuxWriteFile(platform_file& file, const void* buffer, u64 size)
+{
+    if(file.error)
+    {
+        ASSERT(false);
+        return 0;
+    }
+
+    u64 amountWritten = 0;
+    int fd = (int)(umm)file.platform;
+
+    while(amountWritten < size)
+    {
+        ssize_t bytesWritten = write(fd, (const u8*)buffer + amountWritten, size - amountWritten);
+        if(bytesWritten > 0)
+        {
+            amountWritten += bytesWritten;
+        }
+        else if(bytesWritten == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    return amountWritten;
+}
+
+internal void
+LinuxCloseFile(platform_file& file)
+{
+    if(!file.error)
+    {
+        close((int)(umm)file.platform);
+    }
+}
+
+internal platform_mapped_file
+LinuxMapFile(FileLocation location, const char* filename, FileAccessHint hint)
+{
+    platform_mapped_file result { .error = 1 };
+
+    char filepath[LINUX_STATE_FILE_NAME_COUNT];
+    FormatString(filepath, LINUX_STATE_FILE_NAME_COUNT, "%s%s", FileLocationsTable[(u32)location].szFolder, filename);
+
+    int fd = open(filepath, O_RDONLY);
+    if(fd == -1)
+    {
+        LOG_ERROR("LinuxMapFile: open error on %s: %d  %s", filepath, errno, strerror(errno));
+        return result;
+    }
+
+    struct stat fileStats;
+    if(fstat(fd, &fileStats) == 0)
+    {
+        result.size = fileStats.st_size;
+        if(result.size == 0)
+        {
+            // mmap won't take a zero length
+            result.error = 0;
+        }
+        else
+        {
+            void* data = mmap(0, result.size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(data != MAP_FAILED)
+            {
+                int advice = MADV_NORMAL;
+                if(hint == FileAccessHint::Sequential) { advice = MADV_SEQUENTIAL; }
+                else if(hint == FileAccessHint::Random) { advice = MADV_RANDOM; }
+                madvise(data, result.size, advice);
+                if(hint == FileAccessHint::Sequential)
+                {
+                    // NOTE(james): it's all going to be read, so start pulling it in now
+                    madvise(data, result.size, MADV_WILLNEED);
+                }
+
+                result.data = (const u8*)data;
+                result.error = 0;
+            }
+            else
+            {
+                LOG_ERROR("LinuxMapFile: mmap error on %s: %d  %s", filepath, errno, strerror(errno));
+            }
+        }
+    }
+
+    // the mapping holds its own reference to the file
+    close(fd);
+
+    return result;
+}
+
+internal void
+LinuxUnmapFile(platform_mapped_file& file)
+{
+    if(file.data)
+    {
+        munmap((void*)file.data, file.size);
+    }
+    ZeroStruct(file);
+    file.error = 1;
+}
+
+inline internal b32
+LinuxIsDotEntry(const char* name)
+{
+    return name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2]));
+}
+
+internal void
+LinuxListDirectory(memory_arena& arena, platform_file_list& list, FileLocation location, const char* directory, b32 recursive)
+{
+    char dirpath[LINUX_STATE_FILE_NAME_COUNT];
+    FormatString(dirpath, LINUX_STATE_FILE_NAME_COUNT, "%s%s", FileLocationsTable[(u32)location].szFolder, directory);
+
+    DIR* dir = opendir(dirpath);
+    if(!dir)
+    {
+        return;
+    }
+
+    while(struct dirent* entry = readdir(dir))
+    {
+        if(LinuxIsDotEntry(entry->d_name))
+        {
+            continue;
+        }
+
+        // NOTE(james): whatever vanished between readdir and here just gets left out
+        struct stat fileStats;
+        if(fstatat(dirfd(dir), entry->d_name, &fileStats, 0) != 0)
+        {
+            continue;
+        }
+
+        char name[LINUX_STATE_FILE_NAME_COUNT];
+        FormatString(name, LINUX_STATE_FILE_NAME_COUNT, "%s%s", directory, entry->d_name);
+
+        platform_file_info* info = PushFileInfo(arena, list, name);
+        info->isDirectory = S_ISDIR(fileStats.st_mode);
+        info->size = info->isDirectory ? 0 : (u64)fileStats.st_size;
+        info->writeTime = (u64)fileStats.st_mtim.tv_sec * 1000000000ull + (u64)fileStats.st_mtim.tv_nsec;
+
+        if(recursive && info->isDirectory)
+        {
+            FormatString(name, LINUX_STATE_FILE_NAME_COUNT, "%s%s/", directory, entry->d_name);
+            LinuxListDirectory(arena, list, location, name, recursive);
+        }
+    }
+
+    closedir(dir);
+}
+
+internal platform_file_list
+LinuxListFiles(memory_arena& arena, FileLocation location, const char* directory, b32 recursive)
+{
+    platform_file_list result = {};
+
+    char prefix[LINUX_STATE_FILE_NAME_COUNT];
+    MakeDirectoryPrefix(directory, prefix, LINUX_STATE_FILE_NAME_COUNT);
+    LinuxListDirectory(arena, result, location, prefix, recursive);
+
+    return result;
+}
+
+internal void
+LinuxInitFileWatcher(linux_file_watcher& watcher)
+{
+    watcher.arena.allocationFlags = PlatformMemoryFlags::NotRestored;
+
+    watcher.inotifyFd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+    if(watcher.inotifyFd == -1)
+    {
+        LOG_ERROR("inotify_init1 failed, file changes won't be reported: %d  %s", errno, strerror(errno));
+    }
+}
+
+internal linux_inotify_watch*
+LinuxFindInotifyWatch(linux_file_watcher& watcher, int wd)
+{
+    for(u32 index = 0; index < watcher.inotifyWatchCount; ++index)
+    {
+        if(watcher.inotifyWatches[index].wd == wd)
+        {
+            return watcher.inotifyWatches + index;
+        }
+    }
+    return 0;
+}
+
+internal linux_inotify_watch*
+LinuxFindInotifyWatch(linux_file_watcher& watcher, int wd, u32 watchId)
+{
+    for(u32 index = 0; index < watcher.inotifyWatchCount; ++index)
+    {
+        linux_inotify_watch* dirWatch = watcher.inotifyWatches + index;
+        if(dirWatch->wd == wd && dirWatch->watchId == watchId)
+        {
+            return dirWatch;
+        }
+    }
+    return 0;
+}
+
+// NOTE(james): copied out, since following up on any of them changes the records
+internal u32
+LinuxGetInotifyWatchIds(linux_file_watcher& watcher, int wd, u32* watchIds)
+{
+    u32 count = 0;
+    for(u32 index = 0; index < watcher.inotifyWatchCount && count < LINUX_MAX_DIRECTORY_WATCHES; ++index)
+    {
+        if(watcher.inotifyWatches[index].wd == wd)
+        {
+            watchIds[count++] = watcher.inotifyWatches[index].watchId;
+        }
+    }
+    return count;
+}
+
+// NOTE(james): the kernel drops the descriptor itself when the directory goes away, so
+// this only has to forget about it
+inline internal void
+LinuxForgetInotifyWatch(linux_file_watcher& watcher, linux_inotify_watch* dirWatch)
+{
+    *dirWatch = watcher.inotifyWatches[--watcher.inotifyWatchCount];
+}
+
+// NOTE(james): path has to end in a slash (or be empty).  Changes is only passed for
+// directories that showed up after the watch started, their contents get reported as
+// added since nothing was watching when they were made.
+internal b32
+LinuxWatchDirectoryTree(linux_file_watcher& watcher, u32 watchId, FileLocation location, const char* path,
+                        memory_arena* arena, file_change_builder* changes)
+{
+    char dirpath[LINUX_STATE_FILE_NAME_COUNT];
+    FormatString(dirpath, LINUX_STATE_FILE_NAME_COUNT, "%s%s", FileLocationsTable[(u32)location].szFolder, path);
+
+    if((umm)StringLength(path) >= LINUX_WATCH_PATH_COUNT)
+    {
+        LOG_ERROR("Path too long to watch: %s", dirpath);
+        return false;
+    }
+
+    // NOTE(james): the watch goes on before looking inside, so nothing made in between is missed
+    u32 mask = IN_CREATE|IN_CLOSE_WRITE|IN_DELETE|IN_MOVED_FROM|IN_MOVED_TO|IN_ONLYDIR;
+    int wd = inotify_add_watch(watcher.inotifyFd, dirpath, mask);
+    if(wd == -1)
+    {
+        LOG_ERROR("inotify_add_watch failed on %s: %d  %s", dirpath, errno, strerror(errno));
+        return false;
+    }
+
+    // this watch already has it (a directory that was moved back in, or a link loop)
+    if(LinuxFindInotifyWatch(watcher, wd, watchId))
+    {
+        return true;
+    }
+
+    if(watcher.inotifyWatchCount == LINUX_MAX_INOTIFY_WATCHES)
+    {
+        LOG_ERROR("Out of inotify watches, not watching %s", dirpath);
+        if(!LinuxFindInotifyWatch(watcher, wd))
+        {
+            inotify_rm_watch(watcher.inotifyFd, wd);
+        }
+        return false;
+    }
+
+    linux_inotify_watch* dirWatch = watcher.inotifyWatches + watcher.inotifyWatchCount++;
+    dirWatch->wd = wd;
+    dirWatch->watchId = watchId;
+    dirWatch->location = location;
+    CopyString(path, dirWatch->path, LINUX_WATCH_PATH_COUNT);
+
+    DIR* dir = opendir(dirpath);
+    if(dir)
+    {
+        while(struct dirent* entry = readdir(dir))
+        {
+            if(LinuxIsDotEntry(entry->d_name))
+            {
+                continue;
+            }
+
+            char name[LINUX_STATE_FILE_NAME_COUNT];
+            FormatString(name, LINUX_STATE_FILE_NAME_COUNT, "%s%s", path, entry->d_name);
+            if(changes)
+            {
+                PushFileChange(*arena, *changes, location, name, FileChangeType::Added);
+            }
+
+            struct stat fileStats;
+            if(fstatat(dirfd(dir), entry->d_name, &fileStats, 0) == 0 && S_ISDIR(fileStats.st_mode))
+            {
+                FormatString(name, LINUX_STATE_FILE_NAME_COUNT, "%s%s/", path, entry->d_name);
+                LinuxWatchDirectoryTree(watcher, watchId, location, name, arena, changes);
+            }
+            else
+            {
+                watcher.knownFiles->set(FileChangeKey(location, name), true);
+            }
+        }
+        closedir(dir);
+    }
+
+    return true;
+}
+
+// NOTE(james): pulls the watches for a directory that moved out from under us, path ends in a slash
+internal void
+LinuxUnwatchDirectoryTree(linux_file_watcher& watcher, u32 watchId, const char* path)
+{
+    umm prefixLength = (umm)StringLength(path);
+    for(u32 index = watcher.inotifyWatchCount; index > 0; --index)
+    {
+        linux_inotify_watch* dirWatch = watcher.inotifyWatches + (index - 1);
+        if(dirWatch->watchId == watchId &&
+           (umm)StringLength(dirWatch->path) >= prefixLength &&
+           MemCompare(prefixLength, dirWatch->path, path))
+        {
+            int wd = dirWatch->wd;
+            LinuxForgetInotifyWatch(watcher, dirWatch);
+            // NOTE(james): an overlapping watch still wants it
+            if(!LinuxFindInotifyWatch(watcher, wd))
+            {
+                inotify_rm_watch(watcher.inotifyFd, wd);
+            }
+        }
+    }
+}
+
+internal platform_directory_watch
+LinuxWatchDirectory(FileLocation location, const char* directory)
+{
+    platform_directory_watch result = {};
+    linux_file_watcher& watcher = GlobalLinuxState.fileWatcher;
+
+    if(watcher.inotifyFd == -1)
+    {
+        return result;
+    }
+
+    linux_directory_watch* watch = 0;
+    for(u32 index = 0; index < LINUX_MAX_DIRECTORY_WATCHES; ++index)
+    {
+        if(!watcher.watches[index].id)
+        {
+            watch = watcher.watches + index;
+            break;
+        }
+    }
+    ASSERT(watch);
+
+    if(!watcher.knownFiles)
+    {
+        watcher.knownFiles = hashtable_create(watcher.arena, b32, 1024);
+    }
+
+    if(!++watcher.nextWatchId) ++watcher.nextWatchId;
+    watch->id = watcher.nextWatchId;
+    watch->location = location;
+
+    char prefix[LINUX_STATE_FILE_NAME_COUNT];
+    MakeDirectoryPrefix(directory, prefix, LINUX_STATE_FILE_NAME_COUNT);
+    if(!LinuxWatchDirectoryTree(watcher, watch->id, location, prefix, 0, 0))
+    {
+        watch->id = 0;
+        return result;
+    }
+
+    result.id = watch->id;
+    return result;
+}
+
+internal void
+LinuxUnwatchDirectory(platform_directory_watch watch)
+{
+    linux_file_watcher& watcher = GlobalLinuxState.fileWatcher;
+
+    if(!watch.id)
+    {
+        return;
+    }
+
+    LinuxUnwatchDirectoryTree(watcher, watch.id, "");
+    for(u32 index = 0; index < LINUX_MAX_DIRECTORY_WATCHES; ++index)
+    {
+        if(watcher.watches[index].id == watch.id)
+        {
+            watcher.watches[index].id = 0;
+        }
+    }
+}
+
+internal platform_file_change_list
+LinuxGetFileChanges(memory_arena& arena)
+{
+    file_change_builder changes = {};
+    linux_file_watcher& watcher = GlobalLinuxState.fileWatcher;
+
+    if(watcher.inotifyFd == -1)
+    {
+        return changes.list;
+    }
+
+    // NOTE(james): the kernel always hands back whole events, aligned for reading in place
+    alignas(inotify_event) u8 buffer[4096];
+    for(;;)
+    {
+        ssize_t length = read(watcher.inotifyFd, buffer, sizeof(buffer));
+        if(length <= 0)
+        {
+            // EAGAIN once everything is drained
+            break;
+        }
+
+        for(u8* at = buffer; at < buffer + length; )
+        {
+            inotify_event* event = (inotify_event*)at;
+            at += sizeof(inotify_event) + event->len;
+
+            if(event->mask & IN_Q_OVERFLOW)
+            {
+                changes.list.overflowed = true;
+                continue;
+            }
+
+            linux_inotify_watch* dirWatch = LinuxFindInotifyWatch(watcher, event->wd);
+            if(!dirWatch)
+            {
+                continue;
+            }
+
+            if(event->mask & IN_IGNORED)
+            {
+                for(; dirWatch; dirWatch = LinuxFindInotifyWatch(watcher, event->wd))
+                {
+                    LinuxForgetInotifyWatch(watcher, dirWatch);
+                }
+                continue;
+            }
+
+            if(!event->len)
+            {
+                continue;
+            }
+
+            // NOTE(james): the change only goes out once, but every watch sharing the
+            // directory has to follow directories coming and going under it
+            u32 watchIds[LINUX_MAX_DIRECTORY_WATCHES];
+            u32 watchIdCount = LinuxGetInotifyWatchIds(watcher, event->wd, watchIds);
+            FileLocation location = dirWatch->location;
+            char path[LINUX_WATCH_PATH_COUNT];
+            CopyString(dirWatch->path, path, LINUX_WATCH_PATH_COUNT);
+
+            char name[LINUX_STATE_FILE_NAME_COUNT];
+            FormatString(name, LINUX_STATE_FILE_NAME_COUNT, "%s%s", path, event->name);
+
+            u64 key = FileChangeKey(location, name);
+            if(event->mask & (IN_CREATE|IN_MOVED_TO))
+            {
+                // NOTE(james): renamed over a file we already had, which is how a lot of editors save
+                b32 replaced = (event->mask & IN_MOVED_TO) && watcher.knownFiles->contains(key);
+                PushFileChange(arena, changes, location, name, replaced ? FileChangeType::Modified : FileChangeType::Added);
+                if(event->mask & IN_ISDIR)
+                {
+                    FormatString(name, LINUX_STATE_FILE_NAME_COUNT, "%s%s/", path, event->name);
+                    for(u32 index = 0; index < watchIdCount; ++index)
+                    {
+                        LinuxWatchDirectoryTree(watcher, watchIds[index], location, name, &arena, &changes);
+                    }
+                }
+                else
+                {
+                    watcher.knownFiles->set(key, true);
+                }
+            }
+            else if(event->mask & IN_CLOSE_WRITE)
+            {
+                // NOTE(james): only once the writer is done, so nobody reloads half a file
+                PushFileChange(arena, changes, location, name, FileChangeType::Modified);
+            }
+            else if(event->mask & (IN_DELETE|IN_MOVED_FROM))
+            {
+                PushFileChange(arena, changes, location, name, FileChangeType::Removed);
+                watcher.knownFiles->erase(key);
+                if((event->mask & IN_MOVED_FROM) && (event->mask & IN_ISDIR))
+                {
+                    FormatString(name, LINUX_STATE_FILE_NAME_COUNT, "%s%s/", path, event->name);
+                    for(u32 index = 0; index < watchIdCount; ++index)
+                    {
+                        LinuxUnwatchDirectoryTree(watcher, watchIds[index], name);
+                    }
+                }
+            }
+        }
+    }
+
+    return changes.list;
+}
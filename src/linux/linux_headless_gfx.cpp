@@ -0,0 +1,322 @@
+/*******************************************************************************
+
+    Headless graphics backend
+
+    Fills in the gfx_api with a null device so the game can run without a
+    GPU or a window.  Every resource gets a unique non-zero id so handle
+    validation in the game still works, and buffers that the CPU can see are
+    backed by real memory so staging uploads still touch their bytes.
+    Commands are accepted and dropped.
+
+********************************************************************************/
+
+struct linux_headless_gfx
+{
+    memory_arena arena;
+    ticket_mutex bufferMutex;
+    hashtable<platform_memory_block*>* buffers;
+
+    u64 volatile nextResourceId;
+};
+
+global linux_headless_gfx GlobalHeadlessGfx;
+
+inline internal u64
+HeadlessNextId()
+{
+    // NOTE(james): AtomicAddU64 returns the value prior to adding, so
+    // start at 1 to keep 0 as the invalid handle
+    return AtomicAddU64(&GlobalHeadlessGfx.nextResourceId, 1) + 1;
+}
+
+internal GfxResourceHeap
+HeadlessCreateResourceHeap(GfxDevice device)
+{
+    return GfxResourceHeap{ device.id, HeadlessNextId() };
+}
+
+internal GfxResult
+HeadlessDestroyResourceHeap(GfxDevice device, GfxResourceHeap heap)
+{
+    return GfxResult::Ok;
+}
+
+internal GfxBuffer
+HeadlessCreateBuffer(GfxDevice device, const GfxBufferDesc& bufferDesc, void const* data)
+{
+    GfxBuffer buffer = { bufferDesc.heap.id, HeadlessNextId() };
+
+    if(bufferDesc.access != GfxMemoryAccess::GpuOnly && bufferDesc.size > 0)
+    {
+        platform_memory_block* block = Platform.AllocateMemoryBlock(bufferDesc.size, PlatformMemoryFlags::NotRestored);
+        block->used = bufferDesc.size;
+
+        if(data)
+        {
+            Copy(bufferDesc.size, data, block->base);
+        }
+
+        BeginTicketMutex(&GlobalHeadlessGfx.bufferMutex);
+        GlobalHeadlessGfx.buffers->set(buffer.id, block);
+        EndTicketMutex(&GlobalHeadlessGfx.bufferMutex);
+    }
+
+    return buffer;
+}
+
+internal GfxResult
+HeadlessDestroyBuffer(GfxDevice device, GfxBuffer buffer)
+{
+    platform_memory_block* block = 0;
+
+    BeginTicketMutex(&GlobalHeadlessGfx.bufferMutex);
+    if(GlobalHeadlessGfx.buffers->try_get(buffer.id, &block))
+    {
+        GlobalHeadlessGfx.buffers->erase(buffer.id);
+    }
+    EndTicketMutex(&GlobalHeadlessGfx.bufferMutex);
+
+    if(block)
+    {
+        Platform.DeallocateMemoryBlock(block);
+    }
+
+    return GfxResult::Ok;
+}
+
+internal void*
+HeadlessGetBufferData(GfxDevice device, GfxBuffer buffer)
+{
+    platform_memory_block* block = 0;
+
+    BeginTicketMutex(&GlobalHeadlessGfx.bufferMutex);
+    GlobalHeadlessGfx.buffers->try_get(buffer.id, &block);
+    EndTicketMutex(&GlobalHeadlessGfx.bufferMutex);
+
+    // NOTE(james): GPU only buffers have no CPU mapping, same as the real backends
+    return block ? block->base : 0;
+}
+
+internal GfxTexture
+HeadlessCreateTexture(GfxDevice device, const GfxTextureDesc& textureDesc)
+{
+    return GfxTexture{ 0, HeadlessNextId() };
+}
+
+internal GfxResult
+HeadlessDestroyTexture(GfxDevice device, GfxTexture texture) { return GfxResult::Ok; }
+
+internal GfxSampler
+HeadlessCreateSampler(GfxDevice device, const GfxSamplerDesc& samplerDesc)
+{
+    return GfxSampler{ 0, HeadlessNextId() };
+}
+
+internal GfxResult
+HeadlessDestroySampler(GfxDevice device, GfxSampler sampler) { return GfxResult::Ok; }
+
+internal GfxProgram
+HeadlessCreateProgram(GfxDevice device, const GfxProgramDesc& programDesc)
+{
+    return GfxProgram{ 0, HeadlessNextId() };
+}
+
+internal GfxResult
+HeadlessDestroyProgram(GfxDevice device, GfxProgram program) { return GfxResult::Ok; }
+
+internal GfxRenderTarget
+HeadlessCreateRenderTarget(GfxDevice device, const GfxRenderTargetDesc& rtvDesc)
+{
+    return GfxRenderTarget{ 0, HeadlessNextId() };
+}
+
+internal GfxResult
+HeadlessDestroyRenderTarget(GfxDevice device, GfxRenderTarget rtv) { return GfxResult::Ok; }
+
+internal TinyImageFormat
+HeadlessGetDeviceBackBufferFormat(GfxDevice device)
+{
+    return TinyImageFormat_B8G8R8A8_SRGB;
+}
+
+internal GfxKernel
+HeadlessCreateComputeKernel(GfxDevice device, GfxProgram program)
+{
+    return GfxKernel{ 0, HeadlessNextId() };
+}
+
+internal GfxKernel
+HeadlessCreateGraphicsKernel(GfxDevice device, GfxProgram program, const GfxPipelineDesc& pipelineDesc)
+{
+    return GfxKernel{ 0, HeadlessNextId() };
+}
+
+internal GfxResult
+HeadlessDestroyKernel(GfxDevice device, GfxKernel kernel) { return GfxResult::Ok; }
+
+internal GfxCmdEncoderPool
+HeadlessCreateEncoderPool(GfxDevice device, const GfxCmdEncoderPoolDesc& poolDesc)
+{
+    return GfxCmdEncoderPool{ device.id, HeadlessNextId() };
+}
+
+internal GfxResult
+HeadlessDestroyCmdEncoderPool(GfxDevice device, GfxCmdEncoderPool pool) { return GfxResult::Ok; }
+
+internal GfxCmdContext
+HeadlessCreateEncoderContext(GfxCmdEncoderPool pool)
+{
+    return GfxCmdContext{ pool.deviceId, pool.id, HeadlessNextId() };
+}
+
+internal GfxResult
+HeadlessCreateEncoderContexts(GfxCmdEncoderPool pool, u32 numContexts, GfxCmdContext* pContexts)
+{
+    for(u32 index = 0; index < numContexts; ++index)
+    {
+        pContexts[index] = HeadlessCreateEncoderContext(pool);
+    }
+    return GfxResult::Ok;
+}
+
+internal GfxResult HeadlessResetCmdEncoderPool(GfxCmdEncoderPool pool) { return GfxResult::Ok; }
+internal GfxResult HeadlessBeginEncodingCmds(GfxCmdContext cmds) { return GfxResult::Ok; }
+internal GfxResult HeadlessEndEncodingCmds(GfxCmdContext cmds) { return GfxResult::Ok; }
+
+internal GfxResult HeadlessCmdResourceBarrier(GfxCmdContext cmds, u32 numBufferBarriers, GfxBufferBarrier* pBufferBarriers, u32 numTextureBarriers, GfxTextureBarrier* pTextureBarriers, u32 numRenderTargetBarriers, GfxRenderTargetBarrier* pRenderTargetBarriers) { return GfxResult::Ok; }
+
+internal GfxResult HeadlessCmdCopyBuffer(GfxCmdContext cmds, GfxBuffer src, GfxBuffer dest) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdCopyBufferRange(GfxCmdContext cmds, GfxBuffer src, u64 srcOffset, GfxBuffer dest, u64 destOffset, u64 size) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdClearBuffer(GfxCmdContext cmds, GfxBuffer buffer, u32 clearValue) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdUpdateBuffer(GfxCmdContext cmds, GfxBuffer dest, u64 destOffset, u64 size, const void* data) { return GfxResult::Ok; }
+
+internal GfxResult HeadlessCmdClearTexture(GfxCmdContext cmds, GfxTexture texture, GfxColor color) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdCopyTexture(GfxCmdContext cmds, GfxTexture src, GfxTexture dest) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdClearImage(GfxCmdContext cmds, GfxTexture texture, u32 mipLevel, u32 slice, GfxColor color) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdClearRenderTarget(GfxCmdContext cmds, GfxRenderTarget renderTarget, GfxColor color, f32 depth, u8 stencil) { return GfxResult::Ok; }
+
+internal GfxResult HeadlessCmdCopyBufferToTexture(GfxCmdContext cmds, GfxBuffer src, u64 srcOffset, GfxTexture dest) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdGenerateMips(GfxCmdContext cmds, GfxTexture texture) { return GfxResult::Ok; }
+
+internal GfxResult HeadlessCmdBindRenderTargets(GfxCmdContext cmds, u32 numRenderTargets, GfxRenderTarget* pColorRTVs, GfxRenderTarget* pDepthStencilRTV) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdBindKernel(GfxCmdContext cmds, GfxKernel kernel) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdBindIndexBuffer(GfxCmdContext cmds, GfxBuffer indexBuffer) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdBindVertexBuffer(GfxCmdContext cmds, GfxBuffer vertexBuffer) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdBindDescriptorSet(GfxCmdContext cmds, const GfxDescriptorSet& descriptorSet) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdBindPushConstant(GfxCmdContext cmds, const char* name, const void* data) { return GfxResult::Ok; }
+
+internal GfxResult HeadlessCmdSetViewport(GfxCmdContext cmds, f32 x, f32 y, f32 width, f32 height) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdSetScissorRect(GfxCmdContext cmds, i32 x, i32 y, u32 width, u32 height) { return GfxResult::Ok; }
+
+internal GfxResult HeadlessCmdDraw(GfxCmdContext cmds, u32 vertexCount, u32 instanceCount, u32 baseVertex, u32 baseInstance) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdDrawIndexed(GfxCmdContext cmds, u32 indexCount, u32 instanceCount, u32 firstIndex, u32 baseVertex, u32 baseInstance) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdDrawIndirect(GfxCmdContext cmds, GfxBuffer argsBuffer, u32 argsCount) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdDrawIndexedIndirect(GfxCmdContext cmds, GfxBuffer argsBuffer, u32 argsCount) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdDispatch(GfxCmdContext cmds, u32 numGroupsX, u32 numGroupsY, u32 numGroupsZ) { return GfxResult::Ok; }
+internal GfxResult HeadlessCmdDispatchIndirect(GfxCmdContext cmds, GfxBuffer argsBuffer) { return GfxResult::Ok; }
+
+internal GfxRenderTarget
+HeadlessAcquireNextSwapChainTarget(GfxDevice device)
+{
+    // NOTE(james): the swap chain target is a fixed id, like a real backbuffer
+    return GfxRenderTarget{ 0, U64MAX };
+}
+
+internal GfxResult HeadlessSubmitCommands(GfxDevice device, u32 count, GfxCmdContext* pContexts) { return GfxResult::Ok; }
+internal GfxResult HeadlessFrame(GfxDevice device, u32 contextCount, GfxCmdContext* pContexts) { return GfxResult::Ok; }
+internal GfxResult HeadlessFinish(GfxDevice device) { return GfxResult::Ok; }
+internal GfxResult HeadlessCleanupUnusedRenderingResources(GfxDevice device) { return GfxResult::Ok; }
+
+internal GfxTimestampQuery
+HeadlessCreateTimestampQuery(GfxDevice device)
+{
+    return GfxTimestampQuery{ 0, HeadlessNextId() };
+}
+
+internal GfxResult HeadlessDestroyTimestampQuery(GfxDevice device, GfxTimestampQuery timestampQuery) { return GfxResult::Ok; }
+internal f32 HeadlessGetTimestampQueryDuration(GfxDevice device, GfxTimestampQuery timestampQuery) { return 0.0f; }
+internal GfxResult HeadlessBeginTimestampQuery(GfxCmdContext cmds, GfxTimestampQuery query) { return GfxResult::Ok; }
+internal GfxResult HeadlessEndTimestampQuery(GfxCmdContext cmds, GfxTimestampQuery query) { return GfxResult::Ok; }
+internal GfxResult HeadlessBeginEvent(GfxCmdContext cmds, const char* name) { return GfxResult::Ok; }
+internal GfxResult HeadlessBeginColorEvent(GfxCmdContext cmds, const char* name) { return GfxResult::Ok; }
+internal GfxResult HeadlessEndEvent(GfxCmdContext cmds) { return GfxResult::Ok; }
+
+internal gfx_api
+LinuxLoadHeadlessGraphics()
+{
+    linux_headless_gfx& headless = GlobalHeadlessGfx;
+    headless.arena.allocationFlags = PlatformMemoryFlags::NotRestored;
+    headless.buffers = hashtable_create(headless.arena, platform_memory_block*, 4096); // TODO(james): tune this to the actual application
+
+    gfx_api gfx = {};
+    gfx.device.id = HeadlessNextId();
+
+    gfx.CreateResourceHeap = &HeadlessCreateResourceHeap;
+    gfx.DestroyResourceHeap = &HeadlessDestroyResourceHeap;
+    gfx.CreateBuffer = &HeadlessCreateBuffer;
+    gfx.DestroyBuffer = &HeadlessDestroyBuffer;
+    gfx.GetBufferData = &HeadlessGetBufferData;
+    gfx.CreateTexture = &HeadlessCreateTexture;
+    gfx.DestroyTexture = &HeadlessDestroyTexture;
+    gfx.CreateSampler = &HeadlessCreateSampler;
+    gfx.DestroySampler = &HeadlessDestroySampler;
+    gfx.CreateProgram = &HeadlessCreateProgram;
+    gfx.DestroyProgram = &HeadlessDestroyProgram;
+    gfx.CreateRenderTarget = &HeadlessCreateRenderTarget;
+    gfx.DestroyRenderTarget = &HeadlessDestroyRenderTarget;
+    gfx.GetDeviceBackBufferFormat = &HeadlessGetDeviceBackBufferFormat;
+    gfx.CreateComputeKernel = &HeadlessCreateComputeKernel;
+    gfx.CreateGraphicsKernel = &HeadlessCreateGraphicsKernel;
+    gfx.DestroyKernel = &HeadlessDestroyKernel;
+
+    gfx.CreateEncoderPool = &HeadlessCreateEncoderPool;
+    gfx.DestroyCmdEncoderPool = &HeadlessDestroyCmdEncoderPool;
+    gfx.CreateEncoderContext = &HeadlessCreateEncoderContext;
+    gfx.CreateEncoderContexts = &HeadlessCreateEncoderContexts;
+    gfx.ResetCmdEncoderPool = &HeadlessResetCmdEncoderPool;
+    gfx.BeginEncodingCmds = &HeadlessBeginEncodingCmds;
+    gfx.EndEncodingCmds = &HeadlessEndEncodingCmds;
+
+    gfx.CmdResourceBarrier = &HeadlessCmdResourceBarrier;
+    gfx.CmdCopyBuffer = &HeadlessCmdCopyBuffer;
+    gfx.CmdCopyBufferRange = &HeadlessCmdCopyBufferRange;
+    gfx.CmdClearBuffer = &HeadlessCmdClearBuffer;
+    gfx.CmdUpdateBuffer = &HeadlessCmdUpdateBuffer;
+    gfx.CmdClearTexture = &HeadlessCmdClearTexture;
+    gfx.CmdCopyTexture = &HeadlessCmdCopyTexture;
+    gfx.CmdClearImage = &HeadlessCmdClearImage;
+    gfx.CmdClearRenderTarget = &HeadlessCmdClearRenderTarget;
+    gfx.CmdCopyBufferToTexture = &HeadlessCmdCopyBufferToTexture;
+    gfx.CmdGenerateMips = &HeadlessCmdGenerateMips;
+    gfx.CmdBindRenderTargets = &HeadlessCmdBindRenderTargets;
+    gfx.CmdBindKernel = &HeadlessCmdBindKernel;
+    gfx.CmdBindIndexBuffer = &HeadlessCmdBindIndexBuffer;
+    gfx.CmdBindVertexBuffer = &HeadlessCmdBindVertexBuffer;
+    gfx.CmdBindDescriptorSet = &HeadlessCmdBindDescriptorSet;
+    gfx.CmdBindPushConstant = &HeadlessCmdBindPushConstant;
+    gfx.CmdSetViewport = &HeadlessCmdSetViewport;
+    gfx.CmdSetScissorRect = &HeadlessCmdSetScissorRect;
+    gfx.CmdDraw = &HeadlessCmdDraw;
+    gfx.CmdDrawIndexed = &HeadlessCmdDrawIndexed;
+    gfx.CmdDrawIndirect = &HeadlessCmdDrawIndirect;
+    gfx.CmdDrawIndexedIndirect = &HeadlessCmdDrawIndexedIndirect;
+    gfx.CmdDispatch = &HeadlessCmdDispatch;
+    gfx.CmdDispatchIndirect = &HeadlessCmdDispatchIndirect;
+
+    gfx.AcquireNextSwapChainTarget = &HeadlessAcquireNextSwapChainTarget;
+    gfx.SubmitCommands = &HeadlessSubmitCommands;
+    gfx.Frame = &HeadlessFrame;
+    gfx.Finish = &HeadlessFinish;
+    gfx.CleanupUnusedRenderingResources = &HeadlessCleanupUnusedRenderingResources;
+
+    gfx.CreateTimestampQuery = &HeadlessCreateTimestampQuery;
+    gfx.DestroyTimestampQuery = &HeadlessDestroyTimestampQuery;
+    gfx.GetTimestampQueryDuration = &HeadlessGetTimestampQueryDuration;
+    gfx.BeginTimestampQuery = &HeadlessBeginTimestampQuery;
+    gfx.EndTimestampQuery = &HeadlessEndTimestampQuery;
+    gfx.BeginEvent = &HeadlessBeginEvent;
+    gfx.BeginColorEvent = &HeadlessBeginColorEvent;
+    gfx.EndEvent = &HeadlessEndEvent;
+
+    return gfx;
+}
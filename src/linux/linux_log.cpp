@@ -0,0 +1,51 @@
+
+// TODO(james): support multiple log levels
+
+#if PROJECTSUPER_INTERNAL
+#define LOG(level, msg, ...) LinuxDebugLog(level, __FILE__, __LINE__, msg, ## __VA_ARGS__)
+#define LOG_DEBUG(msg, ...) LOG(LogLevel::Debug, msg, ## __VA_ARGS__)
+#define LOG_INFO(msg, ...) LOG(LogLevel::Info, msg, ## __VA_ARGS__)
+#define LOG_ERROR(msg, ...) LOG(LogLevel::Error, msg, ## __VA_ARGS__)
+#else
+#define LOG(level, msg, ...) LinuxLog(level, msg, ## __VA_ARGS__)
+#define LOG_DEBUG(msg, ...)
+#define LOG_INFO(msg, ...) LOG(LogLevel::Info, msg, ## __VA_ARGS__)
+#define LOG_ERROR(msg, ...) LOG(LogLevel::Error, msg, ## __VA_ARGS__)
+#endif
+
+internal void
+LinuxLog(LogLevel level, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+
+    char szMessage[4096];
+    int n = FormatStringV(szMessage, format, args);
+    va_end(args);
+
+    const char* levels[] = { "DBG", "INF", "ERR" };
+
+    // NOTE(james): headless runs are usually captured by a log collector, so
+    // everything goes to stderr in one write to keep lines from interleaving
+    char logLine[4096 + 16];
+    int lineLength = ps_snprintf(logLine, sizeof(logLine), "%s | %s\n", levels[(u32)level], szMessage);
+    write(STDERR_FILENO, logLine, lineLength);
+}
+
+internal void
+LinuxDebugLog(LogLevel level, const char* file, int lineno, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+
+    char logMessage[2048];
+    int n = FormatStringV(logMessage, format, args);
+
+    va_end(args);
+
+    const char* levels[] = { "DBG", "INF", "ERR" };
+
+    char logLine[4096];
+    int lineLength = ps_snprintf(logLine, sizeof(logLine), "%s | %s(%d) | %s\n", levels[(u32)level], file, lineno, logMessage);
+    write(STDERR_FILENO, logLine, lineLength);
+}
@@ -0,0 +1,1081 @@
+
+
+// NOTE(james): the collection tests use strcmp, windows.h drags this in for win32
+#include <string.h>
+
+#include "ps_platform.h"
+#include "ps_shared.h"
+#include "ps_intrinsics.h"
+#include "ps_math.h"
+#include "ps_memory.h"
+#include "ps_collections.h"
+#include "ps_stream.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <linux/io_uring.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sched.h>
+#include <dirent.h>
+
+#include "linux_platform.h"
+
+linux_state GlobalLinuxState;
+platform_api Platform;
+linux_file_location FileLocationsTable[(u32)FileLocation::LocationsCount];
+
+#include "linux_log.cpp"
+#include "ps_file_watch.h"
+#include "linux_file.cpp"
+
+// TODO(james): Load the vulkan backend for windowed mode once there is an xcb/wayland surface
+#include "linux_headless_gfx.cpp"
+
+global const int FIXED_RENDER_WIDTH = 1920;
+global const int FIXED_RENDER_HEIGHT = 1080;
+
+global_variable bool32 volatile GlobalRunning = true;
+
+internal void
+LinuxSetupFileLocationsTable(linux_state& state)
+{
+    // TODO(james): Put user folder into $XDG_DATA_HOME
+
+    FileLocationsTable[(u32)FileLocation::Content].location = FileLocation::Content;
+    FormatString(FileLocationsTable[(u32)FileLocation::Content].szFolder, LINUX_STATE_FILE_NAME_COUNT, "%s../data/", state.EXEFolder);
+
+    FileLocationsTable[(u32)FileLocation::User].location = FileLocation::User;
+    FormatString(FileLocationsTable[(u32)FileLocation::User].szFolder, LINUX_STATE_FILE_NAME_COUNT, "%s", state.EXEFolder);
+
+    FileLocationsTable[(u32)FileLocation::Diagnostic].location = FileLocation::Diagnostic;
+    FormatString(FileLocationsTable[(u32)FileLocation::Diagnostic].szFolder, LINUX_STATE_FILE_NAME_COUNT, "%s", state.EXEFolder);
+}
+
+inline internal u64
+LinuxGetWallClock()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000ull + (u64)now.tv_nsec;
+}
+
+inline internal real32
+LinuxGetElapsedTime(u64 start, u64 end)
+{
+    return (real32)(end - start) / 1000000000.0f;
+}
+
+inline bool32
+LinuxIsInLoop(linux_state& state)
+{
+    // TODO(james): input recording/playback for windowed mode
+    return false;
+}
+
+//------------------------
+//---- MEMORY
+//------------------------
+
+#if PROJECTSUPER_INTERNAL
+internal debug_platform_memory_stats
+LinuxGetMemoryStats()
+{
+    debug_platform_memory_stats stats = {};
+
+    BeginTicketMutex(&GlobalLinuxState.memoryMutex);
+    linux_memory_block* sentinal = &GlobalLinuxState.memorySentinal;
+    for(linux_memory_block* block = sentinal->next; block != sentinal; block = block->next)
+    {
+        // make sure we don't have any obviously bad allocations
+        ASSERT(block->block.size <= U32MAX);
+
+        stats.totalSize += block->block.size;
+        ++stats.blockCount;
+        stats.totalUsed += block->block.used;
+    }
+    stats.cachedSize = GlobalLinuxState.blockCacheSize;
+    stats.cachedBlockCount = GlobalLinuxState.blockCacheCount;
+    stats.cacheHits = GlobalLinuxState.blockCacheHits;
+    stats.cacheMisses = GlobalLinuxState.blockCacheMisses;
+    stats.peakSize = GlobalLinuxState.peakBlockSize;
+    EndTicketMutex(&GlobalLinuxState.memoryMutex);
+
+    return stats;
+}
+#endif
+
+internal void
+LinuxQueryPageSizes(linux_state& state)
+{
+    state.pageSize = (umm)sysconf(_SC_PAGESIZE);
+    state.largePageSize = 0;
+
+    int fd = open("/proc/meminfo", O_RDONLY);
+    if(fd >= 0)
+    {
+        char buffer[8192];
+        ssize_t bytesRead = read(fd, buffer, sizeof(buffer) - 1);
+        close(fd);
+
+        if(bytesRead > 0)
+        {
+            buffer[bytesRead] = 0;
+            const char* hugePageSize = strstr(buffer, "Hugepagesize:");
+            if(hugePageSize)
+            {
+                state.largePageSize = (umm)strtoull(hugePageSize + StringLength("Hugepagesize:"), 0, 10) * 1024;
+            }
+        }
+    }
+}
+
+// NOTE(james): a real hugetlb mapping needs pages set aside in /proc/sys/vm/nr_hugepages,
+// so most of the time this ends up as an aligned mapping asking for transparent huge pages
+internal void*
+LinuxMapLargePages(umm& totalSize, b32 isReserveOnly)
+{
+    umm largePageSize = GlobalLinuxState.largePageSize;
+    totalSize = AlignPow2(totalSize, largePageSize);
+    int protection = isReserveOnly ? PROT_NONE : PROT_READ|PROT_WRITE;
+
+    // hugetlb pages can't be committed a bit at a time, so reservations skip straight to THP
+    if(!isReserveOnly)
+    {
+        void* result = mmap(0, totalSize, protection, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+        if(result != MAP_FAILED)
+        {
+            return result;
+        }
+    }
+
+    // over-map so the block can start on a large page boundary, then trim the ends
+    int mapFlags = MAP_PRIVATE|MAP_ANONYMOUS|(isReserveOnly ? MAP_NORESERVE : 0);
+    u8* mapping = (u8*)mmap(0, totalSize + largePageSize, protection, mapFlags, -1, 0);
+    if(mapping == MAP_FAILED)
+    {
+        return 0;
+    }
+
+    u8* aligned = (u8*)AlignPow2((umm)mapping, largePageSize);
+    u8* mappingEnd = mapping + totalSize + largePageSize;
+    if(aligned > mapping)
+    {
+        munmap(mapping, aligned - mapping);
+    }
+    if(mappingEnd > aligned + totalSize)
+    {
+        munmap(aligned + totalSize, mappingEnd - (aligned + totalSize));
+    }
+
+    // NOTE(james): failing this just means the kernel has THP turned off
+    madvise(aligned, totalSize, MADV_HUGEPAGE);
+    return aligned;
+}
+
+inline b32
+LinuxIsCacheableBlock(PlatformMemoryFlags flags)
+{
+    // NOTE(james): guard pages, reservations and large pages are laid out for one particular size
+    return IS_FLAG_BIT_NOT_SET(flags, PlatformMemoryFlags::OverflowCheck|PlatformMemoryFlags::UnderflowCheck|PlatformMemoryFlags::ReserveOnly|PlatformMemoryFlags::LargePages);
+}
+
+inline s32
+LinuxBlockCacheBucket(umm totalSize)
+{
+    if(totalSize > ((umm)1 << (LINUX_BLOCK_CACHE_MIN_SHIFT + LINUX_BLOCK_CACHE_BUCKET_COUNT - 1)))
+    {
+        return -1;
+    }
+    if(totalSize <= ((umm)1 << LINUX_BLOCK_CACHE_MIN_SHIFT))
+    {
+        return 0;
+    }
+
+    bit_scan_result scan = FindMostSignificantSetBit((u32)(totalSize - 1));
+    return (s32)scan.Index + 1 - LINUX_BLOCK_CACHE_MIN_SHIFT;
+}
+
+// NOTE(james): the memory mutex has to be held
+internal b32
+LinuxCacheMemoryBlock(linux_state& state, linux_memory_block* block)
+{
+    if(!LinuxIsCacheableBlock(block->block.flags))
+    {
+        return false;
+    }
+
+    s32 bucket = LinuxBlockCacheBucket(block->totalAllocatedSize);
+    if(bucket < 0 || state.blockCacheSize + block->totalAllocatedSize > state.blockCacheLimit)
+    {
+        return false;
+    }
+
+    block->next = state.blockCache[bucket];
+    block->prev = 0;
+    state.blockCache[bucket] = block;
+    state.blockCacheSize += block->totalAllocatedSize;
+    ++state.blockCacheCount;
+    return true;
+}
+
+internal void
+LinuxSetMemoryBlockCacheLimit(umm size)
+{
+    BeginTicketMutex(&GlobalLinuxState.memoryMutex);
+    GlobalLinuxState.blockCacheLimit = size;
+
+    // hand back the biggest blocks first until we fit again
+    for(s32 bucket = LINUX_BLOCK_CACHE_BUCKET_COUNT - 1;
+        bucket >= 0 && GlobalLinuxState.blockCacheSize > size;
+        --bucket)
+    {
+        while(GlobalLinuxState.blockCache[bucket] && GlobalLinuxState.blockCacheSize > size)
+        {
+            linux_memory_block* block = GlobalLinuxState.blockCache[bucket];
+            GlobalLinuxState.blockCache[bucket] = block->next;
+            GlobalLinuxState.blockCacheSize -= block->totalAllocatedSize;
+            --GlobalLinuxState.blockCacheCount;
+            munmap(block, block->totalAllocatedSize);
+        }
+    }
+    EndTicketMutex(&GlobalLinuxState.memoryMutex);
+}
+
+internal platform_memory_block*
+LinuxAllocateMemoryBlock(memory_index size, PlatformMemoryFlags flags)
+{
+    // NOTE(james): We require memory block headers not to change the cache
+    // line alignment of an allocation
+    CompileAssert(sizeof(linux_memory_block) == 128);
+
+    const umm pageSize = GlobalLinuxState.pageSize;
+    umm totalSize = size + sizeof(linux_memory_block);
+    umm baseOffset = sizeof(linux_memory_block);
+    umm protectOffset = 0;
+    if(IS_FLAG_BIT_SET(flags, PlatformMemoryFlags::UnderflowCheck))
+    {
+        totalSize = size + 2*pageSize;
+        baseOffset = 2*pageSize;
+        protectOffset = pageSize;
+    }
+    else if(IS_FLAG_BIT_SET(flags, PlatformMemoryFlags::OverflowCheck))
+    {
+        umm sizeRoundedUp = AlignPow2(size, pageSize);
+        totalSize = sizeRoundedUp + 2*pageSize;
+        baseOffset = pageSize + sizeRoundedUp - size;
+        protectOffset = pageSize + sizeRoundedUp;
+    }
+
+    b32 isReserveOnly = IS_FLAG_BIT_SET(flags, PlatformMemoryFlags::ReserveOnly);
+    ASSERT(!isReserveOnly || !IS_ANY_FLAG_SET(flags, PlatformMemoryFlags::OverflowCheck|PlatformMemoryFlags::UnderflowCheck));
+
+    if(IS_FLAG_BIT_SET(flags, PlatformMemoryFlags::LargePages) &&
+       (IS_ANY_FLAG_SET(flags, PlatformMemoryFlags::OverflowCheck|PlatformMemoryFlags::UnderflowCheck) ||
+        GlobalLinuxState.largePageSize <= pageSize))
+    {
+        // guard pages only work with normal pages
+        flags &= ~PlatformMemoryFlags::LargePages;
+    }
+
+    linux_memory_block *block = 0;
+    s32 cacheBucket = LinuxIsCacheableBlock(flags) ? LinuxBlockCacheBucket(totalSize) : -1;
+    if(cacheBucket >= 0)
+    {
+        // NOTE(james): cached blocks map the whole bucket so any of them fits any request in it
+        totalSize = (umm)1 << (cacheBucket + LINUX_BLOCK_CACHE_MIN_SHIFT);
+
+        BeginTicketMutex(&GlobalLinuxState.memoryMutex);
+        block = GlobalLinuxState.blockCache[cacheBucket];
+        if(block)
+        {
+            GlobalLinuxState.blockCache[cacheBucket] = block->next;
+            GlobalLinuxState.blockCacheSize -= block->totalAllocatedSize;
+            --GlobalLinuxState.blockCacheCount;
+            ++GlobalLinuxState.blockCacheHits;
+        }
+        else
+        {
+            ++GlobalLinuxState.blockCacheMisses;
+        }
+        EndTicketMutex(&GlobalLinuxState.memoryMutex);
+    }
+
+    if(block)
+    {
+        // NOTE(james): only the header is reset, the contents are whatever the last owner left
+        ZeroStruct(block->block);
+    }
+    else if(IS_FLAG_BIT_SET(flags, PlatformMemoryFlags::LargePages))
+    {
+        block = (linux_memory_block*)LinuxMapLargePages(totalSize, isReserveOnly);
+        if(!block)
+        {
+            LOG_ERROR("LinuxAllocateMemoryBlock: mmap error: %d  %s", errno, strerror(errno));
+            ASSERT(false);
+        }
+    }
+    else
+    {
+        // NOTE(james): anonymous mappings come back zeroed, same as VirtualAlloc
+        int protection = isReserveOnly ? PROT_NONE : PROT_READ|PROT_WRITE;
+        int mapFlags = MAP_PRIVATE|MAP_ANONYMOUS|(isReserveOnly ? MAP_NORESERVE : 0);
+        block = (linux_memory_block*)mmap(0, totalSize, protection, mapFlags, -1, 0);
+        if(block == MAP_FAILED)
+        {
+            LOG_ERROR("LinuxAllocateMemoryBlock: mmap error: %d  %s", errno, strerror(errno));
+            ASSERT(false);
+        }
+    }
+
+    umm committed = size;
+    if(isReserveOnly)
+    {
+        // only the page holding the header is usable until the arena asks for more
+        if(mprotect(block, pageSize, PROT_READ|PROT_WRITE) != 0)
+        {
+            LOG_ERROR("LinuxAllocateMemoryBlock: commit error: %d  %s", errno, strerror(errno));
+            ASSERT(false);
+        }
+        committed = Minimum(size, pageSize - baseOffset);
+    }
+
+    block->totalAllocatedSize = totalSize;
+    block->block.base = (u8 *)block + baseOffset;
+    block->block.committed = committed;
+    ASSERT(block->block.used == 0);
+    ASSERT(block->block.prev_block == 0);
+
+    if(IS_FLAG_BIT_SET(flags, PlatformMemoryFlags::OverflowCheck) || IS_FLAG_BIT_SET(flags, PlatformMemoryFlags::UnderflowCheck))
+    {
+        int result = mprotect((u8 *)block + protectOffset, pageSize, PROT_NONE);
+        if(result != 0)
+        {
+            LOG_ERROR("LinuxAllocateMemoryBlock: mprotect error: %d  %s", errno, strerror(errno));
+            ASSERT(false);
+        }
+    }
+
+    linux_memory_block *sentinel = &GlobalLinuxState.memorySentinal;
+    block->next = sentinel;
+    block->block.size = size;
+    block->block.flags = flags;
+    block->loopingFlags = MemoryLoopingFlags::None;
+    if(LinuxIsInLoop(GlobalLinuxState) && IS_FLAG_BIT_NOT_SET(flags, PlatformMemoryFlags::NotRestored))
+    {
+        block->loopingFlags = MemoryLoopingFlags::Allocated;
+    }
+
+    BeginTicketMutex(&GlobalLinuxState.memoryMutex);
+    block->prev = sentinel->prev;
+    block->prev->next = block;
+    block->next->prev = block;
+    GlobalLinuxState.liveBlockSize += block->block.size;
+    GlobalLinuxState.peakBlockSize = Maximum(GlobalLinuxState.peakBlockSize, GlobalLinuxState.liveBlockSize);
+    EndTicketMutex(&GlobalLinuxState.memoryMutex);
+
+    platform_memory_block *platformBlock = &block->block;
+    return platformBlock;
+}
+
+internal b32
+LinuxCommitMemoryBlock(platform_memory_block* block, umm size)
+{
+    if(size <= block->committed)
+    {
+        return true;
+    }
+    if(size > block->size)
+    {
+        return false;
+    }
+
+    // NOTE(james): commit in big steps so a growing arena isn't a syscall per push
+    umm commitGranularity = Kilobytes(64);
+    if(IS_FLAG_BIT_SET(block->flags, PlatformMemoryFlags::LargePages))
+    {
+        commitGranularity = Maximum(commitGranularity, GlobalLinuxState.largePageSize);
+    }
+    linux_memory_block *linuxBlock = (linux_memory_block *)block;
+    u8* commitStart = block->base + block->committed;
+    u8* commitEnd = (u8 *)linuxBlock + Minimum(AlignPow2((umm)(block->base + size - (u8 *)linuxBlock), commitGranularity), linuxBlock->totalAllocatedSize);
+
+    // the committed end always sits on a page boundary except for the header page
+    u8* protectStart = (u8 *)AlignPow2((umm)commitStart, GlobalLinuxState.pageSize);
+    if(mprotect(protectStart, commitEnd - protectStart, PROT_READ|PROT_WRITE) != 0)
+    {
+        LOG_ERROR("LinuxCommitMemoryBlock: mprotect error: %d  %s", errno, strerror(errno));
+        return false;
+    }
+
+    block->committed = Minimum((umm)(commitEnd - block->base), block->size);
+    return true;
+}
+
+internal void
+LinuxFreeMemoryBlock(linux_memory_block *block)
+{
+    BeginTicketMutex(&GlobalLinuxState.memoryMutex);
+    block->prev->next = block->next;
+    block->next->prev = block->prev;
+    GlobalLinuxState.liveBlockSize -= block->block.size;
+    b32 cached = LinuxCacheMemoryBlock(GlobalLinuxState, block);
+    EndTicketMutex(&GlobalLinuxState.memoryMutex);
+
+    if(!cached && munmap(block, block->totalAllocatedSize) != 0)
+    {
+        LOG_ERROR("LinuxFreeMemoryBlock: munmap error: %d  %s", errno, strerror(errno));
+        ASSERT(false);
+    }
+}
+
+internal void
+LinuxDeallocateMemoryBlock(platform_memory_block* block)
+{
+    if(block)
+    {
+        linux_memory_block *linuxBlock = ((linux_memory_block *)block);
+        if(LinuxIsInLoop(GlobalLinuxState) && IS_FLAG_BIT_NOT_SET(linuxBlock->block.flags, PlatformMemoryFlags::NotRestored))
+        {
+            linuxBlock->loopingFlags = MemoryLoopingFlags::Deallocated;
+        }
+        else
+        {
+            LinuxFreeMemoryBlock(linuxBlock);
+        }
+    }
+}
+
+internal platform_mirrored_memory
+LinuxAllocateMirroredMemory(umm size)
+{
+    platform_mirrored_memory result = {};
+    size = AlignPow2(size, GlobalLinuxState.pageSize);
+
+    // NOTE(james): the pages have to belong to something we can map twice, so they
+    // live in an anonymous memfd instead of a private anonymous mapping
+    int fd = memfd_create("ps_mirrored", MFD_CLOEXEC);
+    if(fd < 0)
+    {
+        LOG_ERROR("LinuxAllocateMirroredMemory: memfd_create error: %d  %s", errno, strerror(errno));
+        return result;
+    }
+
+    if(ftruncate(fd, size) == 0)
+    {
+        // reserve room for both copies first so nothing else can land in the second half
+        u8* base = (u8*)mmap(0, 2*size, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+        if(base != MAP_FAILED)
+        {
+            if(mmap(base, size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, fd, 0) != MAP_FAILED &&
+               mmap(base + size, size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, fd, 0) != MAP_FAILED)
+            {
+                result.base = base;
+                result.size = size;
+            }
+            else
+            {
+                LOG_ERROR("LinuxAllocateMirroredMemory: mmap error: %d  %s", errno, strerror(errno));
+                munmap(base, 2*size);
+            }
+        }
+        else
+        {
+            LOG_ERROR("LinuxAllocateMirroredMemory: mmap error: %d  %s", errno, strerror(errno));
+        }
+    }
+    else
+    {
+        LOG_ERROR("LinuxAllocateMirroredMemory: ftruncate error: %d  %s", errno, strerror(errno));
+    }
+
+    // the mappings keep the pages alive on their own
+    close(fd);
+
+    return result;
+}
+
+internal void
+LinuxDeallocateMirroredMemory(platform_mirrored_memory& memory)
+{
+    if(memory.base)
+    {
+        if(munmap(memory.base, 2*memory.size) != 0)
+        {
+            LOG_ERROR("LinuxDeallocateMirroredMemory: munmap error: %d  %s", errno, strerror(errno));
+            ASSERT(false);
+        }
+        ZeroStruct(memory);
+    }
+}
+
+//------------------------
+//---- WORK QUEUE
+//------------------------
+
+inline internal void
+LinuxFutexWait(u32 volatile* address, u32 expected)
+{
+    syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, 0, 0, 0);
+}
+
+inline internal void
+LinuxFutexWake(u32 volatile* address, u32 count)
+{
+    syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, count, 0, 0, 0);
+}
+
+internal void
+PlatformSemaphoreSignal(platform_semaphore& semaphore, u32 count)
+{
+    AtomicAddU32(&semaphore.count, count);
+    // NOTE(james): skip the syscall when nobody is asleep, both sides use locked
+    // adds so a waiter that shows up after this read will see the new count
+    if(semaphore.waiters)
+    {
+        LinuxFutexWake(&semaphore.count, count);
+    }
+}
+
+internal void
+PlatformSemaphoreWait(platform_semaphore& semaphore)
+{
+    for(;;)
+    {
+        u32 count = semaphore.count;
+        if(count > 0)
+        {
+            if(AtomicCompareExchangeUInt32(&semaphore.count, count - 1, count) == count)
+            {
+                break;
+            }
+        }
+        else
+        {
+            // NOTE(james): the kernel re-checks the value, so a signal that lands
+            // between the load and the wait just returns immediately
+            AtomicAddU32(&semaphore.waiters, 1);
+            LinuxFutexWait(&semaphore.count, 0);
+            AtomicAddU32(&semaphore.waiters, (u32)-1);
+        }
+    }
+}
+
+internal void
+PlatformYieldThread()
+{
+    sched_yield();
+}
+
+#include "ps_work_queue.h"
+
+// NOTE(james): these are too big to live on the main thread's stack
+global_variable platform_work_queue GlobalHighPriorityQueue;
+global_variable platform_work_queue GlobalLowPriorityQueue;
+
+internal void*
+LinuxThreadProc(void* lpParameter)
+{
+    platform_work_worker *worker = (platform_work_worker *)lpParameter;
+    WorkQueueThreadLoop(worker);
+
+    return 0;
+}
+
+internal void
+LinuxInitWorkQueue(platform_work_queue* queue, u32 numThreads)
+{
+    InitWorkQueueWorkers(queue, numThreads);
+    queue->semaphore.count = 0;
+    queue->semaphore.waiters = 0;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_attr_setstacksize(&attr, Megabytes(1));
+
+    for(u32 threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+    {
+        pthread_t threadId;
+        int result = pthread_create(&threadId, &attr, LinuxThreadProc, queue->workers + threadIndex);
+        ASSERT(result == 0);
+    }
+
+    pthread_attr_destroy(&attr);
+}
+
+//------------------------
+//---- ASYNC FILE IO
+//------------------------
+
+#include "ps_async_file.h"
+
+inline internal int
+LinuxIoUringSetup(u32 entries, io_uring_params* params)
+{
+    return (int)syscall(SYS_io_uring_setup, entries, params);
+}
+
+inline internal int
+LinuxIoUringEnter(int fd, u32 toSubmit, u32 minComplete, u32 flags)
+{
+    return (int)syscall(SYS_io_uring_enter, fd, toSubmit, minComplete, flags, 0, 0);
+}
+
+internal b32
+LinuxInitIoUring(linux_io_uring& ring)
+{
+    ring.fd = -1;
+
+    io_uring_params params = {};
+    int fd = LinuxIoUringSetup(LINUX_IO_URING_ENTRIES, &params);
+    if(fd < 0)
+    {
+        LOG_INFO("io_uring unavailable (%d  %s), async reads will run on the low priority queue", errno, strerror(errno));
+        return false;
+    }
+
+    // NOTE(james): IORING_OP_READ came in with the same kernel as this feature bit, older
+    // rings would fail every read we give them
+    if(!(params.features & IORING_FEAT_RW_CUR_POS))
+    {
+        LOG_INFO("io_uring has no plain reads, async reads will run on the low priority queue");
+        close(fd);
+        return false;
+    }
+
+    ring.sqRingSize = params.sq_off.array + params.sq_entries * sizeof(u32);
+    ring.cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    ring.sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+    // NOTE(james): newer kernels put both rings behind the one mapping
+    b32 singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if(singleMapping)
+    {
+        ring.sqRingSize = Maximum(ring.sqRingSize, ring.cqRingSize);
+        ring.cqRingSize = ring.sqRingSize;
+    }
+
+    ring.sqRing = mmap(0, ring.sqRingSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    ring.cqRing = singleMapping ? ring.sqRing :
+        mmap(0, ring.cqRingSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    void* sqes = mmap(0, ring.sqesSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_SQES);
+
+    if(ring.sqRing == MAP_FAILED || ring.cqRing == MAP_FAILED || sqes == MAP_FAILED)
+    {
+        LOG_ERROR("io_uring ring mapping failed: %d  %s", errno, strerror(errno));
+        if(sqes != MAP_FAILED) munmap(sqes, ring.sqesSize);
+        if(!singleMapping && ring.cqRing != MAP_FAILED) munmap(ring.cqRing, ring.cqRingSize);
+        if(ring.sqRing != MAP_FAILED) munmap(ring.sqRing, ring.sqRingSize);
+        close(fd);
+        return false;
+    }
+
+    u8* sqBase = (u8*)ring.sqRing;
+    ring.sqHead = (u32 volatile*)(sqBase + params.sq_off.head);
+    ring.sqTail = (u32 volatile*)(sqBase + params.sq_off.tail);
+    ring.sqMask = *(u32*)(sqBase + params.sq_off.ring_mask);
+    ring.sqEntries = params.sq_entries;
+    ring.sqArray = (u32*)(sqBase + params.sq_off.array);
+    ring.sqes = (io_uring_sqe*)sqes;
+    ring.sqPending = 0;
+
+    u8* cqBase = (u8*)ring.cqRing;
+    ring.cqHead = (u32 volatile*)(cqBase + params.cq_off.head);
+    ring.cqTail = (u32 volatile*)(cqBase + params.cq_off.tail);
+    ring.cqMask = *(u32*)(cqBase + params.cq_off.ring_mask);
+    ring.cqes = (io_uring_cqe*)(cqBase + params.cq_off.cqes);
+
+    ring.fd = fd;
+    return true;
+}
+
+internal void
+PlatformAsyncReadSubmit()
+{
+    linux_io_uring& ring = GlobalLinuxState.ioUring;
+
+    while(ring.sqPending)
+    {
+        int submitted = LinuxIoUringEnter(ring.fd, ring.sqPending, 0, 0);
+        if(submitted > 0)
+        {
+            ring.sqPending -= submitted;
+        }
+        else if(submitted < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY))
+        {
+            continue;
+        }
+        else
+        {
+            // NOTE(james): nothing reaps with a submit, so anything left in the ring would
+            // never complete.  The kernel hasn't looked past its head, so take those reads
+            // back out of the ring and do them here instead.
+            LOG_ERROR("io_uring submit failed, reading %u synchronously: %d  %s", ring.sqPending, errno, strerror(errno));
+            u32 head = AtomicLoadAcquireU32(ring.sqHead);
+            u32 tail = *ring.sqTail;
+            for(u32 position = head; position != tail; ++position)
+            {
+                io_uring_sqe* sqe = ring.sqes + ring.sqArray[position & ring.sqMask];
+                platform_async_read* read = (platform_async_read*)(umm)sqe->user_data;
+                u64 bytesRead = PlatformReadFileAt(read->file, read->offset, read->size, read->dest);
+                AsyncReadComplete(read, bytesRead);
+            }
+            AtomicStoreReleaseU32(ring.sqTail, head);
+            ring.sqPending = 0;
+        }
+    }
+}
+
+internal void
+PlatformAsyncReadStart(platform_async_read* read, platform_file& file)
+{
+    linux_io_uring& ring = GlobalLinuxState.ioUring;
+
+    // NOTE(james): we're the only producer, the kernel only ever moves the head
+    u32 tail = *ring.sqTail;
+    if(tail - AtomicLoadAcquireU32(ring.sqHead) == ring.sqEntries)
+    {
+        // a big batch can fill the ring before it gets submitted, so push out what we have
+        PlatformAsyncReadSubmit();
+        // a failed submit takes its entries back out, so the tail may have moved
+        tail = *ring.sqTail;
+        if(tail - AtomicLoadAcquireU32(ring.sqHead) == ring.sqEntries)
+        {
+            u64 bytesRead = PlatformReadFileAt(read->file, read->offset, read->size, read->dest);
+            AsyncReadComplete(read, bytesRead);
+            return;
+        }
+    }
+
+    u32 index = tail & ring.sqMask;
+    io_uring_sqe* sqe = ring.sqes + index;
+    ZeroStruct(*sqe);
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = (int)(umm)read->file.platform;
+    sqe->off = read->offset;
+    sqe->addr = (u64)(umm)read->dest;
+    sqe->len = (u32)read->size;
+    sqe->user_data = (u64)(umm)read;
+
+    ring.sqArray[index] = index;
+    AtomicStoreReleaseU32(ring.sqTail, tail + 1);
+    ++ring.sqPending;
+}
+
+internal void
+PlatformAsyncReadReap(b32 wait)
+{
+    linux_io_uring& ring = GlobalLinuxState.ioUring;
+
+    u32 head = *ring.cqHead;
+    u32 tail = AtomicLoadAcquireU32(ring.cqTail);
+    if(head == tail && wait)
+    {
+        // NOTE(james): an interrupted wait just comes back empty and the caller loops
+        LinuxIoUringEnter(ring.fd, 0, 1, IORING_ENTER_GETEVENTS);
+        tail = AtomicLoadAcquireU32(ring.cqTail);
+    }
+
+    while(head != tail)
+    {
+        io_uring_cqe* cqe = ring.cqes + (head & ring.cqMask);
+        platform_async_read* read = (platform_async_read*)(umm)cqe->user_data;
+
+        u64 bytesRead = 0;
+        if(cqe->res >= 0)
+        {
+            bytesRead = (u64)cqe->res;
+        }
+        else
+        {
+            LOG_ERROR("io_uring read failed: %d  %s", -cqe->res, strerror(-cqe->res));
+        }
+
+        // NOTE(james): buffered reads only come up short at the end of the file, but a
+        // short read from anywhere else gets finished off the slow way
+        if(bytesRead && bytesRead < read->size && read->offset + bytesRead < read->file.size)
+        {
+            bytesRead += PlatformReadFileAt(read->file, read->offset + bytesRead, read->size - bytesRead, (u8*)read->dest + bytesRead);
+        }
+
+        AsyncReadComplete(read, bytesRead);
+        ++head;
+    }
+
+    AtomicStoreReleaseU32(ring.cqHead, head);
+}
+
+internal u64
+PlatformReadFileAt(platform_file& file, u64 offset, u64 size, void* dest)
+{
+    u64 amountRead = 0;
+    int fd = (int)(umm)file.platform;
+
+    // pread can return short counts too
+    while(amountRead < size)
+    {
+        ssize_t bytesRead = pread(fd, (u8*)dest + amountRead, size - amountRead, offset + amountRead);
+        if(bytesRead > 0)
+        {
+            amountRead += bytesRead;
+        }
+        else if(bytesRead == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            if(bytesRead == -1)
+            {
+                LOG_ERROR("PlatformReadFileAt: read error: %d  %s", errno, strerror(errno));
+            }
+            break;
+        }
+    }
+
+    return amountRead;
+}
+
+//------------------------
+//---- AUDIO
+//------------------------
+
+internal void
+LinuxInitHeadlessSound(linux_audio_context& audio, real32 targetFrameRateSeconds)
+{
+    AudioContextDesc& desc = audio.gameAudioBuffer.descriptor;
+    desc.samplesPerSecond = 48000;
+    desc.numChannels = 2;
+    desc.bitsPerSample = 16;
+
+    // NOTE(james): size the stream the same way the win32 device buffer is,
+    // one full second is plenty to cover any frame hitch
+    buffer& audioBuffer = audio.gameAudioBuffer.streamBuffer;
+    audioBuffer.size = desc.samplesPerSecond * desc.numChannels * desc.bitsPerSample / 8;
+    audioBuffer.data = (u8*)mmap(0, audioBuffer.size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    ASSERT(audioBuffer.data != MAP_FAILED);
+
+    audio.gameAudioBuffer.samplesRequested = (uint32)(targetFrameRateSeconds * desc.samplesPerSecond);
+}
+
+internal void
+LinuxCopyAudioBuffer(linux_audio_context& audio, real32 fFrameTimeStep)
+{
+    const AudioContextDesc& desc = audio.gameAudioBuffer.descriptor;
+
+    // NOTE(james): there is no device to hand this to, so the samples are
+    // just consumed at the rate the game produces them
+    audio.samplesDiscarded += audio.gameAudioBuffer.samplesWritten;
+
+    u32 maxSamples = (u32)(audio.gameAudioBuffer.streamBuffer.size / (desc.numChannels * desc.bitsPerSample / 8));
+    audio.gameAudioBuffer.samplesRequested = Minimum((uint32)(fFrameTimeStep * desc.samplesPerSecond), maxSamples);
+    audio.gameAudioBuffer.samplesWritten = 0;
+}
+
+//------------------------
+//---- MAIN LOOP
+//------------------------
+
+internal void
+LinuxHandleSignal(int signal)
+{
+    GlobalRunning = false;
+}
+
+int
+main(int argc, char** argv)
+{
+    GlobalLinuxState.isHeadless = true;
+    u64 maxFrameCount = 0;
+    u32 targetFrameRate = 60;
+
+    for(int argIndex = 1; argIndex < argc; ++argIndex)
+    {
+        const char* arg = argv[argIndex];
+        if(strcmp(arg, "--headless") == 0)
+        {
+            GlobalLinuxState.isHeadless = true;
+        }
+        else if(strcmp(arg, "--frames") == 0 && argIndex + 1 < argc)
+        {
+            maxFrameCount = strtoull(argv[++argIndex], 0, 10);
+        }
+        else if(strcmp(arg, "--fps") == 0 && argIndex + 1 < argc)
+        {
+            targetFrameRate = (u32)strtoul(argv[++argIndex], 0, 10);
+        }
+    }
+
+    // TODO(james): Windowed mode (xcb + vulkan surface), for now everything runs headless
+    ASSERT(GlobalLinuxState.isHeadless);
+
+    signal(SIGINT, LinuxHandleSignal);
+    signal(SIGTERM, LinuxHandleSignal);
+
+    // NOTE(james): Initialize sentinal to point to itself to establish the memory ring
+    linux_memory_block* sentinal = &GlobalLinuxState.memorySentinal;
+    sentinal->next = sentinal;
+    sentinal->prev = sentinal;
+    GlobalLinuxState.blockCacheLimit = LINUX_BLOCK_CACHE_DEFAULT_LIMIT;
+    LinuxQueryPageSizes(GlobalLinuxState);
+
+    LinuxInitWorkQueue(&GlobalHighPriorityQueue, 8);
+    LinuxInitWorkQueue(&GlobalLowPriorityQueue, 2);
+
+    b32 hasIoUring = LinuxInitIoUring(GlobalLinuxState.ioUring);
+    InitAsyncFileIO(hasIoUring ? 0 : &GlobalLowPriorityQueue);
+
+    LinuxGetExecutablePath(GlobalLinuxState);
+    LinuxSetupFileLocationsTable(GlobalLinuxState);
+    LinuxInitFileWatcher(GlobalLinuxState.fileWatcher);
+
+    game_memory gameMemory = {};
+    graphics_context gameGraphics = {};
+
+    gameMemory.highPriorityQueue = &GlobalHighPriorityQueue;
+    gameMemory.lowPriorityQueue = &GlobalLowPriorityQueue;
+
+    gameMemory.platformApi.Log = &LinuxLog;
+    gameMemory.platformApi.AddWorkEntry = &AddWorkQueueEntry;
+    gameMemory.platformApi.CompleteAllWork = &CompleteAllWorkQueueWork;
+    gameMemory.platformApi.AddCountedWorkEntry = &AddCountedWorkQueueEntry;
+    gameMemory.platformApi.CompleteCounterWork = &CompleteCounterWork;
+    gameMemory.platformApi.AddWorkBatch = &AddWorkQueueBatch;
+    gameMemory.platformApi.WaitForWork = &WaitForWorkQueueBatch;
+    gameMemory.platformApi.IsWorkComplete = &IsWorkQueueBatchComplete;
+    gameMemory.platformApi.AllocateMemoryBlock = &LinuxAllocateMemoryBlock;
+    gameMemory.platformApi.DeallocateMemoryBlock = &LinuxDeallocateMemoryBlock;
+    gameMemory.platformApi.CommitMemoryBlock = &LinuxCommitMemoryBlock;
+    gameMemory.platformApi.SetMemoryBlockCacheLimit = &LinuxSetMemoryBlockCacheLimit;
+    gameMemory.platformApi.AllocateMirroredMemory = &LinuxAllocateMirroredMemory;
+    gameMemory.platformApi.DeallocateMirroredMemory = &LinuxDeallocateMirroredMemory;
+    gameMemory.platformApi.OpenFile = &LinuxOpenFile;
+    gameMemory.platformApi.ReadFile = &LinuxReadFile;
+    gameMemory.platformApi.WriteFile = &LinuxWriteFile;
+    gameMemory.platformApi.CloseFile = &LinuxCloseFile;
+    gameMemory.platformApi.MapFile = &LinuxMapFile;
+    gameMemory.platformApi.UnmapFile = &LinuxUnmapFile;
+    gameMemory.platformApi.ListFiles = &LinuxListFiles;
+    gameMemory.platformApi.WatchDirectory = &LinuxWatchDirectory;
+    gameMemory.platformApi.UnwatchDirectory = &LinuxUnwatchDirectory;
+    gameMemory.platformApi.GetFileChanges = &LinuxGetFileChanges;
+    gameMemory.platformApi.ReadFileAsync = &ReadFileAsync;
+    gameMemory.platformApi.ReadFileAsyncBatch = &ReadFileAsyncBatch;
+    gameMemory.platformApi.IsFileReadComplete = &IsFileReadComplete;
+    gameMemory.platformApi.WaitForFileRead = &WaitForFileRead;
+
+#if PROJECTSUPER_INTERNAL
+    gameMemory.platformApi.DEBUG_GetMemoryStats = &LinuxGetMemoryStats;
+    gameMemory.platformApi.DEBUG_Log = &LinuxDebugLog;
+#endif
+
+    Platform = gameMemory.platformApi;
+
+#if TEST_COLLECTIONS
+    {
+        b32 passed = TestCollections(&GlobalHighPriorityQueue);
+        passed &= TestWorkQueue(&GlobalHighPriorityQueue);
+        passed &= TestStreams(&GlobalHighPriorityQueue);
+        ASSERT(passed);
+    }
+#endif
+
+#if BENCH_COLLECTIONS
+    BenchSort();
+    BenchParallelSort(&GlobalHighPriorityQueue);
+#endif
+
+    real32 targetFrameRateSeconds = 1.0f / (real32)targetFrameRate;
+
+    gameGraphics.gfx = LinuxLoadHeadlessGraphics();
+    gameGraphics.windowWidth = FIXED_RENDER_WIDTH;
+    gameGraphics.windowHeight = FIXED_RENDER_HEIGHT;
+
+    linux_audio_context audio = {};
+    LinuxInitHeadlessSound(audio, targetFrameRateSeconds);
+
+    InputContext input = {};
+
+    linux_game_function_table gameFunctions = {};
+    linux_loaded_code gameCode = {};
+    gameCode.pszSOName = "ps_game.so";
+    gameCode.pszTransientSOName = "ps_game_temp.so";
+    gameCode.nFunctionCount = ARRAY_COUNT(LinuxGameFunctionTableNames);
+    gameCode.ppFunctions = (void**)&gameFunctions;
+    gameCode.ppszFunctionNames = (char**)&LinuxGameFunctionTableNames;
+
+    LinuxLoadCode(GlobalLinuxState, gameCode);
+    ASSERT(gameCode.isValid);
+
+    char szSourceLibraryPath[LINUX_STATE_FILE_NAME_COUNT] = {};
+    FormatString(szSourceLibraryPath, LINUX_STATE_FILE_NAME_COUNT, "%s%s", GlobalLinuxState.EXEFolder, gameCode.pszSOName);
+
+    LOG_INFO("Running headless at %u fps for %llu frames (0 = until signalled)", targetFrameRate, maxFrameCount);
+
+    u64 runStartTime = LinuxGetWallClock();
+    real32 worstFrameTime = 0.0f;
+
+    while(GlobalRunning)
+    {
+        time_t lastWriteTime = LinuxGetFileWriteTime(szSourceLibraryPath);
+        if(lastWriteTime != gameCode.lastFileWriteTime)
+        {
+            LinuxUnloadCode(gameCode);
+            LinuxLoadCode(GlobalLinuxState, gameCode);
+        }
+
+        // NOTE(james): headless has no devices, so the keyboard reads as connected
+        // with nothing pressed to keep the game input paths identical
+        InputController keyboard = {};
+        keyboard.isConnected = true;
+        keyboard.isAnalog = false;
+        input.controllers[0] = keyboard;
+
+        u64 frameStartTime = LinuxGetWallClock();
+
+        if(gameFunctions.GameUpdateAndRender)
+        {
+            gameFunctions.GameUpdateAndRender(gameMemory, gameGraphics, input, audio.gameAudioBuffer);
+        }
+
+        real32 gameSimTime = LinuxGetElapsedTime(frameStartTime, LinuxGetWallClock());
+        worstFrameTime = Maximum(worstFrameTime, gameSimTime);
+
+        // NOTE(james): headless runs as fast as it can so perf runs measure the
+        // frame cost, but the clock still advances at the target rate so the
+        // simulation steps match a real run
+        input.clock.totalTime += targetFrameRateSeconds;
+        input.clock.elapsedFrameTime = targetFrameRateSeconds;
+
+        LinuxCopyAudioBuffer(audio, targetFrameRateSeconds);
+
+        ++input.clock.frameCounter;
+
+        if(maxFrameCount && input.clock.frameCounter >= maxFrameCount)
+        {
+            GlobalRunning = false;
+        }
+    }
+
+    real32 totalRunTime = LinuxGetElapsedTime(runStartTime, LinuxGetWallClock());
+    LOG_INFO("Ran %llu frames in %.3f s (%.3f ms/frame avg, %.3f ms worst), %llu audio samples",
+             input.clock.frameCounter, totalRunTime,
+             input.clock.frameCounter ? (totalRunTime * 1000.0f) / (real32)input.clock.frameCounter : 0.0f,
+             worstFrameTime * 1000.0f, audio.samplesDiscarded);
+
+    LinuxUnloadCode(gameCode);
+
+    return 0;
+}
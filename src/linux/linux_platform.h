@@ -0,0 +1,182 @@
+
+#define LINUX_STATE_FILE_NAME_COUNT PATH_MAX
+
+struct linux_file_location
+{
+    FileLocation location;
+    char szFolder[LINUX_STATE_FILE_NAME_COUNT];
+};
+
+struct linux_loaded_code
+{
+    b32x isValid;
+
+    const char* pszSOName;
+    const char* pszTransientSOName;
+
+    void* hSO;
+    time_t lastFileWriteTime;
+
+    u32 nFunctionCount;
+    char** ppszFunctionNames;
+    void** ppFunctions;
+};
+
+struct linux_game_function_table
+{
+    game_update_and_render* GameUpdateAndRender;
+};
+global_variable const char* LinuxGameFunctionTableNames[] = {
+    "GameUpdateAndRender"
+};
+
+enum class MemoryLoopingFlags
+{
+    None,
+    Allocated   = 0x1,
+    Deallocated = 0x2
+};
+MAKE_ENUM_FLAG(u32, MemoryLoopingFlags);
+
+struct linux_memory_block
+{
+    platform_memory_block block;
+    linux_memory_block* next;
+    linux_memory_block* prev;
+    MemoryLoopingFlags loopingFlags;
+
+    // NOTE(james): munmap needs the full mapping size, including guard pages
+    u64 totalAllocatedSize;
+    u64 pad[6];
+};
+
+// NOTE(james): freed blocks are kept in power of two buckets of their mapped size,
+// 64 KB up to 64 MB, so the next frame can have them back without a syscall
+#define LINUX_BLOCK_CACHE_MIN_SHIFT 16
+#define LINUX_BLOCK_CACHE_BUCKET_COUNT 11
+#define LINUX_BLOCK_CACHE_DEFAULT_LIMIT Megabytes(64)
+
+#define LINUX_MAX_DIRECTORY_WATCHES 32
+#define LINUX_MAX_INOTIFY_WATCHES 1024
+#define LINUX_WATCH_PATH_COUNT 256
+
+// NOTE(james): inotify only ever watches the one directory, so every directory under a
+// watch gets its own descriptor that remembers where it sits.  The kernel hands back the
+// same descriptor when watches overlap, so each watch keeps its own record of it and it
+// only goes back to the kernel with the last one.
+struct linux_inotify_watch
+{
+    int wd;
+    u32 watchId;
+    FileLocation location;
+    // NOTE(james): relative to the file location, ends in a slash unless it's the root
+    char path[LINUX_WATCH_PATH_COUNT];
+};
+
+struct linux_directory_watch
+{
+    // NOTE(james): zero when the slot is free
+    u32 id;
+    FileLocation location;
+};
+
+struct linux_file_watcher
+{
+    // NOTE(james): -1 when the kernel wouldn't give us an inotify instance
+    int inotifyFd;
+    u32 nextWatchId;
+    linux_directory_watch watches[LINUX_MAX_DIRECTORY_WATCHES];
+
+    u32 inotifyWatchCount;
+    linux_inotify_watch inotifyWatches[LINUX_MAX_INOTIFY_WATCHES];
+
+    // NOTE(james): inotify never says a rename went over an existing file, so every file
+    // seen under a watch is remembered to tell a replace from something new
+    memory_arena arena;
+    hashtable<b32>* knownFiles;
+};
+
+// NOTE(james): the mapped halves of an io_uring, sized for every async read to be in flight
+// at once so the completion ring can never overflow
+#define LINUX_IO_URING_ENTRIES 256
+
+struct linux_io_uring
+{
+    int fd;
+
+    u32 volatile* sqHead;
+    u32 volatile* sqTail;
+    u32 sqMask;
+    u32 sqEntries;
+    u32* sqArray;
+    io_uring_sqe* sqes;
+    // NOTE(james): queued in the ring but not handed to the kernel yet
+    u32 sqPending;
+
+    u32 volatile* cqHead;
+    u32 volatile* cqTail;
+    u32 cqMask;
+    io_uring_cqe* cqes;
+
+    void* sqRing;
+    umm sqRingSize;
+    void* cqRing;
+    umm cqRingSize;
+    umm sqesSize;
+};
+
+// NOTE(james): io_uring hands the read back through user_data, there is nothing else to
+// keep per read
+struct linux_async_read
+{
+    u32 unused;
+};
+typedef linux_async_read platform_async_read_native;
+
+struct linux_state
+{
+    // NOTE(james): To touch the memory sentinal or the block cache, you have to
+    // take a ticket!
+    ticket_mutex memoryMutex;
+    linux_memory_block memorySentinal;
+    // NOTE(james): mapped block bytes handed out right now, and the most there ever were
+    umm liveBlockSize;
+    umm peakBlockSize;
+
+    linux_memory_block* blockCache[LINUX_BLOCK_CACHE_BUCKET_COUNT];
+    umm blockCacheSize;
+    umm blockCacheLimit;
+    u32 blockCacheCount;
+    u64 blockCacheHits;
+    u64 blockCacheMisses;
+
+    char EXEFolder[LINUX_STATE_FILE_NAME_COUNT];
+    char EXEFilename[LINUX_STATE_FILE_NAME_COUNT];
+
+    b32 isHeadless;
+
+    umm pageSize;
+    // NOTE(james): zero when the kernel doesn't report a huge page size
+    umm largePageSize;
+
+    // NOTE(james): fd is -1 when async reads fall back to the low priority queue
+    linux_io_uring ioUring;
+
+    linux_file_watcher fileWatcher;
+};
+
+struct linux_audio_context
+{
+    AudioContext gameAudioBuffer;
+
+    // TODO(james): Hook up an actual output device (ALSA/Pulse) for windowed mode
+    u64 samplesDiscarded;
+};
+
+// NOTE(james): futex word used as a counting semaphore for sleeping workers
+struct linux_semaphore
+{
+    u32 volatile count;
+    u32 volatile waiters;
+};
+typedef linux_semaphore platform_semaphore;
@@ -56,17 +56,54 @@ struct macos_memory_block
     MemoryLoopingFlags loopingFlags;
 
     u64 totalAllocatedSize;
-    u64 pad[7];
+    u64 pad[6];
+};
+
+#define MACOS_MAX_DIRECTORY_WATCHES 32
+// NOTE(james): GetFileChanges gets called every frame, and a poll is a stat per file
+#define MACOS_WATCH_POLL_INTERVAL_NS 250000000ull
+
+// NOTE(james): a listing of everything under a watch, keyed the same way as file changes
+struct macos_directory_snapshot
+{
+    memory_arena arena;
+    platform_file_list files;
+    hashtable<platform_file_info*>* lookup;
+};
+
+// NOTE(james): there's no FSEvents yet, so a watch keeps what the tree looked like at the
+// last poll and diffs a fresh listing against it.  The two snapshots take turns.
+struct macos_directory_watch
+{
+    // NOTE(james): zero when the slot is free
+    u32 id;
+    FileLocation location;
+    // NOTE(james): relative to the file location, ends in a slash unless it's the root
+    char path[FILENAME_MAX];
+
+    u32 current;
+    macos_directory_snapshot snapshots[2];
+};
+
+struct macos_file_watcher
+{
+    u32 nextWatchId;
+    u64 lastPollTime;
+    macos_directory_watch watches[MACOS_MAX_DIRECTORY_WATCHES];
 };
 
 struct macos_state
 {
     ticket_mutex memoryMutex;
     macos_memory_block memorySentinal;
+    // NOTE(james): mapped block bytes handed out right now, and the most there ever were
+    umm liveBlockSize;
+    umm peakBlockSize;
 
     char appFilename[FILENAME_MAX];
     char appFolder[FILENAME_MAX];
     macos_file_location fileLocationsTable[(u32)FileLocation::LocationsCount];
+    macos_file_watcher fileWatcher;
 
     // TODO(james): setup app delegate
     NSWindow* window;
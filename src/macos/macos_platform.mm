@@ -28,6 +28,8 @@
 #include "../vulkan/vk_platform.cpp"   
 
 #include <sys/mman.h>
+#include <mach/vm_statistics.h>
+#include <mach/mach.h>
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <unistd.h>
@@ -37,6 +39,9 @@
 #include <libproc.h>
 #include <time.h>
 #include <dlfcn.h>
+#include <dirent.h>
+
+#include "ps_file_watch.h"
 
 global_variable bool32 GlobalRunning = true;
 global_variable macos_state GlobalMacosState;
@@ -117,8 +122,10 @@ MacosGetMemoryStats()
         ASSERT(block->block.size <= U32MAX);
 
         stats.totalSize += block->block.size;
+        ++stats.blockCount;
         stats.totalUsed += block->block.used;
     } 
+    stats.peakSize = GlobalMacosState.peakBlockSize;
     EndTicketMutex(&GlobalMacosState.memoryMutex);
 
     return stats;
@@ -139,7 +146,7 @@ MacosAllocateMemoryBlock(memory_index size, PlatformMemoryFlags flags)
     // line alignment of an allocation
     CompileAssert(sizeof(macos_memory_block) == 128);
 
-	const umm pageSize = 4096; // TODO(james): Query from system?
+	const umm pageSize = (umm)getpagesize();
     umm totalSize = size + sizeof(macos_memory_block);
     umm baseOffset = sizeof(macos_memory_block);
     umm protectOffset = 0;
@@ -158,17 +165,53 @@ MacosAllocateMemoryBlock(memory_index size, PlatformMemoryFlags flags)
 		protectOffset = pageSize + sizeRoundedUp;
 	}
 
-	macos_memory_block *block = (macos_memory_block*)mmap(0, totalSize,
-									PROT_READ | PROT_WRITE,
+	b32 isReserveOnly = IS_FLAG_BIT_SET(flags, PlatformMemoryFlags::ReserveOnly);
+	ASSERT(!isReserveOnly || !IS_ANY_FLAG_SET(flags, PlatformMemoryFlags::OverflowCheck|PlatformMemoryFlags::UnderflowCheck));
+
+	macos_memory_block *block = (macos_memory_block*)MAP_FAILED;
+	if(IS_FLAG_BIT_SET(flags, PlatformMemoryFlags::LargePages) && !isReserveOnly &&
+	   !IS_ANY_FLAG_SET(flags, PlatformMemoryFlags::OverflowCheck|PlatformMemoryFlags::UnderflowCheck))
+	{
+		// NOTE(james): superpages only exist on intel macs, the fd slot carries the
+		// vm flags for anonymous mappings.  Anything else falls back to normal pages.
+		umm largeSize = AlignPow2(totalSize, Megabytes(2));
+		block = (macos_memory_block*)mmap(0, largeSize, PROT_READ | PROT_WRITE,
+									MAP_PRIVATE | MAP_ANON,
+									VM_FLAGS_SUPERPAGE_SIZE_2MB, 0);
+		if(block != MAP_FAILED)
+		{
+			totalSize = largeSize;
+		}
+	}
+
+	if(block == MAP_FAILED)
+	{
+		block = (macos_memory_block*)mmap(0, totalSize,
+									isReserveOnly ? PROT_NONE : PROT_READ | PROT_WRITE,
 									MAP_PRIVATE | MAP_ANON,
 									-1, 0);
+	}
 	if(block == MAP_FAILED)
 	{
 		LOG_ERROR("OSXAllocateMemory: mmap error: %d  %s", errno, strerror(errno));
 		ASSERT(false);
 	}
+
+	umm committed = size;
+	if(isReserveOnly)
+	{
+		// only the page holding the header is usable until the arena asks for more
+		if(mprotect(block, pageSize, PROT_READ | PROT_WRITE) != 0)
+		{
+			LOG_ERROR("OSXAllocateMemory: commit error: %d  %s", errno, strerror(errno));
+			ASSERT(false);
+		}
+		committed = Minimum(size, pageSize - baseOffset);
+	}
+
 	block->totalAllocatedSize = totalSize;
 	block->block.base = (u8 *)block + baseOffset;
+	block->block.committed = committed;
 	ASSERT(block->block.used == 0);
 	ASSERT(block->block.prev_block == 0);
 
@@ -176,9 +219,6 @@ MacosAllocateMemoryBlock(memory_index size, PlatformMemoryFlags flags)
 	{
 		int result = mprotect((u8*)block + protectOffset, pageSize, PROT_NONE);
 		if (result != 0)
-		{
-		}
-		else
 		{
 			LOG_ERROR("OSXAllocateMemory: Underflow mprotect error: %d  %s", errno, strerror(errno));
 			ASSERT(false);
@@ -199,18 +239,51 @@ MacosAllocateMemoryBlock(memory_index size, PlatformMemoryFlags flags)
 	block->prev = sentinal->prev;
 	block->prev->next = block;
 	block->next->prev = block;
+	GlobalMacosState.liveBlockSize += block->block.size;
+	GlobalMacosState.peakBlockSize = Maximum(GlobalMacosState.peakBlockSize, GlobalMacosState.liveBlockSize);
 	EndTicketMutex(&GlobalMacosState.memoryMutex);
 	
 	platform_memory_block* platformBlock = &block->block;
 	return platformBlock;
 }
 
+internal b32
+MacosCommitMemoryBlock(platform_memory_block* block, umm size)
+{
+	if(size <= block->committed)
+	{
+		return true;
+	}
+	if(size > block->size)
+	{
+		return false;
+	}
+
+	// NOTE(james): commit in big steps so a growing arena isn't a syscall per push
+	const umm commitGranularity = Kilobytes(64);
+	macos_memory_block *macBlock = (macos_memory_block *)block;
+	u8* commitStart = block->base + block->committed;
+	u8* commitEnd = (u8 *)macBlock + Minimum(AlignPow2((umm)(block->base + size - (u8 *)macBlock), commitGranularity), macBlock->totalAllocatedSize);
+
+	// the committed end always sits on a page boundary except for the header page
+	u8* protectStart = (u8 *)AlignPow2((umm)commitStart, (umm)getpagesize());
+	if(mprotect(protectStart, commitEnd - protectStart, PROT_READ | PROT_WRITE) != 0)
+	{
+		LOG_ERROR("OSXCommitMemoryBlock: mprotect error: %d  %s", errno, strerror(errno));
+		return false;
+	}
+
+	block->committed = Minimum((umm)(commitEnd - block->base), block->size);
+	return true;
+}
+
 internal void
 MacosFreeMemoryBlock(macos_memory_block *block)
 {
 	BeginTicketMutex(&GlobalMacosState.memoryMutex);
 	block->prev->next = block->next;
 	block->next->prev = block->prev;
+	GlobalMacosState.liveBlockSize -= block->block.size;
 	EndTicketMutex(&GlobalMacosState.memoryMutex);
 
 	// NOTE(james): For porting to other platforms that need the size to unmap
@@ -239,6 +312,62 @@ MacosDeallocatedMemoryBlock(platform_memory_block* block)
 	}
 }
 
+internal void
+MacosSetMemoryBlockCacheLimit(umm size)
+{
+	// NOTE(james): freed blocks go straight back to the OS here, there is no
+	// cache to trim yet so any limit is already met
+	(void)size;
+}
+
+internal platform_mirrored_memory
+MacosAllocateMirroredMemory(umm size)
+{
+	platform_mirrored_memory result = {};
+	size = AlignPow2(size, (umm)getpagesize());
+
+	vm_address_t base = 0;
+	kern_return_t kr = vm_allocate(mach_task_self(), &base, 2*size, VM_FLAGS_ANYWHERE);
+	if(kr != KERN_SUCCESS)
+	{
+		LOG_ERROR("MacosAllocateMirroredMemory: vm_allocate error: %d", kr);
+		return result;
+	}
+
+	// NOTE(james): remap the first half over the second one, without copy the new
+	// mapping shares the pages instead of getting its own
+	vm_address_t mirror = base + size;
+	vm_prot_t currentProtection = 0;
+	vm_prot_t maxProtection = 0;
+	kr = vm_remap(mach_task_self(), &mirror, size, 0, VM_FLAGS_FIXED|VM_FLAGS_OVERWRITE,
+				  mach_task_self(), base, FALSE, &currentProtection, &maxProtection, VM_INHERIT_DEFAULT);
+	if(kr != KERN_SUCCESS || mirror != base + size)
+	{
+		LOG_ERROR("MacosAllocateMirroredMemory: vm_remap error: %d", kr);
+		vm_deallocate(mach_task_self(), base, 2*size);
+		return result;
+	}
+
+	result.base = (u8*)base;
+	result.size = size;
+	return result;
+}
+
+internal void
+MacosDeallocateMirroredMemory(platform_mirrored_memory& memory)
+{
+	if(memory.base)
+	{
+		kern_return_t kr = vm_deallocate(mach_task_self(), (vm_address_t)memory.base, 2*memory.size);
+		if(kr != KERN_SUCCESS)
+		{
+			LOG_ERROR("MacosDeallocateMirroredMemory: vm_deallocate error: %d", kr);
+			ASSERT(false);
+		}
+		ZeroStruct(memory);
+	}
+}
+
 internal void
 MacosClearMemoryBlocksByMask(macos_state& state, MemoryLoopingFlags mask)
 {
@@ -396,6 +525,333 @@ MacosCloseFile(platform_file& file)
 	}
 }
 
+internal platform_mapped_file
+MacosMapFile(FileLocation location, const char* filename, FileAccessHint hint)
+{
+	platform_mapped_file result{};
+	result.error = 1;
+
+	char filepath[FILENAME_MAX];
+	FormatString(filepath, FILENAME_MAX, "%s%s", GlobalMacosState.fileLocationsTable[(u32)location].folder, filename);
+
+	int fd = open(filepath, O_RDONLY);
+	if(fd == -1)
+	{
+		LOG_ERROR("MacosMapFile: open error on %s: %d", filepath, errno);
+		return result;
+	}
+
+	struct stat fileStats;
+	if(fstat(fd, &fileStats) == 0)
+	{
+		result.size = fileStats.st_size;
+		if(result.size == 0)
+		{
+			// mmap won't take a zero length
+			result.error = 0;
+		}
+		else
+		{
+			void* data = mmap(0, result.size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(data != MAP_FAILED)
+			{
+				int advice = MADV_NORMAL;
+				if(hint == FileAccessHint::Sequential) { advice = MADV_SEQUENTIAL; }
+				else if(hint == FileAccessHint::Random) { advice = MADV_RANDOM; }
+				madvise(data, result.size, advice);
+				if(hint == FileAccessHint::Sequential)
+				{
+					madvise(data, result.size, MADV_WILLNEED);
+				}
+
+				result.data = (const u8*)data;
+				result.error = 0;
+			}
+			else
+			{
+				LOG_ERROR("MacosMapFile: mmap error on %s: %d", filepath, errno);
+			}
+		}
+	}
+
+	// the mapping holds its own reference to the file
+	close(fd);
+
+	return result;
+}
+
+internal void
+MacosUnmapFile(platform_mapped_file& file)
+{
+	if(file.data)
+	{
+		munmap((void*)file.data, file.size);
+	}
+	ZeroStruct(file);
+	file.error = 1;
+}
+
+// NOTE(james): no work queues on this platform yet, so async reads happen right away with
+// pread and the handle comes back already complete.  Same as the shared code does when it
+// runs out of slots: generation zero, with the bytes read in the index.
+internal u64
+MacosReadFileAt(platform_file& file, u64 offset, u64 size, void* dest)
+{
+	u64 amountRead = 0;
+	int fd = *(int*)&file.platform;
+
+	// pread can return short counts too
+	while(amountRead < size)
+	{
+		ssize_t bytesRead = pread(fd, (u8*)dest + amountRead, size - amountRead, offset + amountRead);
+		if(bytesRead > 0)
+		{
+			amountRead += bytesRead;
+		}
+		else if(bytesRead == -1 && errno == EINTR)
+		{
+			continue;
+		}
+		else
+		{
+			if(bytesRead == -1)
+			{
+				LOG_ERROR("MacosReadFileAt: read error: %d", errno);
+			}
+			break;
+		}
+	}
+
+	return amountRead;
+}
+
+internal void
+MacosReadFileAsyncBatch(u32 count, const platform_file_read_request* requests, platform_file_read_handle* handles)
+{
+	for(u32 index = 0; index < count; ++index)
+	{
+		const platform_file_read_request& request = requests[index];
+		ASSERT(request.size <= U32MAX);
+
+		u64 bytesRead = request.file->error ? 0 : MacosReadFileAt(*request.file, request.offset, request.size, request.dest);
+		handles[index].index = (u32)bytesRead;
+		handles[index].generation = 0;
+	}
+}
+
+internal platform_file_read_handle
+MacosReadFileAsync(platform_file& file, u64 offset, u64 size, void* dest)
+{
+	platform_file_read_request request = { &file, offset, size, dest };
+	platform_file_read_handle handle = {};
+	MacosReadFileAsyncBatch(1, &request, &handle);
+	return handle;
+}
+
+internal b32
+MacosIsFileReadComplete(platform_file_read_handle handle)
+{
+	return true;
+}
+
+internal u64
+MacosWaitForFileRead(platform_file_read_handle handle)
+{
+	return handle.index;
+}
+
+internal void
+MacosListDirectory(memory_arena& arena, platform_file_list& list, FileLocation location, const char* directory, b32 recursive)
+{
+	char dirpath[FILENAME_MAX];
+	FormatString(dirpath, FILENAME_MAX, "%s%s", GlobalMacosState.fileLocationsTable[(u32)location].folder, directory);
+
+	DIR* dir = opendir(dirpath);
+	if(!dir)
+	{
+		return;
+	}
+
+	while(struct dirent* entry = readdir(dir))
+	{
+		const char* filename = entry->d_name;
+		if(filename[0] == '.' && (!filename[1] || (filename[1] == '.' && !filename[2])))
+		{
+			continue;
+		}
+
+		struct stat fileStats;
+		if(fstatat(dirfd(dir), filename, &fileStats, 0) != 0)
+		{
+			continue;
+		}
+
+		char name[FILENAME_MAX];
+		FormatString(name, FILENAME_MAX, "%s%s", directory, filename);
+
+		platform_file_info* info = PushFileInfo(arena, list, name);
+		info->isDirectory = S_ISDIR(fileStats.st_mode);
+		info->size = info->isDirectory ? 0 : (u64)fileStats.st_size;
+		info->writeTime = (u64)fileStats.st_mtimespec.tv_sec * 1000000000ull + (u64)fileStats.st_mtimespec.tv_nsec;
+
+		if(recursive && info->isDirectory)
+		{
+			FormatString(name, FILENAME_MAX, "%s%s/", directory, filename);
+			MacosListDirectory(arena, list, location, name, recursive);
+		}
+	}
+
+	closedir(dir);
+}
+
+internal platform_file_list
+MacosListFiles(memory_arena& arena, FileLocation location, const char* directory, b32 recursive)
+{
+	platform_file_list result = {};
+
+	char prefix[FILENAME_MAX];
+	MakeDirectoryPrefix(directory, prefix, FILENAME_MAX);
+	MacosListDirectory(arena, result, location, prefix, recursive);
+
+	return result;
+}
+
+internal void
+MacosTakeSnapshot(macos_directory_snapshot& snapshot, FileLocation location, const char* path)
+{
+	Clear(snapshot.arena);
+	snapshot.arena.allocationFlags = PlatformMemoryFlags::NotRestored;
+
+	snapshot.files = MacosListFiles(snapshot.arena, location, path, true);
+	snapshot.lookup = hashtable_create(snapshot.arena, platform_file_info*, 64);
+	snapshot.lookup->reserve(snapshot.files.count);
+	for(platform_file_info* info = snapshot.files.first; info; info = info->next)
+	{
+		snapshot.lookup->set(FileChangeKey(location, info->name), info);
+	}
+}
+
+// TODO(james): Watch through FSEvents, it wants a run loop or a dispatch queue to deliver to.
+// Until then watches poll with ListFiles and compare write times.
+internal platform_directory_watch
+MacosWatchDirectory(FileLocation location, const char* directory)
+{
+	platform_directory_watch result = {};
+	macos_file_watcher& watcher = GlobalMacosState.fileWatcher;
+
+	macos_directory_watch* watch = 0;
+	for(u32 index = 0; index < MACOS_MAX_DIRECTORY_WATCHES; ++index)
+	{
+		if(!watcher.watches[index].id)
+		{
+			watch = watcher.watches + index;
+			break;
+		}
+	}
+	ASSERT(watch);
+
+	char prefix[FILENAME_MAX];
+	MakeDirectoryPrefix(directory, prefix, FILENAME_MAX);
+
+	char dirpath[FILENAME_MAX];
+	FormatString(dirpath, FILENAME_MAX, "%s%s", GlobalMacosState.fileLocationsTable[(u32)location].folder, prefix);
+	struct stat dirStats;
+	if(stat(dirpath, &dirStats) != 0 || !S_ISDIR(dirStats.st_mode))
+	{
+		LOG_ERROR("Not a directory, not watching %s", dirpath);
+		return result;
+	}
+
+	if(!++watcher.nextWatchId) ++watcher.nextWatchId;
+	watch->id = watcher.nextWatchId;
+	watch->location = location;
+	CopyString(prefix, watch->path, FILENAME_MAX);
+
+	watch->current = 0;
+	MacosTakeSnapshot(watch->snapshots[0], location, watch->path);
+
+	result.id = watch->id;
+	return result;
+}
+
+internal void
+MacosUnwatchDirectory(platform_directory_watch watch)
+{
+	macos_file_watcher& watcher = GlobalMacosState.fileWatcher;
+
+	if(!watch.id)
+	{
+		return;
+	}
+
+	for(u32 index = 0; index < MACOS_MAX_DIRECTORY_WATCHES; ++index)
+	{
+		macos_directory_watch& directoryWatch = watcher.watches[index];
+		if(directoryWatch.id == watch.id)
+		{
+			Clear(directoryWatch.snapshots[0].arena);
+			Clear(directoryWatch.snapshots[1].arena);
+			ZeroStruct(directoryWatch);
+		}
+	}
+}
+
+internal platform_file_change_list
+MacosGetFileChanges(memory_arena& arena)
+{
+	file_change_builder changes = {};
+	macos_file_watcher& watcher = GlobalMacosState.fileWatcher;
+
+	u64 now = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+	if(now - watcher.lastPollTime < MACOS_WATCH_POLL_INTERVAL_NS)
+	{
+		return changes.list;
+	}
+	watcher.lastPollTime = now;
+
+	for(u32 index = 0; index < MACOS_MAX_DIRECTORY_WATCHES; ++index)
+	{
+		macos_directory_watch& watch = watcher.watches[index];
+		if(!watch.id)
+		{
+			continue;
+		}
+
+		macos_directory_snapshot& before = watch.snapshots[watch.current];
+		watch.current ^= 1;
+		macos_directory_snapshot& after = watch.snapshots[watch.current];
+		MacosTakeSnapshot(after, watch.location, watch.path);
+
+		for(platform_file_info* info = after.files.first; info; info = info->next)
+		{
+			platform_file_info* previous = 0;
+			if(!before.lookup->try_get(FileChangeKey(watch.location, info->name), &previous))
+			{
+				PushFileChange(arena, changes, watch.location, info->name, FileChangeType::Added);
+			}
+			// NOTE(james): a directory's write time moves with its contents, which get their own changes
+			else if(!info->isDirectory && (info->writeTime != previous->writeTime || info->size != previous->size))
+			{
+				PushFileChange(arena, changes, watch.location, info->name, FileChangeType::Modified);
+			}
+		}
+
+		for(platform_file_info* info = before.files.first; info; info = info->next)
+		{
+			if(!after.lookup->contains(FileChangeKey(watch.location, info->name)))
+			{
+				PushFileChange(arena, changes, watch.location, info->name, FileChangeType::Removed);
+			}
+		}
+
+		Clear(before.arena);
+		before.files = {};
+		before.lookup = 0;
+	}
+
+	return changes.list;
+}
+
 internal time_t
 MacosGetLastWriteTime(const char* filename)
 {
@@ -677,11 +1133,25 @@ int main(int argc, const char* argv[])
 
 		Platform.AllocateMemoryBlock = &MacosAllocateMemoryBlock;
 		Platform.DeallocateMemoryBlock = &MacosDeallocatedMemoryBlock;
+		Platform.CommitMemoryBlock = &MacosCommitMemoryBlock;
+		Platform.SetMemoryBlockCacheLimit = &MacosSetMemoryBlockCacheLimit;
+		Platform.AllocateMirroredMemory = &MacosAllocateMirroredMemory;
+		Platform.DeallocateMirroredMemory = &MacosDeallocateMirroredMemory;
 
 		Platform.OpenFile = &MacosOpenFile;
 		Platform.ReadFile = &MacosReadFile;
 		Platform.WriteFile = &MacosWriteFile;
 		Platform.CloseFile = &MacosCloseFile;
+		Platform.MapFile = &MacosMapFile;
+		Platform.UnmapFile = &MacosUnmapFile;
+		Platform.ListFiles = &MacosListFiles;
+		Platform.WatchDirectory = &MacosWatchDirectory;
+		Platform.UnwatchDirectory = &MacosUnwatchDirectory;
+		Platform.GetFileChanges = &MacosGetFileChanges;
+		Platform.ReadFileAsync = &MacosReadFileAsync;
+		Platform.ReadFileAsyncBatch = &MacosReadFileAsyncBatch;
+		Platform.IsFileReadComplete = &MacosIsFileReadComplete;
+		Platform.WaitForFileRead = &MacosWaitForFileRead;
 
 #if PROJECTSUPER_INTERNAL
 		Platform.DEBUG_Log = &MacosDebugLog;
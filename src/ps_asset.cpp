@@ -368,9 +368,10 @@ AllocateGameAssets(game_state& gm_state)
 
     // TODO(james): Load assets in chunks based on the current area
 
-    assets.mapPrograms = hashtable_create(assets.memory, GfxProgram, 1024);
-    assets.mapKernels = hashtable_create(assets.memory, GfxKernel, 1024);
-    assets.mapGeometry = hashtable_create(assets.memory, render_geometry, 1024);
+    // NOTE(james): these grow as assets come in, no need to reserve for the worst case
+    assets.mapPrograms = hashtable_create(assets.memory, GfxProgram, 64);
+    assets.mapKernels = hashtable_create(assets.memory, GfxKernel, 64);
+    assets.mapGeometry = hashtable_create(assets.memory, render_geometry, 64);
 
 
 
@@ -0,0 +1,292 @@
+/*******************************************************************************
+
+    Asynchronous file reads shared by the platform layers
+
+    Every read in flight owns a slot with a generation, the same way work
+    batches do, so the handle handed back to the game goes stale safely once
+    the read has been waited on.  The platform hands reads to whatever the OS
+    does natively and reports back as they finish.  When there isn't a native
+    path the reads run as blocking positional reads on a work queue instead,
+    which keeps the game side identical either way.
+
+    Nobody sits on the OS completions.  A thread waiting on a read reaps
+    whatever has finished, and polling with IsFileReadComplete reaps without
+    blocking, so completions only get looked at when somebody cares.
+
+    The including platform layer has to provide, after ps_work_queue.h and
+    before including this file:
+
+        platform_async_read_native
+
+    and define these, which are declared below, after including it:
+
+        internal void PlatformAsyncReadStart(platform_async_read* read, platform_file& file);
+        internal void PlatformAsyncReadSubmit();
+        internal void PlatformAsyncReadReap(b32 wait);
+        internal u64 PlatformReadFileAt(platform_file& file, u64 offset, u64 size, void* dest);
+
+    Reads never wait for a slot, since slots only come back when the game waits
+    on its reads and that could well be the same thread.  With every slot in
+    flight a read just happens on the spot and its handle has generation zero,
+    with the bytes read in the index.
+
+    Start and Submit are called with the submit ticket held.  Start gets the
+    game's own file as well as the read's copy of it, so anything it opens
+    lazily sticks around for the next read.  It may finish a read right away
+    with AsyncReadComplete if the OS turns it down.
+
+********************************************************************************/
+
+#define PLATFORM_ASYNC_READ_MAX 256
+
+enum class AsyncReadState : u32
+{
+    Free,
+    Pending,
+    Complete
+};
+
+struct platform_async_read
+{
+    u32 volatile generation;
+    u32 volatile state;
+
+    platform_file file;
+    u64 offset;
+    u64 size;
+    void* dest;
+    u64 bytesRead;
+
+    platform_async_read_native native;
+};
+
+struct platform_async_file_io
+{
+    // NOTE(james): To touch the free list, you have to take a ticket!
+    ticket_mutex freeMutex;
+    u32 freeReadCount;
+    u32 freeReads[PLATFORM_ASYNC_READ_MAX];
+    platform_async_read reads[PLATFORM_ASYNC_READ_MAX];
+
+    // NOTE(james): To hand reads to the OS, you have to take a ticket!
+    ticket_mutex submitMutex;
+    // NOTE(james): only one thread reaps OS completions at a time
+    ticket_mutex reapMutex;
+
+    // NOTE(james): set when there is no native path, reads run as jobs on it instead
+    platform_work_queue* fallbackQueue;
+};
+
+global_variable platform_async_file_io GlobalAsyncFileIO;
+
+internal void PlatformAsyncReadStart(platform_async_read* read, platform_file& file);
+internal void PlatformAsyncReadSubmit();
+internal void PlatformAsyncReadReap(b32 wait);
+internal u64 PlatformReadFileAt(platform_file& file, u64 offset, u64 size, void* dest);
+
+internal void
+AsyncReadComplete(platform_async_read* read, u64 bytesRead)
+{
+    read->bytesRead = bytesRead;
+    AtomicStoreReleaseU32(&read->state, (u32)AsyncReadState::Complete);
+}
+
+internal
+PLATFORM_WORK_QUEUE_CALLBACK(AsyncReadFallbackJob)
+{
+    platform_async_read* read = (platform_async_read*)data;
+    u64 bytesRead = PlatformReadFileAt(read->file, read->offset, read->size, read->dest);
+    AsyncReadComplete(read, bytesRead);
+}
+
+internal platform_async_read*
+AsyncReadAllocate(const platform_file& file, u64 offset, u64 size, void* dest, platform_file_read_handle* handle)
+{
+    platform_async_file_io& io = GlobalAsyncFileIO;
+
+    BeginTicketMutex(&io.freeMutex);
+    if(!io.freeReadCount)
+    {
+        EndTicketMutex(&io.freeMutex);
+        return 0;
+    }
+    u32 readIndex = io.freeReads[--io.freeReadCount];
+    EndTicketMutex(&io.freeMutex);
+
+    platform_async_read* read = io.reads + readIndex;
+    read->file = file;
+    read->offset = offset;
+    read->size = size;
+    read->dest = dest;
+    read->bytesRead = 0;
+    read->state = (u32)AsyncReadState::Pending;
+
+    handle->index = readIndex;
+    handle->generation = read->generation;
+
+    return read;
+}
+
+internal void
+AsyncReadFree(platform_async_read* read)
+{
+    platform_async_file_io& io = GlobalAsyncFileIO;
+
+    u32 generation = read->generation + 1;
+    if(generation == 0) generation = 1;
+    AtomicStoreReleaseU32(&read->generation, generation);
+    read->state = (u32)AsyncReadState::Free;
+
+    BeginTicketMutex(&io.freeMutex);
+    io.freeReads[io.freeReadCount++] = (u32)(read - io.reads);
+    EndTicketMutex(&io.freeMutex);
+}
+
+internal void
+AsyncReadDispatch(platform_async_read* read, platform_file& file)
+{
+    platform_async_file_io& io = GlobalAsyncFileIO;
+
+    if(read->file.error)
+    {
+        AsyncReadComplete(read, 0);
+    }
+    else if(io.fallbackQueue)
+    {
+        AddWorkQueueEntry(io.fallbackQueue, AsyncReadFallbackJob, read);
+    }
+    else
+    {
+        PlatformAsyncReadStart(read, file);
+    }
+}
+
+internal void
+ReadFileAsyncBatch(u32 count, const platform_file_read_request* requests, platform_file_read_handle* handles)
+{
+    platform_async_file_io& io = GlobalAsyncFileIO;
+
+    // NOTE(james): the OS gets the whole batch in one submission
+    BeginTicketMutex(&io.submitMutex);
+    for(u32 index = 0; index < count; ++index)
+    {
+        const platform_file_read_request& request = requests[index];
+        ASSERT(request.size <= U32MAX);
+
+        platform_async_read* read = AsyncReadAllocate(*request.file, request.offset, request.size, request.dest, handles + index);
+        if(read)
+        {
+            AsyncReadDispatch(read, *request.file);
+        }
+        else
+        {
+            u64 bytesRead = request.file->error ? 0 : PlatformReadFileAt(*request.file, request.offset, request.size, request.dest);
+            handles[index].index = (u32)bytesRead;
+            handles[index].generation = 0;
+        }
+    }
+    if(!io.fallbackQueue)
+    {
+        PlatformAsyncReadSubmit();
+    }
+    EndTicketMutex(&io.submitMutex);
+}
+
+internal platform_file_read_handle
+ReadFileAsync(platform_file& file, u64 offset, u64 size, void* dest)
+{
+    platform_file_read_request request = { &file, offset, size, dest };
+    platform_file_read_handle handle = {};
+    ReadFileAsyncBatch(1, &request, &handle);
+    return handle;
+}
+
+internal b32
+IsFileReadComplete(platform_file_read_handle handle)
+{
+    platform_async_file_io& io = GlobalAsyncFileIO;
+
+    if(!handle.generation)
+    {
+        return true;
+    }
+
+    ASSERT(handle.index < PLATFORM_ASYNC_READ_MAX);
+    platform_async_read* read = io.reads + handle.index;
+    if(AtomicLoadAcquireU32(&read->generation) != handle.generation)
+    {
+        return true;
+    }
+
+    if(AtomicLoadAcquireU32(&read->state) != (u32)AsyncReadState::Complete &&
+       !io.fallbackQueue && TryBeginTicketMutex(&io.reapMutex))
+    {
+        PlatformAsyncReadReap(false);
+        EndTicketMutex(&io.reapMutex);
+    }
+
+    return AtomicLoadAcquireU32(&read->state) == (u32)AsyncReadState::Complete;
+}
+
+internal u64
+WaitForFileRead(platform_file_read_handle handle)
+{
+    platform_async_file_io& io = GlobalAsyncFileIO;
+
+    if(!handle.generation)
+    {
+        // empty, or it already happened because there were no slots left
+        return handle.index;
+    }
+
+    ASSERT(handle.index < PLATFORM_ASYNC_READ_MAX);
+    platform_async_read* read = io.reads + handle.index;
+    // NOTE(james): a stale handle has already been waited on
+    ASSERT(read->generation == handle.generation);
+
+    u32 spinCount = 0;
+    while(AtomicLoadAcquireU32(&read->state) != (u32)AsyncReadState::Complete)
+    {
+        if(io.fallbackQueue)
+        {
+            // help out with the reads until ours is done
+            WaitForWorkQueueEntry(io.fallbackQueue, &spinCount);
+        }
+        else if(TryBeginTicketMutex(&io.reapMutex))
+        {
+            // NOTE(james): whoever had the reaper last may have finished us off, and
+            // blocking for a completion that already came would never return
+            if(AtomicLoadAcquireU32(&read->state) != (u32)AsyncReadState::Complete)
+            {
+                PlatformAsyncReadReap(true);
+            }
+            EndTicketMutex(&io.reapMutex);
+        }
+        else
+        {
+            PlatformYieldThread();
+        }
+    }
+
+    u64 bytesRead = read->bytesRead;
+    AsyncReadFree(read);
+
+    return bytesRead;
+}
+
+internal void
+InitAsyncFileIO(platform_work_queue* fallbackQueue)
+{
+    platform_async_file_io& io = GlobalAsyncFileIO;
+
+    io.fallbackQueue = fallbackQueue;
+    io.freeReadCount = 0;
+    for(u32 readIndex = PLATFORM_ASYNC_READ_MAX; readIndex > 0; --readIndex)
+    {
+        platform_async_read* read = io.reads + (readIndex - 1);
+        // NOTE(james): generation zero is reserved for the empty handle
+        read->generation = 1;
+        read->state = (u32)AsyncReadState::Free;
+        io.freeReads[io.freeReadCount++] = readIndex - 1;
+    }
+}
@@ -8,11 +8,6 @@
 // insert() moves the element at the index to the end of the array to make room rather than moving all the elements down a position
 // erase() moves the element at the end of the array to the slot being erased
 
-// TODO(james): create our own implementation?
-#include <bitset>
-
-typedef std::bitset<32> bitset32;
-typedef std::bitset<64> bitset64;
 
 template<typename T>
 struct slice
@@ -147,6 +142,18 @@ struct array
 
     void set_size(u32 size) { ASSERT(size <= _capacity); _size = size; }
 
+    // NOTE(james): only works while the array data is still the last push on the arena,
+    // a ReserveOnly arena makes this cheap for big arrays
+    b32 try_grow(memory_arena& arena, u32 newCapacity)
+    {
+        if(!TryGrowInPlace(arena, _data, _capacity*sizeof(T), newCapacity*sizeof(T)))
+        {
+            return false;
+        }
+        _capacity = newCapacity;
+        return true;
+    }
+
     u32 size() const { return _size; }
     u32 capacity() const { return _capacity; }
     b32 empty() const { return _size == 0; }
@@ -223,171 +230,599 @@ struct array
     }
 };
 
+// NOTE(james): Fixed size bitset kept in 64 bit words, stands in for std::bitset
+template<u32 N>
+struct fixed_bitset
+{
+    enum : u32 { word_count = (N + 63) / 64 };
+
+    u64 _words[word_count];
+
+    static u64 _bit(u32 index) { return 1ull << (index & 63); }
+
+    b32 test(u32 index) const { ASSERT(index < N); return (_words[index >> 6] & _bit(index)) != 0; }
+    b32 operator[](u32 index) const { return test(index); }
+
+    void set(u32 index) { ASSERT(index < N); _words[index >> 6] |= _bit(index); }
+    void set(u32 index, b32 value) { if(value) set(index); else reset(index); }
+    void reset(u32 index) { ASSERT(index < N); _words[index >> 6] &= ~_bit(index); }
+    void flip(u32 index) { ASSERT(index < N); _words[index >> 6] ^= _bit(index); }
+
+    void set_all()
+    {
+        for(u32 i = 0; i < word_count; ++i) _words[i] = ~0ull;
+        if(N & 63) _words[word_count-1] = (1ull << (N & 63)) - 1;
+    }
+    void reset_all() { for(u32 i = 0; i < word_count; ++i) _words[i] = 0; }
+
+    u32 count() const
+    {
+        u32 result = 0;
+        for(u32 i = 0; i < word_count; ++i) result += CountSetBits(_words[i]);
+        return result;
+    }
+    b32 any() const { for(u32 i = 0; i < word_count; ++i) if(_words[i]) return true; return false; }
+    b32 none() const { return !any(); }
+    b32 all() const { return count() == N; }
+    u32 size() const { return N; }
+
+    // NOTE(james): N when there are no more set bits
+    u32 find_next_set(u32 from = 0) const
+    {
+        for(u32 wordIndex = from >> 6; wordIndex < word_count; ++wordIndex)
+        {
+            u64 word = _words[wordIndex];
+            if(wordIndex == (from >> 6)) word &= ~0ull << (from & 63);
+            if(word)
+            {
+                return wordIndex*64 + FindLeastSignificantSetBit(word).Index;
+            }
+        }
+        return N;
+    }
+};
+
+typedef fixed_bitset<32> bitset32;
+typedef fixed_bitset<64> bitset64;
+
+#define bitset_create(arena, bitCount) dynamic_bitset::create(arena, bitCount)
+
+// NOTE(james): Arena backed bitset sized at creation.  Everything works a 64 bit word at a
+// time, and searching skips runs of empty (or full) words four at a time with SSE2, so
+// finding the next set or clear bit in a mostly uniform set doesn't touch each word.
+// The word storage is padded to a whole SSE block and always kept zero past bitCount.
+struct dynamic_bitset
+{
+    enum : u32 { end_pos = U32MAX };
+
+    u64* _words;
+    u32 _bitCount;
+    u32 _wordCount;
+
+    static dynamic_bitset* create(memory_arena& arena, u32 bitCount)
+    {
+        dynamic_bitset* bits = PushStruct(arena, dynamic_bitset);
+        bits->_bitCount = bitCount;
+        bits->_wordCount = (bitCount + 63) / 64;
+        bits->_words = PushArray(arena, AlignPow2(bits->_wordCount, 4), u64, Align(32, true));
+        return bits;
+    }
+
+    static u64 _bit(u32 index) { return 1ull << (index & 63); }
+
+    b32 test(u32 index) const { ASSERT(index < _bitCount); return (_words[index >> 6] & _bit(index)) != 0; }
+    b32 operator[](u32 index) const { return test(index); }
+
+    void set(u32 index) { ASSERT(index < _bitCount); _words[index >> 6] |= _bit(index); }
+    void set(u32 index, b32 value) { if(value) set(index); else clear(index); }
+    void clear(u32 index) { ASSERT(index < _bitCount); _words[index >> 6] &= ~_bit(index); }
+    void flip(u32 index) { ASSERT(index < _bitCount); _words[index >> 6] ^= _bit(index); }
+
+    // NOTE(james): sets or clears [first, first+count) a word at a time
+    void set_range(u32 first, u32 count, b32 value = true)
+    {
+        ASSERT(first + count <= _bitCount);
+        u32 index = first;
+        u32 end = first + count;
+        while(index < end)
+        {
+            u32 bitInWord = index & 63;
+            u32 bits = Minimum(64 - bitInWord, end - index);
+            u64 mask = (bits == 64) ? ~0ull : (((1ull << bits) - 1) << bitInWord);
+            if(value) _words[index >> 6] |= mask;
+            else _words[index >> 6] &= ~mask;
+            index += bits;
+        }
+    }
+
+    void set_all() { set_range(0, _bitCount, true); }
+    void clear_all() { ZeroArray(_wordCount, _words); }
+
+    u32 count() const
+    {
+        u32 result = 0;
+        for(u32 i = 0; i < _wordCount; ++i) result += CountSetBits(_words[i]);
+        return result;
+    }
+    u32 size() const { return _bitCount; }
+
+    // NOTE(james): index of the first word at or after wordIndex that isn't equal to
+    // skipValue (0 or ~0), _wordCount if there isn't one
+    u32 _find_word_not(u32 wordIndex, u64 skipValue) const
+    {
+        // walk up to a 4 word boundary so the SIMD loop can use aligned loads
+        while(wordIndex < _wordCount && (wordIndex & 3))
+        {
+            if(_words[wordIndex] != skipValue) return wordIndex;
+            ++wordIndex;
+        }
+
+        __m128i skip = _mm_set1_epi32((int)(u32)skipValue);
+        for(; wordIndex + 4 <= _wordCount; wordIndex += 4)
+        {
+            __m128i a = _mm_load_si128((const __m128i*)(_words + wordIndex));
+            __m128i b = _mm_load_si128((const __m128i*)(_words + wordIndex + 2));
+            __m128i same = _mm_and_si128(_mm_cmpeq_epi32(a, skip), _mm_cmpeq_epi32(b, skip));
+            if(_mm_movemask_epi8(same) != 0xFFFF)
+            {
+                break;
+            }
+        }
+
+        for(; wordIndex < _wordCount; ++wordIndex)
+        {
+            if(_words[wordIndex] != skipValue) return wordIndex;
+        }
+        return _wordCount;
+    }
+
+    u32 find_next_set(u32 from = 0) const
+    {
+        if(from >= _bitCount) return end_pos;
+
+        u32 wordIndex = from >> 6;
+        u64 word = _words[wordIndex] & (~0ull << (from & 63));
+        if(!word)
+        {
+            wordIndex = _find_word_not(wordIndex + 1, 0);
+            if(wordIndex == _wordCount) return end_pos;
+            word = _words[wordIndex];
+        }
+        return wordIndex*64 + FindLeastSignificantSetBit(word).Index;
+    }
+
+    u32 find_next_clear(u32 from = 0) const
+    {
+        if(from >= _bitCount) return end_pos;
+
+        u32 wordIndex = from >> 6;
+        u64 word = ~_words[wordIndex] & (~0ull << (from & 63));
+        if(!word)
+        {
+            wordIndex = _find_word_not(wordIndex + 1, ~0ull);
+            if(wordIndex == _wordCount) return end_pos;
+            word = ~_words[wordIndex];
+        }
+        u32 result = wordIndex*64 + FindLeastSignificantSetBit(word).Index;
+        // the padding past the end reads as clear
+        return result < _bitCount ? result : end_pos;
+    }
+
+    struct iterator
+    {
+        const dynamic_bitset* _bits;
+        u32 _index;
+
+        u32 operator*() const { return _index; }
+        iterator& operator++() { _index = _bits->find_next_set(_index + 1); return *this; }
+        bool operator!=(const iterator& other) const { return _index != other._index; }
+    };
+
+    // NOTE(james): range-for walks the indices of the set bits
+    iterator begin() const { return iterator{ this, find_next_set(0) }; }
+    iterator end() const { return iterator{ this, end_pos }; }
+};
+
+#define hierarchical_bitset_create(arena, bitCount) hierarchical_bitset::create(arena, bitCount)
+
+// NOTE(james): Two level bitset for sparse sets over a lot of ids (dirty lists, alive
+// masks...).  Each bit in the summary says whether the matching 64 bit word of the leaf
+// level has anything set, so a scan only visits words that have bits in them - a million
+// ids is 256 summary words to look through.
+struct hierarchical_bitset
+{
+    enum : u32 { end_pos = U32MAX };
+
+    u64* _leaves;
+    u64* _summary;
+    u32 _bitCount;
+    u32 _leafCount;
+    u32 _summaryCount;
+
+    static hierarchical_bitset* create(memory_arena& arena, u32 bitCount)
+    {
+        hierarchical_bitset* bits = PushStruct(arena, hierarchical_bitset);
+        bits->_bitCount = bitCount;
+        bits->_leafCount = (bitCount + 63) / 64;
+        bits->_summaryCount = (bits->_leafCount + 63) / 64;
+        bits->_leaves = PushArray(arena, bits->_leafCount, u64);
+        bits->_summary = PushArray(arena, bits->_summaryCount, u64);
+        return bits;
+    }
+
+    b32 test(u32 index) const { ASSERT(index < _bitCount); return (_leaves[index >> 6] >> (index & 63)) & 1; }
+    b32 operator[](u32 index) const { return test(index); }
+
+    void set(u32 index)
+    {
+        ASSERT(index < _bitCount);
+        u32 leaf = index >> 6;
+        _leaves[leaf] |= 1ull << (index & 63);
+        _summary[leaf >> 6] |= 1ull << (leaf & 63);
+    }
+
+    void clear(u32 index)
+    {
+        ASSERT(index < _bitCount);
+        u32 leaf = index >> 6;
+        _leaves[leaf] &= ~(1ull << (index & 63));
+        if(!_leaves[leaf])
+        {
+            _summary[leaf >> 6] &= ~(1ull << (leaf & 63));
+        }
+    }
+
+    void set(u32 index, b32 value) { if(value) set(index); else clear(index); }
+
+    // NOTE(james): only touches the words that have something in them
+    void clear_all()
+    {
+        for(u32 summaryIndex = 0; summaryIndex < _summaryCount; ++summaryIndex)
+        {
+            for(u64 word = _summary[summaryIndex]; word; word &= word - 1)
+            {
+                _leaves[summaryIndex*64 + FindLeastSignificantSetBit(word).Index] = 0;
+            }
+            _summary[summaryIndex] = 0;
+        }
+    }
+
+    b32 any() const
+    {
+        for(u32 i = 0; i < _summaryCount; ++i) if(_summary[i]) return true;
+        return false;
+    }
+
+    u32 count() const
+    {
+        u32 result = 0;
+        for(u32 summaryIndex = 0; summaryIndex < _summaryCount; ++summaryIndex)
+        {
+            for(u64 word = _summary[summaryIndex]; word; word &= word - 1)
+            {
+                result += CountSetBits(_leaves[summaryIndex*64 + FindLeastSignificantSetBit(word).Index]);
+            }
+        }
+        return result;
+    }
+    u32 size() const { return _bitCount; }
+
+    u32 find_next_set(u32 from = 0) const
+    {
+        if(from >= _bitCount) return end_pos;
+
+        u32 leaf = from >> 6;
+        u64 word = _leaves[leaf] & (~0ull << (from & 63));
+        if(word)
+        {
+            return leaf*64 + FindLeastSignificantSetBit(word).Index;
+        }
+
+        // find the next leaf with anything in it from the summary
+        u32 nextLeaf = leaf + 1;
+        u32 summaryIndex = nextLeaf >> 6;
+        if(summaryIndex >= _summaryCount) return end_pos;
+        u64 summary = (nextLeaf & 63) ? (_summary[summaryIndex] & (~0ull << (nextLeaf & 63))) : _summary[summaryIndex];
+        while(!summary)
+        {
+            if(++summaryIndex >= _summaryCount) return end_pos;
+            summary = _summary[summaryIndex];
+        }
+        leaf = summaryIndex*64 + FindLeastSignificantSetBit(summary).Index;
+        return leaf*64 + FindLeastSignificantSetBit(_leaves[leaf]).Index;
+    }
+
+    struct iterator
+    {
+        const hierarchical_bitset* _bits;
+        u32 _index;
+
+        u32 operator*() const { return _index; }
+        iterator& operator++() { _index = _bits->find_next_set(_index + 1); return *this; }
+        bool operator!=(const iterator& other) const { return _index != other._index; }
+    };
+
+    iterator begin() const { return iterator{ this, find_next_set(0) }; }
+    iterator end() const { return iterator{ this, end_pos }; }
+};
+
 #define hashtable_create(arena, type, size) hashtable<type>::create<size>(arena)
 
+// NOTE(james): Open addressing "swiss table" style map from a u64 key to a POD value.
+// Every slot has a control byte, either empty, deleted or the low 7 bits of the key's
+// hash.  Control bytes are probed 16 at a time with SSE2, so a lookup is usually one
+// group compare and one key compare.
+// The table grows on its own, pulling the bigger arrays from the arena it was created
+// on.  The old arrays stay on the arena until it's cleared, so size it up front when
+// you can.  Pointers to entries are NOT stable across a set() that adds a key.
 template<typename T>
 struct hashtable
 {
     enum : u32 { 
-        end_pos = U32MAX
+        end_pos = U32MAX,
+        group_width = 16
+    };
+
+    enum : u8 {
+        ctrl_empty = 0x80,
+        ctrl_deleted = 0xFE
+        // full slots hold 0b0xxxxxxx
     };
 
     struct entry
     {
         u64 key;
-        u32 next_idx;
         T value;
 
         T& operator*() { return value; }
     };
 
-    struct find_result
+    struct iterator
     {
-        u32 hash_index;
-        u32 entry_index;
-        u32 prev_entry_index;
+        hashtable<T>* _table;
+        u32 _index;
+
+        entry& operator*() { return _table->_slots[_index]; }
+        entry* operator->() { return _table->_slots + _index; }
+        iterator& operator++() { _index = _table->_next_full(_index + 1); return *this; }
+        bool operator==(const iterator& other) const { return _index == other._index; }
+        bool operator!=(const iterator& other) const { return _index != other._index; }
     };
 
     T default_value;
-    u32* _keys;
-    array<entry> _entries;
+    memory_arena* _arena;
+    u8* _ctrl;
+    entry* _slots;
+    u32 _capacity;      // number of slots, a power of two and at least one group
+    u32 _size;
+    u32 _growth_left;   // inserts left before we're over the max load
+    u32 _deleted;
 
     template<u32 SIZE>
     static hashtable<T>* create(memory_arena& arena)
     {
-        hashtable<T>* ht = (hashtable<T>*)PushSize_(DEBUG_MEMORY_NAME("PushStruct") arena, sizeof(hashtable<T>));
-        ht->_keys = PushArray(arena, SIZE, u32);
-        for(umm i = 0; i < SIZE; ++i)
-            ht->_keys[i] = end_pos; 
-        ht->_entries = *array_create(arena, entry, SIZE);
+        hashtable<T>* ht = PushStruct(arena, hashtable<T>);
+        ht->_arena = &arena;
+        ht->_allocate(_slots_for(SIZE));
         return ht;
     }
 
-    u32 _hash_idx(u64 key) const { return key % _entries.capacity(); }
+    static u32 _max_load(u32 slots) { return slots - slots/8; }
 
-    u32 _add_entry(u64 key)
+    static u32 _slots_for(u32 count)
     {
-        entry e = {};
-        e.key = key;
-        e.next_idx = end_pos;
-        u32 index = _entries.size();
-        _entries.push_back(e);
-        return index;
+        u32 slots = group_width;
+        while(_max_load(slots) < count)
+        {
+            slots <<= 1;
+        }
+        return slots;
+    }
+
+    static u64 _hash(u64 key)
+    {
+        // NOTE(james): keys are often small counters, so spread them with a fibonacci
+        // multiply and take the well mixed high bits for the probe start (h1) and the
+        // control byte (h2)
+        return key * 0x9E3779B97F4A7C15ull;
+    }
+    static u32 _h1(u64 hash) { return (u32)(hash >> 32); }
+    static u8 _h2(u64 hash) { return (u8)(hash >> 57); }
+
+    void _allocate(u32 slots)
+    {
+        ASSERT(IsPow2(slots) && slots >= group_width);
+        _ctrl = (u8*)PushSize(*_arena, slots, Align(group_width, false));
+        _slots = PushArray(*_arena, slots, entry, NoClear());
+        _capacity = slots;
+        _reset_ctrl();
+    }
+
+    void _reset_ctrl()
+    {
+        for(u32 i = 0; i < _capacity; i += group_width)
+        {
+            _mm_store_si128((__m128i*)(_ctrl + i), _mm_set1_epi8((char)ctrl_empty));
+        }
+        _size = 0;
+        _deleted = 0;
+        _growth_left = _max_load(_capacity);
     }
 
-    find_result _find(u64 key) const
+    __m128i _group(u32 groupStart) const { return _mm_load_si128((const __m128i*)(_ctrl + groupStart)); }
+    static u32 _match(__m128i group, u8 h2) { return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)h2))); }
+    static u32 _match_empty(__m128i group) { return _match(group, ctrl_empty); }
+    // NOTE(james): empty and deleted are the only control bytes with the top bit set
+    static u32 _match_empty_or_deleted(__m128i group) { return (u32)_mm_movemask_epi8(group); }
+    static u32 _lowest_bit(u32 mask) { return FindLeastSignificantSetBit(mask).Index; }
+
+    // NOTE(james): probing is by whole groups, the triangular step visits every group
+    // exactly once because the group count is a power of two
+    u32 _find(u64 key) const
     {
-        find_result fr = {};
-        fr.hash_index = _hash_idx(key);
-        fr.prev_entry_index = end_pos;
-        fr.entry_index = _keys[fr.hash_index];
+        u64 hash = _hash(key);
+        u8 h2 = _h2(hash);
+        u32 groupMask = _capacity - group_width;
+        u32 groupStart = (_h1(hash) * group_width) & groupMask;
 
-        while(fr.entry_index != end_pos)
+        for(u32 step = group_width; ; step += group_width)
         {
-            if(_entries[fr.entry_index].key == key)
+            __m128i group = _group(groupStart);
+            for(u32 matches = _match(group, h2); matches; matches &= matches - 1)
+            {
+                u32 index = groupStart + _lowest_bit(matches);
+                if(_slots[index].key == key)
+                {
+                    return index;
+                }
+            }
+            if(_match_empty(group))
             {
-                return fr;
+                return end_pos;
             }
-            fr.prev_entry_index = fr.entry_index;
-            fr.entry_index = _entries[fr.entry_index].next_idx;
+            ASSERT(step <= _capacity);
+            groupStart = (groupStart + step) & groupMask;
         }
-
-        return fr;
     }
 
-    void _erase(const find_result& fr)
+    u32 _find_insert_slot(u64 hash) const
     {
-        if(fr.prev_entry_index == end_pos)
-            _keys[fr.hash_index] = _entries[fr.entry_index].next_idx;
-        else
-            _entries[fr.prev_entry_index].next_idx = _entries[fr.entry_index].next_idx;
+        u32 groupMask = _capacity - group_width;
+        u32 groupStart = (_h1(hash) * group_width) & groupMask;
 
-        _entries.erase(&_entries.back());
-        const find_result last = _find(_entries.back().key);
-
-        if(last.prev_entry_index != end_pos)
-            _entries[last.prev_entry_index].next_idx = last.entry_index;
-        else
-            _keys[last.hash_index] = last.entry_index;
+        for(u32 step = group_width; ; step += group_width)
+        {
+            u32 available = _match_empty_or_deleted(_group(groupStart));
+            if(available)
+            {
+                return groupStart + _lowest_bit(available);
+            }
+            ASSERT(step <= _capacity);
+            groupStart = (groupStart + step) & groupMask;
+        }
     }
 
-    u32 _find_or_fail(u64 key) const
+    void _rehash(u32 slots)
     {
-        return _find(key).entry_index;
+        u8* oldCtrl = _ctrl;
+        entry* oldSlots = _slots;
+        u32 oldCapacity = _capacity;
+
+        if(slots == _capacity)
+        {
+            // NOTE(james): same size just sweeps out the deleted markers, the entries
+            // get staged on the arena so the slots can be rebuilt in place
+            temporary_memory temp = BeginTemporaryMemory(*_arena);
+            entry* live = PushArray(*_arena, _size, entry, NoClear());
+            u32 liveCount = 0;
+            for(u32 i = 0; i < oldCapacity; ++i)
+            {
+                if(!(oldCtrl[i] & 0x80))
+                {
+                    live[liveCount++] = oldSlots[i];
+                }
+            }
+            _reset_ctrl();
+            for(u32 i = 0; i < liveCount; ++i)
+            {
+                _insert_new(live[i].key, live[i].value);
+            }
+            EndTemporaryMemory(temp);
+            return;
+        }
+
+        _allocate(slots);
+        for(u32 i = 0; i < oldCapacity; ++i)
+        {
+            if(!(oldCtrl[i] & 0x80))
+            {
+                _insert_new(oldSlots[i].key, oldSlots[i].value);
+            }
+        }
     }
 
-    u32 _make(u64 key)
+    // NOTE(james): the key must not already be in the table
+    u32 _insert_new(u64 key, const T& value)
     {
-        const find_result fr = _find(key);
-        u32 index = _add_entry(key);
+        if(_growth_left == 0)
+        {
+            // lots of deleted slots means we can get the room back without growing
+            u32 slots = (_deleted >= _capacity/4) ? _capacity : _capacity*2;
+            _rehash(slots);
+        }
 
-        if(fr.prev_entry_index == end_pos)
+        u64 hash = _hash(key);
+        u32 index = _find_insert_slot(hash);
+        if(_ctrl[index] == ctrl_deleted)
         {
-            _keys[fr.hash_index] = index;
+            --_deleted;
         }
         else
         {
-            _entries[fr.prev_entry_index].next_idx = index;
+            --_growth_left;
         }
-
-        _entries[index].next = fr.entry_index;  // NOTE(james): this should be end_pos
+        _ctrl[index] = _h2(hash);
+        _slots[index].key = key;
+        _slots[index].value = value;
+        ++_size;
         return index;
     }
 
-    u32 _find_or_make(u64 key)
+    void _erase_index(u32 index)
     {
-        const find_result fr = _find(key);
-        if(fr.entry_index != end_pos)
-            return fr.entry_index;
-
-        u32 index = _add_entry(key);
+        ASSERT(index < _capacity && !(_ctrl[index] & 0x80));
 
-        if(fr.prev_entry_index == end_pos)
+        // NOTE(james): a group with an empty slot has never been probed past, so the
+        // slot can go straight back to empty.  Otherwise leave a marker so lookups
+        // keep going.
+        u32 groupStart = index & ~(group_width - 1);
+        if(_match_empty(_group(groupStart)))
         {
-            _keys[fr.hash_index] = index;
+            _ctrl[index] = ctrl_empty;
+            ++_growth_left;
         }
         else
         {
-            _entries[fr.prev_entry_index].next_idx = index;
+            _ctrl[index] = ctrl_deleted;
+            ++_deleted;
         }
-
-        return index;
+        --_size;
     }
 
-    void _find_and_erase(u64 key)
+    u32 _next_full(u32 index) const
     {
-        const find_result fr = _find(key);
-        if(fr.entry_index != end_pos)
+        while(index < _capacity && (_ctrl[index] & 0x80))
         {
-            _erase(fr);
+            ++index;
         }
+        return index;
     }
     
-    b32 contains(u64 key)
+    b32 contains(u64 key) const
     {
-        return _find_or_fail(key) != end_pos;
+        return _find(key) != end_pos;
     }
     
     T& get(u64 key)
     {
-        u32 index = _find_or_fail(key);
+        u32 index = _find(key);
         ASSERT(index != end_pos);
-        return index == end_pos ? default_value : _entries[index].value;
+        return index == end_pos ? default_value : _slots[index].value;
     }
 
     const T& get(u64 key) const
     {
-        u32 index = _find_or_fail(key);
+        u32 index = _find(key);
         ASSERT(index != end_pos);
-        return index == end_pos ? default_value : _entries[index].value;
+        return index == end_pos ? default_value : _slots[index].value;
     }
 
-    b32 try_get(u64 key, T* value)
+    b32 try_get(u64 key, T* value) const
     {
-        u32 index = _find_or_fail(key);
+        u32 index = _find(key);
         if(index != end_pos)
         {
-            *value = _entries[index].value;
+            *value = _slots[index].value;
             return true;
         }
 
@@ -396,37 +831,55 @@ struct hashtable
     
     void set(u64 key, const T& value)
     {
-        u32 index = _find_or_make(key);
-        _entries[index].value = value;
+        u32 index = _find(key);
+        if(index != end_pos)
+        {
+            _slots[index].value = value;
+        }
+        else
+        {
+            _insert_new(key, value);
+        }
     }
 
     void erase(u64 key)
     {
-        _find_and_erase(key);
+        u32 index = _find(key);
+        if(index != end_pos)
+        {
+            _erase_index(index);
+        }
+    }
+
+    // NOTE(james): returns the next entry so you can erase while iterating
+    iterator erase(iterator it)
+    {
+        _erase_index(it._index);
+        return iterator{ this, _next_full(it._index + 1) };
     }
 
-    entry* erase(entry* e)
+    // NOTE(james): makes sure count entries fit without growing in the middle of something
+    void reserve(u32 count)
     {
-        _find_and_erase(e->key);
-        // NOTE(james): this erase will happen in place, so the
-        // "next" entry in the list is now in the same address
-        return e;
+        if(count > _size + _growth_left)
+        {
+            _rehash(_slots_for(count));
+        }
     }
 
     void clear() 
     {
-        for(u32 i = 0; i < _entries.capacity(); ++i) 
-            _keys[i] = end_pos;
-        _entries.clear(); 
+        _reset_ctrl();
     }
 
-    b32 full() { return _entries.full(); }
+    // NOTE(james): the table grows as needed, so this is only true while at max load
+    b32 full() const { return _growth_left == 0; }
 
-    entry* begin() { return _entries.begin(); }
-    entry* end() { return _entries.end(); }
+    iterator begin() { return iterator{ this, _next_full(0) }; }
+    iterator end() { return iterator{ this, _capacity }; }
 
-    u32 capacity() { return _entries.capacity(); }
-    u32 size() { return _entries.size(); }
+    u32 capacity() const { return _size + _growth_left; }
+    u32 size() const { return _size; }
 
     // NOTE(james): I'm intentionally leaving these out of the struct...
     //  I want the user to be aware whenever the hash table will add
@@ -434,8 +887,12 @@ struct hashtable
     #if 0
     T& operator[](u64 key)
     {
-        u32 index = _find_or_make(key);
-        return _entries[index].value;
+        u32 index = _find(key);
+        if(index == end_pos)
+        {
+            index = _insert_new(key, T{});
+        }
+        return _slots[index].value;
     }
     
     const T& operator[](u64 key) const
@@ -445,99 +902,1037 @@ struct hashtable
     #endif
 };
 
-namespace sort
+// NOTE(james): Struct of arrays.  Each field type gets its own column, allocated from the
+// arena with (at least) 32 byte alignment so SIMD loops can use aligned loads, and each
+// column can be pulled out on its own as a slice.  Fields are looked up by index, so
+// name them with an enum:
+//
+//      enum { Position, Velocity, Radius };
+//      soa_array<v3, v3, f32>& particles = *soa_array<v3, v3, f32>::create(arena, 1024);
+//      particles.push_back(pos, vel, 1.0f);
+//      for(v3& p : particles.column<Position>()) { ... }
+//
+// Same rules as array<T>, fixed capacity (only ASSERTed) and erase() moves the last
+// element into the hole.
+template<u32 I, typename T, typename... Rest>
+struct _soa_type_at { typedef typename _soa_type_at<I-1, Rest...>::type type; };
+template<typename T, typename... Rest>
+struct _soa_type_at<0, T, Rest...> { typedef T type; };
+
+template<typename... Fields>
+struct soa_array
 {
-    template<typename T> struct comparer {
-         static bool lessthan(const T& a, const T& b) { return a < b; }
+    enum : u32 { 
+        field_count = sizeof...(Fields),
+        column_alignment = 32
     };
 
-    template<typename T, typename FNCOMPARE>
-    void quickSort(slice<T> slice, FNCOMPARE compare)
+    template<u32 I> using field_type = typename _soa_type_at<I, Fields...>::type;
+
+    void* _columns[field_count];
+    u32 _size;
+    u32 _capacity;
+
+    static soa_array<Fields...>* create(memory_arena& arena, u32 capacity)
+    {
+        soa_array<Fields...>* arr = PushStruct(arena, soa_array<Fields...>);
+        arr->_capacity = capacity;
+        arr->template _allocate_columns<0>(arena);
+        return arr;
+    }
+
+    template<u32 I>
+    void _allocate_columns(memory_arena& arena)
     {
-        // {5, 7, 3, 1, 0, 9, 2, 4, 8, 6}
-        if(slice.size() > 1)
+        if constexpr(I < field_count)
         {
-            // get the pivot item
-            T& pivot = slice.back();
+            typedef field_type<I> T;
+            u32 alignment = alignof(T) > column_alignment ? alignof(T) : column_alignment;
+            _columns[I] = _capacity ? PushArray(arena, _capacity, T, Align(alignment, true)) : 0;
+            _allocate_columns<I+1>(arena);
+        }
+    }
 
-            u32 indexSmaller = 0;
-            for(u32 j = 0; j < slice.size()-1; ++j)
-            {
-                if(compare(slice[j], pivot))
-                {
-                    slice.swap(indexSmaller++, j);
-                }
-            }
+    template<u32 I> field_type<I>* data() { return (field_type<I>*)_columns[I]; }
+    template<u32 I> const field_type<I>* data() const { return (const field_type<I>*)_columns[I]; }
+
+    template<u32 I> slice<field_type<I>> column() { return make_slice(data<I>(), _size); }
+
+    template<u32 I> field_type<I>& get(u32 index) { ASSERT(index < _size); return data<I>()[index]; }
+    template<u32 I> const field_type<I>& get(u32 index) const { ASSERT(index < _size); return data<I>()[index]; }
+
+    u32 size() const { return _size; }
+    u32 capacity() const { return _capacity; }
+    b32 empty() const { return _size == 0; }
+    b32 full() const { return _size == _capacity; }
 
-            u32 pivotIndex = indexSmaller;
-            slice.swap(pivotIndex, slice.size()-1);
+    void set_size(u32 size) { ASSERT(size <= _capacity); _size = size; }
+    void clear() { _size = 0; }
 
-            quickSort(slice.slice_leftof(pivotIndex), compare);
-            quickSort(slice.slice_rightof(pivotIndex + 1), compare);
+    template<u32 I, typename T, typename... Rest>
+    void _set(u32 index, const T& value, const Rest&... rest)
+    {
+        data<I>()[index] = value;
+        if constexpr(sizeof...(Rest) > 0)
+        {
+            _set<I+1>(index, rest...);
         }
     }
 
-    template<typename T, typename FNCOMPARE>
-    void quickSort(array<T>& collection, FNCOMPARE compare)
+    // NOTE(james): one value per field, in field order
+    u32 push_back(const Fields&... values)
     {
-        quickSort(collection.to_slice(), compare);
+        ASSERT(_size+1 <= _capacity);
+        u32 index = _size++;
+        _set<0>(index, values...);
+        return index;
     }
 
-    template<typename T>
-    void quickSort(array<T>& collection)
+    void set(u32 index, const Fields&... values)
     {
-        quickSort(collection.to_slice(), comparer<T>::lessthan);
+        ASSERT(index < _size);
+        _set<0>(index, values...);
     }
 
-    template<typename T, typename FNCOMPARE>
-    void _heapify(slice<T> slice, u32 root, FNCOMPARE compare)
+    template<u32 I>
+    void _move(u32 dstIndex, u32 srcIndex)
     {
-        // find the largest root, left child and right child
-        u32 largest = root;
-        u32 left = 2 * root + 1;
-        u32 right = 2 * root + 2;
-
-        if(left < slice.size() && compare(slice[largest], slice[left]))
+        if constexpr(I < field_count)
         {
-            largest = left;
+            data<I>()[dstIndex] = data<I>()[srcIndex];
+            _move<I+1>(dstIndex, srcIndex);
         }
+    }
 
-        if(right < slice.size() && compare(slice[largest], slice[right]))
+    template<u32 I>
+    void _swap(u32 indexA, u32 indexB)
+    {
+        if constexpr(I < field_count)
         {
-            largest = right;
+            field_type<I> a = data<I>()[indexA];
+            data<I>()[indexA] = data<I>()[indexB];
+            data<I>()[indexB] = a;
+            _swap<I+1>(indexA, indexB);
         }
+    }
 
-        if(largest != root)
-        {
-            // swap and recursively heapify if the root is not the largest
-            slice.swap(largest, root);
-            _heapify(slice, largest, compare);
-        }
+    void swap(u32 indexA, u32 indexB)
+    {
+        ASSERT(indexA < _size && indexB < _size);
+        _swap<0>(indexA, indexB);
     }
 
-    template<typename T, typename FNCOMPARE>
-    void heapSort(array<T>& collection, FNCOMPARE compare)
+    void erase(u32 index)
     {
-        // build max heap
-        for(i32 i = collection.size() / 2 - 1; i >= 0; --i)
+        ASSERT(_size > 0);
+        ASSERT(index < _size);
+        u32 lastIndex = --_size;
+        if(index != lastIndex)
         {
-            _heapify(collection.to_slice(), i, compare);
+            // NOTE(james): move the last element into the erased spot, every column
+            _move<0>(index, lastIndex);
         }
+    }
+};
 
-        // actually sort
-        for(i32 i = collection.size()-1; i > 0; --i)
-        {
-            collection.swap(0, i);
+#define bucket_array_create(arena, type, ...) bucket_array<type>::create(arena, ## __VA_ARGS__)
 
-            // heapify the root to get the next largest item
-            _heapify(collection.slice_leftof(i), 0, compare);
+// NOTE(james): Grows a bucket at a time from the arena it was created on, elements never
+// move, so pointers to them stay good until the arena is cleared.  Indexing is a shift and
+// a mask.  Removed elements go on a free list that add() pulls from before growing,
+// push_back() always appends.
+// Iterating skips removed elements, or walk bucket(i) to get each bucket's elements as a
+// slice (removed ones included, check is_occupied if you've been removing).
+template<typename T>
+struct bucket_array
+{
+    enum : u32 { 
+        end_pos = U32MAX,
+        default_bucket_shift = 6
+    };
+
+    struct iterator
+    {
+        bucket_array<T>* _array;
+        u32 _index;
+
+        T& operator*() { return (*_array)[_index]; }
+        T* operator->() { return &(*_array)[_index]; }
+        iterator& operator++() { _index = _array->_next_occupied(_index + 1); return *this; }
+        bool operator==(const iterator& other) const { return _index == other._index; }
+        bool operator!=(const iterator& other) const { return _index != other._index; }
+    };
+
+    memory_arena* _arena;
+    T** _buckets;
+    u64** _occupied;        // one bit per element, 64 elements a word
+    u32 _bucketCount;
+    u32 _bucketCapacity;    // size of the bucket directory
+    u32 _bucketShift;
+    u32 _size;              // elements handed out, removed ones included
+    u32 _count;             // live elements
+    u32 _freeHead;
+
+    // NOTE(james): bucketShift gives 2^bucketShift elements a bucket, 64 at the least
+    static bucket_array<T>* create(memory_arena& arena, u32 bucketShift = default_bucket_shift)
+    {
+        ASSERT(bucketShift >= 6 && bucketShift < 32);
+        bucket_array<T>* arr = PushStruct(arena, bucket_array<T>);
+        arr->_arena = &arena;
+        arr->_bucketShift = bucketShift;
+        arr->_freeHead = end_pos;
+        return arr;
+    }
+
+    u32 bucket_size() const { return 1u << _bucketShift; }
+    u32 _bucket_mask() const { return bucket_size() - 1; }
+
+    void _add_bucket()
+    {
+        if(_bucketCount == _bucketCapacity)
+        {
+            // NOTE(james): only the directory of bucket pointers ever gets copied, the old
+            // one is left on the arena
+            u32 newCapacity = _bucketCapacity ? _bucketCapacity*2 : 8;
+            T** buckets = PushArray(*_arena, newCapacity, T*, NoClear());
+            u64** occupied = PushArray(*_arena, newCapacity, u64*, NoClear());
+            if(_bucketCount)
+            {
+                CopyArray(_bucketCount, _buckets, buckets);
+                CopyArray(_bucketCount, _occupied, occupied);
+            }
+            _buckets = buckets;
+            _occupied = occupied;
+            _bucketCapacity = newCapacity;
+        }
+
+        _buckets[_bucketCount] = PushArray(*_arena, bucket_size(), T, Align(alignof(T) > 16 ? alignof(T) : 16, false));
+        _occupied[_bucketCount] = PushArray(*_arena, bucket_size() / 64, u64);
+        ++_bucketCount;
+    }
+
+    b32 is_occupied(u32 index) const
+    {
+        ASSERT(index < _size);
+        u32 local = index & _bucket_mask();
+        return (_occupied[index >> _bucketShift][local >> 6] >> (local & 63)) & 1;
+    }
+
+    void _set_occupied(u32 index, b32 occupied)
+    {
+        u32 local = index & _bucket_mask();
+        u64& word = _occupied[index >> _bucketShift][local >> 6];
+        u64 bit = 1ull << (local & 63);
+        word = occupied ? (word | bit) : (word & ~bit);
+    }
+
+    u32 _next_occupied(u32 index) const
+    {
+        while(index < _size)
+        {
+            u32 local = index & _bucket_mask();
+            u64 word = _occupied[index >> _bucketShift][local >> 6] >> (local & 63);
+            if(word)
+            {
+                // skip straight to the next set bit in this word
+                return index + FindLeastSignificantSetBit(word).Index;
+            }
+            index += 64 - (local & 63);
+        }
+        return _size;
+    }
+
+    T& operator[](u32 index) { ASSERT(index < _size); return _buckets[index >> _bucketShift][index & _bucket_mask()]; }
+    const T& operator[](u32 index) const { ASSERT(index < _size); return _buckets[index >> _bucketShift][index & _bucket_mask()]; }
+    T& at(u32 index) { return (*this)[index]; }
+
+    T* push_back(const T& val, u32* indexOut = 0)
+    {
+        if(_size == (_bucketCount << _bucketShift))
+        {
+            _add_bucket();
+        }
+
+        u32 index = _size++;
+        T* result = &(*this)[index];
+        *result = val;
+        _set_occupied(index, true);
+        ++_count;
+        if(indexOut) *indexOut = index;
+        return result;
+    }
+
+    // NOTE(james): reuses a removed slot if there is one
+    T* add(const T& val, u32* indexOut = 0)
+    {
+        if(_freeHead == end_pos)
+        {
+            return push_back(val, indexOut);
+        }
+
+        u32 index = _freeHead;
+        T* result = &(*this)[index];
+        _freeHead = *(u32*)result;
+        *result = val;
+        _set_occupied(index, true);
+        ++_count;
+        if(indexOut) *indexOut = index;
+        return result;
+    }
+
+    void remove(u32 index)
+    {
+        // NOTE(james): the free list is threaded through the removed elements themselves
+        CompileAssert(sizeof(T) >= sizeof(u32));
+        ASSERT(is_occupied(index));
+        _set_occupied(index, false);
+        *(u32*)&(*this)[index] = _freeHead;
+        _freeHead = index;
+        --_count;
+    }
+
+    // NOTE(james): keeps the buckets for reuse
+    void clear()
+    {
+        for(u32 bucketIndex = 0; bucketIndex < _bucketCount; ++bucketIndex)
+        {
+            ZeroArray(bucket_size() / 64, _occupied[bucketIndex]);
+        }
+        _size = 0;
+        _count = 0;
+        _freeHead = end_pos;
+    }
+
+    u32 size() const { return _size; }
+    u32 count() const { return _count; }
+    b32 empty() const { return _count == 0; }
+    u32 capacity() const { return _bucketCount << _bucketShift; }
+
+    u32 bucket_count() const { return _bucketCount; }
+    slice<T> bucket(u32 bucketIndex)
+    {
+        ASSERT(bucketIndex < _bucketCount);
+        u32 first = bucketIndex << _bucketShift;
+        u32 size = first < _size ? Minimum(bucket_size(), _size - first) : 0;
+        return make_slice(_buckets[bucketIndex], size);
+    }
+
+    iterator begin() { return iterator{ this, _next_occupied(0) }; }
+    iterator end() { return iterator{ this, _size }; }
+};
+
+#define slotmap_create(arena, type, capacity) slotmap<type>::create(arena, capacity)
+
+// NOTE(james): Hands out u64 ids for values kept densely packed in an array.  The low 32
+// bits of an id are the slot index + 1 and the high 32 are the slot's generation, which
+// moves on every time the slot is freed, so an id for something that was erased just
+// stops resolving instead of picking up whatever got the slot next.  Zero is never a
+// valid id.
+// Like array<>, the capacity is fixed at creation and only ASSERTed.
+// erase() moves the last value into the erased spot, so don't hold pointers across it.
+template<typename T>
+struct slotmap
+{
+    enum : u32 { 
+        end_pos = U32MAX
+    };
+
+    struct slot
+    {
+        u32 generation;
+        // NOTE(james): index into _data while alive, next free slot while free
+        u32 index;
+    };
+
+    T default_value;
+    T* _data;
+    u32* _dataToSlot;
+    slot* _slots;
+    u32 _size;
+    u32 _capacity;
+    u32 _freeHead;
+
+    static slotmap<T>* create(memory_arena& arena, u32 capacity)
+    {
+        slotmap<T>* map = PushStruct(arena, slotmap<T>);
+        map->_capacity = capacity;
+        map->_data = PushArray(arena, capacity, T);
+        map->_dataToSlot = PushArray(arena, capacity, u32);
+        map->_slots = PushArray(arena, capacity, slot);
+        map->clear();
+        return map;
+    }
+
+    static u64 _make_id(u32 slotIndex, u32 generation) { return ((u64)generation << 32) | (u64)(slotIndex + 1); }
+    static u32 _slot_index(u64 id) { return (u32)id - 1; }
+    static u32 _generation(u64 id) { return (u32)(id >> 32); }
+
+    u32 _find(u64 id) const
+    {
+        u32 slotIndex = _slot_index(id);
+        if(slotIndex < _capacity && _slots[slotIndex].generation == _generation(id) && (u32)id != 0)
+        {
+            return _slots[slotIndex].index;
+        }
+        return end_pos;
+    }
+
+    u64 insert(const T& value)
+    {
+        ASSERT(_freeHead != end_pos);
+        if(_freeHead == end_pos)
+        {
+            return 0;
+        }
+
+        u32 slotIndex = _freeHead;
+        slot& s = _slots[slotIndex];
+        _freeHead = s.index;
+
+        s.index = _size;
+        _data[_size] = value;
+        _dataToSlot[_size] = slotIndex;
+        ++_size;
+
+        return _make_id(slotIndex, s.generation);
+    }
+
+    b32 contains(u64 id) const
+    {
+        return _find(id) != end_pos;
+    }
+
+    T& get(u64 id)
+    {
+        u32 index = _find(id);
+        ASSERT(index != end_pos);
+        return index == end_pos ? default_value : _data[index];
+    }
+
+    const T& get(u64 id) const
+    {
+        u32 index = _find(id);
+        ASSERT(index != end_pos);
+        return index == end_pos ? default_value : _data[index];
+    }
+
+    b32 try_get(u64 id, T* value) const
+    {
+        u32 index = _find(id);
+        if(index != end_pos)
+        {
+            *value = _data[index];
+            return true;
+        }
+
+        return false;
+    }
+
+    void erase(u64 id)
+    {
+        u32 index = _find(id);
+        if(index == end_pos)
+        {
+            return;
+        }
+
+        u32 slotIndex = _slot_index(id);
+
+        // keep the data packed by moving the last value into the hole
+        u32 lastIndex = --_size;
+        if(index != lastIndex)
+        {
+            _data[index] = _data[lastIndex];
+            _dataToSlot[index] = _dataToSlot[lastIndex];
+            _slots[_dataToSlot[index]].index = index;
+        }
+
+        slot& s = _slots[slotIndex];
+        ++s.generation;
+        s.index = _freeHead;
+        _freeHead = slotIndex;
+    }
+
+    void clear()
+    {
+        // NOTE(james): generations carry on, so ids from before the clear stay dead
+        for(u32 i = 0; i < _size; ++i)
+        {
+            ++_slots[_dataToSlot[i]].generation;
+        }
+        for(u32 i = 0; i < _capacity; ++i)
+        {
+            _slots[i].index = (i + 1 < _capacity) ? i + 1 : end_pos;
+        }
+        _freeHead = _capacity ? 0 : end_pos;
+        _size = 0;
+    }
+
+    u32 size() const { return _size; }
+    u32 capacity() const { return _capacity; }
+    b32 empty() const { return _size == 0; }
+    b32 full() const { return _size == _capacity; }
+
+    T* begin() { return _data; }
+    T* end() { return _data + _size; }
+
+    const T* begin() const { return _data; }
+    const T* end() const { return _data + _size; }
+};
+
+#define mpmc_queue_create(arena, type, capacity) mpmc_queue<type>::create(arena, capacity)
+
+// NOTE(james): Bounded lock-free queue any number of threads can push to and pop from
+// (Dmitry Vyukov's design).  Every cell carries a sequence number that says whose turn
+// it is: a producer may fill cell i once its sequence is i, a consumer may empty it once
+// it's i+1, and emptying it hands it on to the producer one lap later at i+capacity.
+// Threads only contend on the CAS that claims a position, never on a lock, and a thread
+// that gets preempted mid-copy only holds up whoever wants that one cell.
+// Capacity has to be a power of two and is fixed at creation.  push() and pop() return
+// false instead of waiting when the queue is full or empty.
+template<typename T>
+struct mpmc_queue
+{
+    struct cell
+    {
+        u64 volatile sequence;
+        T value;
+    };
+
+    // NOTE(james): producers hammer the enqueue position and consumers the dequeue
+    // position, so they each get their own cache line
+    u64 volatile _enqueuePos;
+    u8 _pad0[56];
+    u64 volatile _dequeuePos;
+    u8 _pad1[56];
+
+    cell* _cells;
+    u64 _mask;
+
+    static mpmc_queue<T>* create(memory_arena& arena, u32 capacity)
+    {
+        ASSERT(capacity >= 2 && IsPow2(capacity));
+        mpmc_queue<T>* queue = PushStruct(arena, mpmc_queue<T>, Align(64, true));
+        queue->_cells = PushArray(arena, capacity, cell, Align(64, false));
+        queue->_mask = capacity - 1;
+        for(u32 i = 0; i < capacity; ++i)
+        {
+            queue->_cells[i].sequence = i;
+        }
+        return queue;
+    }
+
+    b32 push(const T& value)
+    {
+        u64 pos = AtomicLoadAcquireU64(&_enqueuePos);
+        for(;;)
+        {
+            cell* c = &_cells[pos & _mask];
+            u64 sequence = AtomicLoadAcquireU64(&c->sequence);
+            s64 diff = (s64)(sequence - pos);
+            if(diff == 0)
+            {
+                u64 original = AtomicCompareExchangeU64(&_enqueuePos, pos + 1, pos);
+                if(original == pos)
+                {
+                    c->value = value;
+                    AtomicStoreReleaseU64(&c->sequence, pos + 1);
+                    return true;
+                }
+                pos = original;
+            }
+            else if(diff < 0)
+            {
+                // NOTE(james): the cell still holds last lap's value, so we're full
+                return false;
+            }
+            else
+            {
+                // somebody else claimed this position, catch up
+                pos = AtomicLoadAcquireU64(&_enqueuePos);
+            }
+        }
+    }
+
+    b32 pop(T* value)
+    {
+        u64 pos = AtomicLoadAcquireU64(&_dequeuePos);
+        for(;;)
+        {
+            cell* c = &_cells[pos & _mask];
+            u64 sequence = AtomicLoadAcquireU64(&c->sequence);
+            s64 diff = (s64)(sequence - (pos + 1));
+            if(diff == 0)
+            {
+                u64 original = AtomicCompareExchangeU64(&_dequeuePos, pos + 1, pos);
+                if(original == pos)
+                {
+                    *value = c->value;
+                    AtomicStoreReleaseU64(&c->sequence, pos + _mask + 1);
+                    return true;
+                }
+                pos = original;
+            }
+            else if(diff < 0)
+            {
+                // NOTE(james): nothing has been written here yet this lap, so we're empty
+                return false;
+            }
+            else
+            {
+                pos = AtomicLoadAcquireU64(&_dequeuePos);
+            }
+        }
+    }
+
+    // NOTE(james): only a snapshot while other threads are pushing or popping
+    u32 size() const
+    {
+        u64 dequeuePos = AtomicLoadAcquireU64((u64 volatile*)&_dequeuePos);
+        u64 enqueuePos = AtomicLoadAcquireU64((u64 volatile*)&_enqueuePos);
+        return enqueuePos > dequeuePos ? (u32)(enqueuePos - dequeuePos) : 0;
+    }
+    u32 capacity() const { return (u32)_mask + 1; }
+    b32 empty() const { return size() == 0; }
+};
+
+namespace sort
+{
+    template<typename T> struct comparer {
+         static bool lessthan(const T& a, const T& b) { return a < b; }
+    };
+
+    template<typename T, typename FNCOMPARE>
+    void _siftDown(slice<T> slice, u32 root, FNCOMPARE compare)
+    {
+        // NOTE(james): walk the root down until neither child is larger than it
+        for(;;)
+        {
+            u32 largest = root;
+            u32 left = 2 * root + 1;
+            u32 right = 2 * root + 2;
+
+            if(left < slice.size() && compare(slice[largest], slice[left]))
+            {
+                largest = left;
+            }
+
+            if(right < slice.size() && compare(slice[largest], slice[right]))
+            {
+                largest = right;
+            }
+
+            if(largest == root)
+            {
+                break;
+            }
+
+            slice.swap(largest, root);
+            root = largest;
+        }
+    }
+
+    template<typename T, typename FNCOMPARE>
+    void heapSort(slice<T> slice, FNCOMPARE compare)
+    {
+        // build max heap
+        for(i32 i = (i32)slice.size() / 2 - 1; i >= 0; --i)
+        {
+            _siftDown(slice, (u32)i, compare);
+        }
+
+        // actually sort
+        for(i32 i = (i32)slice.size()-1; i > 0; --i)
+        {
+            slice.swap(0, i);
+
+            // sift the new root down to get the next largest item
+            _siftDown(slice.slice_leftof(i), 0, compare);
+        }
+    }
+
+    template<typename T, typename FNCOMPARE>
+    void heapSort(array<T>& collection, FNCOMPARE compare)
+    {
+        heapSort(collection.to_slice(), compare);
+    }
+
+    template<typename T>
+    void heapSort(array<T>& collection)
+    {
+        heapSort(collection.to_slice(), comparer<T>::lessthan);
+    }
+
+    template<typename T, typename FNCOMPARE>
+    void insertionSort(slice<T> slice, FNCOMPARE compare)
+    {
+        for(u32 i = 1; i < slice.size(); ++i)
+        {
+            T item = slice[i];
+            u32 j = i;
+            for(; j > 0 && compare(item, slice[j-1]); --j)
+            {
+                slice[j] = slice[j-1];
+            }
+            slice[j] = item;
+        }
+    }
+
+    // NOTE(james): introsort - quicksort with a median of three pivot, insertion sort
+    // for the small partitions, and a heapsort fallback once the recursion gets deeper
+    // than 2*log2(n), so bad input can't go quadratic.  Only the smaller partition is
+    // recursed into, which keeps the stack to log2(n) frames.
+    enum : u32 { insertion_sort_threshold = 16 };
+
+    template<typename T, typename FNCOMPARE>
+    void _introSort(slice<T> slice, u32 depthLimit, FNCOMPARE compare)
+    {
+        while(slice.size() > insertion_sort_threshold)
+        {
+            if(depthLimit == 0)
+            {
+                heapSort(slice, compare);
+                return;
+            }
+            --depthLimit;
+
+            // order first/middle/last so the median lands in the middle and the ends
+            // act as sentinels for the partition scans
+            u32 last = slice.size() - 1;
+            u32 mid = last / 2;
+            if(compare(slice[mid], slice[0])) slice.swap(mid, 0);
+            if(compare(slice[last], slice[mid]))
+            {
+                slice.swap(last, mid);
+                if(compare(slice[mid], slice[0])) slice.swap(mid, 0);
+            }
+
+            T pivot = slice[mid];
+            u32 i = 0;
+            u32 j = last;
+            for(;;)
+            {
+                do { ++i; } while(compare(slice[i], pivot));
+                do { --j; } while(compare(pivot, slice[j]));
+                if(i >= j)
+                {
+                    break;
+                }
+                slice.swap(i, j);
+            }
+
+            // [0, j] <= pivot <= [j+1, size)
+            auto left = slice.slice_leftof(j + 1);
+            auto right = slice.slice_rightof(j + 1);
+            if(left.size() < right.size())
+            {
+                _introSort(left, depthLimit, compare);
+                slice = right;
+            }
+            else
+            {
+                _introSort(right, depthLimit, compare);
+                slice = left;
+            }
+        }
+
+        insertionSort(slice, compare);
+    }
+
+    template<typename T, typename FNCOMPARE>
+    void introSort(slice<T> slice, FNCOMPARE compare)
+    {
+        u32 depthLimit = 0;
+        for(u32 n = slice.size(); n > 1; n >>= 1)
+        {
+            depthLimit += 2;
+        }
+        _introSort(slice, depthLimit, compare);
+    }
+
+    template<typename T, typename FNCOMPARE>
+    void introSort(array<T>& collection, FNCOMPARE compare)
+    {
+        introSort(collection.to_slice(), compare);
+    }
+
+    template<typename T>
+    void introSort(array<T>& collection)
+    {
+        introSort(collection.to_slice(), comparer<T>::lessthan);
+    }
+
+    // NOTE(james): kept for the existing callers, it's an introsort now
+    template<typename T, typename FNCOMPARE>
+    void quickSort(slice<T> slice, FNCOMPARE compare)
+    {
+        introSort(slice, compare);
+    }
+
+    template<typename T, typename FNCOMPARE>
+    void quickSort(array<T>& collection, FNCOMPARE compare)
+    {
+        introSort(collection.to_slice(), compare);
+    }
+
+    template<typename T>
+    void quickSort(array<T>& collection)
+    {
+        introSort(collection.to_slice(), comparer<T>::lessthan);
+    }
+
+    // NOTE(james): LSD radix sort, a byte at a time.  Works on plain u32/u64 keys, or on
+    // any struct with a u32/u64 "key" member (draw items, sort key + index pairs...) where
+    // the rest of the struct rides along as payload.  Stable.
+    // The ping-pong buffer comes off the arena and is given back before returning.
+    inline u32 _radixKey(u32 item) { return item; }
+    inline u64 _radixKey(u64 item) { return item; }
+    template<typename T> inline auto _radixKey(const T& item) { return item.key; }
+
+    template<typename T>
+    void radixSort(slice<T> items, memory_arena& scratch)
+    {
+        typedef decltype(_radixKey(items[0])) key_type;
+        CompileAssert(sizeof(key_type) == 4 || sizeof(key_type) == 8);
+        enum : u32 { digit_count = sizeof(key_type) };
+
+        u32 count = items.size();
+        if(count <= insertion_sort_threshold)
+        {
+            insertionSort(items, [](const T& a, const T& b) { return _radixKey(a) < _radixKey(b); });
+            return;
+        }
+
+        temporary_memory temp = BeginTemporaryMemory(scratch);
+
+        // one read pass builds the histograms for every digit
+        u32* histograms = PushArray(scratch, 256 * digit_count, u32);
+        for(u32 i = 0; i < count; ++i)
+        {
+            key_type key = _radixKey(items._data[i]);
+            for(u32 digit = 0; digit < digit_count; ++digit)
+            {
+                ++histograms[digit*256 + ((key >> (digit*8)) & 0xFF)];
+            }
+        }
+
+        T* src = items._data;
+        T* dst = PushArray(scratch, count, T, NoClear());
+        for(u32 digit = 0; digit < digit_count; ++digit)
+        {
+            u32* histogram = histograms + digit*256;
+            u32 shift = digit*8;
+
+            // every key has the same byte here, so this pass wouldn't move anything
+            if(histogram[(_radixKey(src[0]) >> shift) & 0xFF] == count)
+            {
+                continue;
+            }
+
+            u32 offset = 0;
+            for(u32 bucket = 0; bucket < 256; ++bucket)
+            {
+                u32 bucketCount = histogram[bucket];
+                histogram[bucket] = offset;
+                offset += bucketCount;
+            }
+
+            for(u32 i = 0; i < count; ++i)
+            {
+                dst[histogram[(_radixKey(src[i]) >> shift) & 0xFF]++] = src[i];
+            }
+
+            T* swap = src;
+            src = dst;
+            dst = swap;
+        }
+
+        if(src != items._data)
+        {
+            CopyArray(count, src, items._data);
+        }
+
+        EndTemporaryMemory(temp);
+    }
+
+    template<typename T>
+    void radixSort(array<T>& collection, memory_arena& scratch)
+    {
+        radixSort(collection.to_slice(), scratch);
+    }
+
+    // NOTE(james): Parallel version of radixSort, same results.  The items are cut into
+    // fixed chunks (independent of how many workers there are, so the output never
+    // changes) and every digit pass is a parallel count of each chunk, a serial prefix
+    // sum over the chunk histograms, and a parallel scatter.  Chunk order is kept in the
+    // offsets, so it's still stable.
+    // Everything it needs comes off the arena, the calling thread helps run the work
+    // while it waits.
+    enum : u32 {
+        parallel_sort_min_items = 64*1024,      // below this the serial sort wins
+        parallel_sort_chunk_items = 32*1024,
+        parallel_sort_max_chunks = 64
+    };
+
+    template<typename T>
+    struct _parallel_radix_chunk
+    {
+        T* src;
+        T* dst;
+        u32 first;
+        u32 count;
+        u32 digit;
+        // NOTE(james): 256 counts per digit, turned into write offsets before the scatter
+        u32* histograms;
+    };
+
+    template<typename T>
+    PLATFORM_WORK_QUEUE_CALLBACK(_parallelRadixCountAll)
+    {
+        _parallel_radix_chunk<T>& chunk = *(_parallel_radix_chunk<T>*)data;
+        typedef decltype(_radixKey(*chunk.src)) key_type;
+
+        for(u32 i = chunk.first; i < chunk.first + chunk.count; ++i)
+        {
+            key_type key = _radixKey(chunk.src[i]);
+            for(u32 digit = 0; digit < sizeof(key_type); ++digit)
+            {
+                ++chunk.histograms[digit*256 + ((key >> (digit*8)) & 0xFF)];
+            }
+        }
+    }
+
+    template<typename T>
+    PLATFORM_WORK_QUEUE_CALLBACK(_parallelRadixCount)
+    {
+        _parallel_radix_chunk<T>& chunk = *(_parallel_radix_chunk<T>*)data;
+        u32* histogram = chunk.histograms + chunk.digit*256;
+        u32 shift = chunk.digit*8;
+
+        ZeroArray(256, histogram);
+        for(u32 i = chunk.first; i < chunk.first + chunk.count; ++i)
+        {
+            ++histogram[(_radixKey(chunk.src[i]) >> shift) & 0xFF];
+        }
+    }
+
+    template<typename T>
+    PLATFORM_WORK_QUEUE_CALLBACK(_parallelRadixScatter)
+    {
+        _parallel_radix_chunk<T>& chunk = *(_parallel_radix_chunk<T>*)data;
+        u32* offsets = chunk.histograms + chunk.digit*256;
+        u32 shift = chunk.digit*8;
+
+        for(u32 i = chunk.first; i < chunk.first + chunk.count; ++i)
+        {
+            chunk.dst[offsets[(_radixKey(chunk.src[i]) >> shift) & 0xFF]++] = chunk.src[i];
+        }
+    }
+
+    template<typename T>
+    void _parallelRadixRun(platform_work_queue* queue, platform_work_queue_callback* callback, _parallel_radix_chunk<T>* chunks, u32 chunkCount)
+    {
+        platform_work_counter counter = {};
+        for(u32 chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex)
+        {
+            Platform.AddCountedWorkEntry(queue, callback, chunks + chunkIndex, &counter);
+        }
+        Platform.CompleteCounterWork(queue, &counter);
+    }
+
+    template<typename T>
+    void parallelRadixSort(platform_work_queue* queue, slice<T> items, memory_arena& arena)
+    {
+        typedef decltype(_radixKey(items[0])) key_type;
+        enum : u32 { digit_count = sizeof(key_type) };
+
+        u32 count = items.size();
+        if(count < parallel_sort_min_items)
+        {
+            radixSort(items, arena);
+            return;
+        }
+
+        temporary_memory temp = BeginTemporaryMemory(arena);
+
+        u32 chunkCount = Minimum((count + parallel_sort_chunk_items - 1) / parallel_sort_chunk_items, (u32)parallel_sort_max_chunks);
+        u32 chunkSize = (count + chunkCount - 1) / chunkCount;
+
+        T* src = items._data;
+        T* dst = PushArray(arena, count, T, NoClear());
+        _parallel_radix_chunk<T>* chunks = PushArray(arena, chunkCount, _parallel_radix_chunk<T>);
+        for(u32 chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex)
+        {
+            _parallel_radix_chunk<T>& chunk = chunks[chunkIndex];
+            chunk.first = chunkIndex*chunkSize;
+            chunk.count = Minimum(chunkSize, count - Minimum(count, chunk.first));
+            chunk.histograms = PushArray(arena, 256*digit_count, u32, Align(64, true));
+            chunk.src = src;
+        }
+
+        // the first count gets every digit at once, the totals don't depend on the order so
+        // they tell us which passes can be skipped, and the counts are right for the first pass
+        _parallelRadixRun(queue, &_parallelRadixCountAll<T>, chunks, chunkCount);
+
+        b32 firstPass = true;
+        for(u32 digit = 0; digit < digit_count; ++digit)
+        {
+            u32 bucket0 = (_radixKey(src[0]) >> (digit*8)) & 0xFF;
+            u32 sameDigitCount = 0;
+            for(u32 chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex)
+            {
+                sameDigitCount += chunks[chunkIndex].histograms[digit*256 + bucket0];
+            }
+            if(sameDigitCount == count)
+            {
+                continue;
+            }
+
+            for(u32 chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex)
+            {
+                chunks[chunkIndex].src = src;
+                chunks[chunkIndex].dst = dst;
+                chunks[chunkIndex].digit = digit;
+            }
+
+            if(!firstPass)
+            {
+                _parallelRadixRun(queue, &_parallelRadixCount<T>, chunks, chunkCount);
+            }
+            firstPass = false;
+
+            // bucket major, chunk minor, so equal keys keep their chunk order
+            u32 offset = 0;
+            for(u32 bucket = 0; bucket < 256; ++bucket)
+            {
+                for(u32 chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex)
+                {
+                    u32& slot = chunks[chunkIndex].histograms[digit*256 + bucket];
+                    u32 bucketCount = slot;
+                    slot = offset;
+                    offset += bucketCount;
+                }
+            }
+
+            _parallelRadixRun(queue, &_parallelRadixScatter<T>, chunks, chunkCount);
+
+            T* swap = src;
+            src = dst;
+            dst = swap;
+        }
+
+        if(src != items._data)
+        {
+            CopyArray(count, src, items._data);
         }
+
+        EndTemporaryMemory(temp);
     }
 
     template<typename T>
-    void heapSort(array<T>& collection)
+    void parallelRadixSort(platform_work_queue* queue, array<T>& collection, memory_arena& arena)
     {
-        heapSort(collection, comparer<T>::lessthan);
+        parallelRadixSort(queue, collection.to_slice(), arena);
     }
 };
 
@@ -583,7 +1978,25 @@ b32 TestArray()
     
     while(!arr.empty()) next = arr.erase(next);
 
+    EXPECT(arr.try_grow(scratch, 20));
+    EXPECT(arr.capacity() == 20);
+    PushStruct(scratch, u32);
+    EXPECT(!arr.try_grow(scratch, 30));
+    EXPECT(arr.capacity() == 20);
+
     Clear(scratch);
+
+    memory_arena reserved = {};
+    reserved.allocationFlags = PlatformMemoryFlags::NotRestored|PlatformMemoryFlags::ReserveOnly;
+    SetMinimumBlockSize(reserved, Megabytes(64));
+    array<u32>& big = *array_create(reserved, u32, 16);
+    EXPECT(big.try_grow(reserved, 1024*1024));
+    big.set_size(big.capacity());
+    big.back() = 42;
+    EXPECT(big[0] == 0);
+    EXPECT(big.back() == 42);
+
+    Clear(reserved);
     return true;
 }
 
@@ -610,6 +2023,12 @@ struct test_sort_item
 };
 #define TESTSORTITEM(name) { C_HASH(name), #name }
 
+struct test_radix_item
+{
+    u32 key;
+    u32 index;
+};
+
 b32 TestSort()
 {
     memory_arena scratch = {};
@@ -645,6 +2064,51 @@ b32 TestSort()
         prevItem = it;
     }
 
+    // sorted, reversed, all the same and pseudo random input, big enough to
+    // get past the insertion sort cutoff
+    const u32 count = 5000;
+    array<u32>& keys = *array_create(scratch, u32, count);
+    array<u64>& keys64 = *array_create(scratch, u64, count);
+    array<test_radix_item>& items = *array_create(scratch, test_radix_item, count);
+    for(u32 pattern = 0; pattern < 4; ++pattern)
+    {
+        keys.clear();
+        keys64.clear();
+        items.clear();
+        u32 random = 12345;
+        for(u32 i = 0; i < count; ++i)
+        {
+            random = random * 1664525 + 1013904223;
+            u32 key = pattern == 0 ? i : pattern == 1 ? count - i : pattern == 2 ? 7 : random;
+            keys.push_back(key);
+            keys64.push_back(((u64)key << 32) | (key >> 3));
+            items.push_back(test_radix_item{ key & 0xFFFF, i });
+        }
+
+        array<u32>& introKeys = *array_create(scratch, u32, count);
+        introKeys.set_size(count);
+        CopyArray(count, keys.data(), introKeys.data());
+        sort::introSort(introKeys);
+        array<u32>& heapKeys = *array_create(scratch, u32, count);
+        heapKeys.set_size(count);
+        CopyArray(count, keys.data(), heapKeys.data());
+        sort::heapSort(heapKeys);
+
+        sort::radixSort(keys, scratch);
+        sort::radixSort(keys64, scratch);
+        sort::radixSort(items, scratch);
+
+        for(u32 i = 1; i < count; ++i)
+        {
+            EXPECT(keys[i-1] <= keys[i]);
+            EXPECT(keys64[i-1] <= keys64[i]);
+            EXPECT(introKeys[i] == keys[i]);
+            EXPECT(heapKeys[i] == keys[i]);
+            // radix sort is stable, so the payload breaks ties in input order
+            EXPECT(items[i-1].key < items[i].key || (items[i-1].key == items[i].key && items[i-1].index < items[i].index));
+        }
+    }
+
     Clear(scratch);
     return true;
 }
@@ -654,6 +2118,7 @@ b32 TestHashTable()
     memory_arena scratch = {};
 
     auto& ht = *hashtable_create(scratch, u64, 1024);
+    EXPECT(ht.capacity() >= 1024);
     for(u64 i = 0; i < 1024; ++i)
     {
         ht.set(i, i);
@@ -670,20 +2135,711 @@ b32 TestHashTable()
     EXPECT(ht.contains(68));
     EXPECT(ht.contains(81));
 
+    u64 value = 0;
+    EXPECT(!ht.try_get(40, &value));
+    EXPECT(ht.try_get(81, &value) && value == 81);
+    ht.set(81, 1000);
+    EXPECT(ht.get(81) == 1000);
+    EXPECT(ht.size() == 1023);
+
+    u32 visited = 0;
+    for(auto& e : ht)
+    {
+        EXPECT(e.key != 40);
+        ++visited;
+    }
+    EXPECT(visited == ht.size());
+
     ht.clear();
     EXPECT(ht.size() == 0);
+    EXPECT(!ht.contains(81));
+
+    // grows past what it was created with
+    auto& grow = *hashtable_create(scratch, u64, 16);
+    for(u64 i = 0; i < 5000; ++i)
+    {
+        grow.set(HASH(i), i);
+    }
+    EXPECT(grow.size() == 5000);
+    for(u64 i = 0; i < 5000; ++i)
+    {
+        EXPECT(grow.contains(HASH(i)) && grow.get(HASH(i)) == i);
+    }
+
+    // churn leaves deleted markers behind, which should get swept instead of growing
+    u32 capacityBefore = grow.capacity();
+    for(u64 i = 0; i < 20000; ++i)
+    {
+        grow.erase(HASH(i));
+        grow.set(HASH(i + 5000), i + 5000);
+    }
+    EXPECT(grow.size() == 5000);
+    EXPECT(grow.capacity() <= capacityBefore*2);
+    for(u64 i = 20000; i < 25000; ++i)
+    {
+        EXPECT(grow.get(HASH(i)) == i);
+    }
+
+    for(auto it = grow.begin(); it != grow.end(); )
+    {
+        it = (it->value & 1) ? grow.erase(it) : ++it;
+    }
+    EXPECT(grow.size() == 2500);
+
+    Clear(scratch);
+    return true;
+}
+
+b32 TestSlotMap()
+{
+    memory_arena scratch = {};
+
+    auto& map = *slotmap_create(scratch, u32, 64);
+    EXPECT(map.empty());
+    EXPECT(!map.contains(0));
+
+    u64 ids[64];
+    for(u32 i = 0; i < 64; ++i)
+    {
+        ids[i] = map.insert(i);
+        EXPECT(ids[i] != 0);
+    }
+    EXPECT(map.full());
+    for(u32 i = 0; i < 64; ++i)
+    {
+        EXPECT(map.get(ids[i]) == i);
+    }
+
+    map.erase(ids[10]);
+    map.erase(ids[63]);
+    EXPECT(map.size() == 62);
+    EXPECT(!map.contains(ids[10]));
+    EXPECT(map.get(ids[40]) == 40);
+
+    // the freed slot gets reused, but the old id must not see the new value
+    u64 reused = map.insert(1000);
+    EXPECT(reused != ids[10] && reused != ids[63]);
+    EXPECT(!map.contains(ids[10]) && !map.contains(ids[63]));
+    u32 value = 0;
+    EXPECT(!map.try_get(ids[10], &value));
+    EXPECT(map.try_get(reused, &value) && value == 1000);
+
+    u32 sum = 0;
+    for(u32 it : map)
+    {
+        sum += it;
+    }
+    EXPECT(sum == (63*64/2) - 10 - 63 + 1000);
+
+    map.clear();
+    EXPECT(map.size() == 0);
+    EXPECT(!map.contains(reused));
+    EXPECT(!map.contains(ids[5]));
+
+    Clear(scratch);
+    return true;
+}
+
+b32 TestBucketArray()
+{
+    memory_arena scratch = {};
+
+    auto& arr = *bucket_array_create(scratch, u32);
+    EXPECT(arr.empty());
+
+    u32* first = arr.push_back(0);
+    for(u32 i = 1; i < 1000; ++i)
+    {
+        u32 index = 0;
+        arr.push_back(i, &index);
+        EXPECT(index == i);
+
+        // something else landing on the arena between buckets must not matter
+        PushStruct(scratch, u64);
+    }
+    EXPECT(arr.size() == 1000);
+    EXPECT(arr.bucket_count() == (1000 + arr.bucket_size() - 1) / arr.bucket_size());
+    EXPECT(first == &arr[0] && *first == 0);
+    for(u32 i = 0; i < 1000; ++i)
+    {
+        EXPECT(arr[i] == i);
+    }
+
+    u32 total = 0;
+    for(u32 bucketIndex = 0; bucketIndex < arr.bucket_count(); ++bucketIndex)
+    {
+        for(u32 it : arr.bucket(bucketIndex))
+        {
+            total += it;
+        }
+    }
+    EXPECT(total == 999*1000/2);
+
+    arr.remove(5);
+    arr.remove(500);
+    arr.remove(63);
+    arr.remove(64);
+    EXPECT(arr.count() == 996);
+    EXPECT(!arr.is_occupied(500));
+
+    u32 visited = 0;
+    total = 0;
+    for(u32 it : arr)
+    {
+        ++visited;
+        total += it;
+    }
+    EXPECT(visited == 996);
+    EXPECT(total == 999*1000/2 - 5 - 500 - 63 - 64);
+
+    // removed slots get reused before it grows
+    u32 index = 0;
+    u32* reused = arr.add(7777, &index);
+    EXPECT(index == 64 && reused == &arr[64]);
+    arr.add(8888, &index);
+    EXPECT(index == 63);
+    EXPECT(arr.size() == 1000 && arr.count() == 998);
+
+    arr.clear();
+    EXPECT(arr.empty() && arr.size() == 0);
+    EXPECT(arr.begin() == arr.end());
+
+    Clear(scratch);
+    return true;
+}
+
+b32 TestSoaArray()
+{
+    memory_arena scratch = {};
+
+    enum { Position, Radius, Id };
+    typedef soa_array<v4, f32, u16> test_soa;
+    test_soa& arr = *test_soa::create(scratch, 100);
+    EXPECT(arr.capacity() == 100);
+    EXPECT(((umm)arr.data<Position>() & 31) == 0);
+    EXPECT(((umm)arr.data<Radius>() & 31) == 0);
+    EXPECT(((umm)arr.data<Id>() & 31) == 0);
+
+    for(u32 i = 0; i < 10; ++i)
+    {
+        u32 index = arr.push_back(Vec4((f32)i, 0.0f, 0.0f, 1.0f), (f32)i * 0.5f, (u16)i);
+        EXPECT(index == i);
+    }
+    EXPECT(arr.size() == 10);
+    EXPECT(arr.get<Radius>(4) == 2.0f);
+    EXPECT(arr.get<Position>(7).X == 7.0f);
+
+    f32 radiusSum = 0.0f;
+    for(f32 r : arr.column<Radius>())
+    {
+        radiusSum += r;
+    }
+    EXPECT(radiusSum == 22.5f);
+
+    // erase pulls the last element down across every column
+    arr.erase(2);
+    EXPECT(arr.size() == 9);
+    EXPECT(arr.get<Id>(2) == 9);
+    EXPECT(arr.get<Radius>(2) == 4.5f);
+    EXPECT(arr.get<Position>(2).X == 9.0f);
+
+    arr.swap(0, 1);
+    EXPECT(arr.get<Id>(0) == 1 && arr.get<Id>(1) == 0);
+    EXPECT(arr.get<Radius>(0) == 0.5f);
+
+    arr.clear();
+    EXPECT(arr.empty());
+
+    Clear(scratch);
+    return true;
+}
+
+b32 TestBitsets()
+{
+    memory_arena scratch = {};
+
+    bitset64 small = {};
+    EXPECT(small.none());
+    small.set(3);
+    small.set(63);
+    EXPECT(small.test(3) && small[63] && !small[4]);
+    EXPECT(small.count() == 2);
+    EXPECT(small.find_next_set(4) == 63);
+    small.reset(63);
+    EXPECT(small.find_next_set(4) == 64);
+    fixed_bitset<70> odd = {};
+    odd.set_all();
+    EXPECT(odd.all() && odd.count() == 70);
+
+    const u32 bitCount = 100000;
+    dynamic_bitset& bits = *bitset_create(scratch, bitCount);
+    EXPECT(bits.count() == 0);
+    EXPECT(bits.find_next_set() == dynamic_bitset::end_pos);
+    EXPECT(bits.find_next_clear() == 0);
+
+    bits.set(5);
+    bits.set(64);
+    bits.set(99999);
+    EXPECT(bits.find_next_set(0) == 5);
+    EXPECT(bits.find_next_set(6) == 64);
+    EXPECT(bits.find_next_set(65) == 99999);
+    EXPECT(bits.count() == 3);
+
+    u32 visited = 0;
+    u32 sum = 0;
+    for(u32 index : bits)
+    {
+        ++visited;
+        sum += index;
+    }
+    EXPECT(visited == 3 && sum == 5 + 64 + 99999);
+
+    // free slot search through a nearly full set
+    bits.set_all();
+    EXPECT(bits.count() == bitCount);
+    EXPECT(bits.find_next_clear() == dynamic_bitset::end_pos);
+    bits.clear(77777);
+    EXPECT(bits.find_next_clear() == 77777);
+    EXPECT(bits.find_next_clear(77778) == dynamic_bitset::end_pos);
+
+    bits.clear_all();
+    bits.set_range(60, 200);
+    EXPECT(bits.count() == 200);
+    EXPECT(!bits[59] && bits[60] && bits[259] && !bits[260]);
+    bits.set_range(100, 50, false);
+    EXPECT(bits.count() == 150);
+    EXPECT(bits.find_next_clear(60) == 100);
+    EXPECT(bits.find_next_set(100) == 150);
+
+    const u32 idCount = 2000000;
+    hierarchical_bitset& sparse = *hierarchical_bitset_create(scratch, idCount);
+    EXPECT(!sparse.any());
+    EXPECT(sparse.find_next_set() == hierarchical_bitset::end_pos);
+    u32 ids[] = { 0, 63, 64, 4095, 4096, 262143, 262144, 1999999 };
+    for(u32 id : ids)
+    {
+        sparse.set(id);
+    }
+    EXPECT(sparse.count() == ARRAY_COUNT(ids));
+
+    u32 expected = 0;
+    for(u32 id : sparse)
+    {
+        EXPECT(id == ids[expected]);
+        ++expected;
+    }
+    EXPECT(expected == ARRAY_COUNT(ids));
+
+    sparse.clear(4095);
+    sparse.clear(4096);
+    EXPECT(sparse.find_next_set(65) == 262143);
+    sparse.clear_all();
+    EXPECT(!sparse.any() && sparse.count() == 0);
+    EXPECT(!sparse.test(1999999));
+
+    Clear(scratch);
+    return true;
+}
+
+b32 TestMpmcQueue()
+{
+    memory_arena scratch = {};
+
+    mpmc_queue<u32>& queue = *mpmc_queue_create(scratch, u32, 16);
+    EXPECT(queue.empty());
+    EXPECT(queue.capacity() == 16);
+
+    u32 value = 0;
+    b32 popped = queue.pop(&value);
+    EXPECT(!popped);
+
+    for(u32 i = 0; i < 16; ++i)
+    {
+        b32 pushed = queue.push(i);
+        EXPECT(pushed);
+    }
+    EXPECT(queue.size() == 16);
+    b32 pushedFull = queue.push(16);
+    EXPECT(!pushedFull);
+
+    for(u32 i = 0; i < 16; ++i)
+    {
+        popped = queue.pop(&value);
+        EXPECT(popped && value == i);
+    }
+    popped = queue.pop(&value);
+    EXPECT(!popped);
+    EXPECT(queue.empty());
+
+    // run a bunch of laps around the ring with the fill level moving around
+    u32 nextPush = 0;
+    u32 nextPop = 0;
+    for(u32 round = 0; round < 200; ++round)
+    {
+        u32 pushCount = (round * 7) % 11;
+        for(u32 i = 0; i < pushCount; ++i)
+        {
+            if(queue.push(nextPush))
+            {
+                ++nextPush;
+            }
+        }
+        u32 popCount = (round * 5) % 9;
+        for(u32 i = 0; i < popCount && queue.pop(&value); ++i)
+        {
+            EXPECT(value == nextPop);
+            ++nextPop;
+        }
+        EXPECT(queue.size() == nextPush - nextPop);
+    }
+    EXPECT(nextPush > 16 * 10);
+    while(queue.pop(&value))
+    {
+        EXPECT(value == nextPop);
+        ++nextPop;
+    }
+    EXPECT(nextPop == nextPush);
+
+    Clear(scratch);
+    return true;
+}
+
+struct test_concurrent_push
+{
+    concurrent_memory_arena* arena;
+    u32 first;
+    u32 count;
+    u64** allocations;
+};
+
+internal
+PLATFORM_WORK_QUEUE_CALLBACK(TestConcurrentPush)
+{
+    test_concurrent_push* push = (test_concurrent_push*)data;
+    for(u32 index = push->first; index < push->first + push->count; ++index)
+    {
+        // NOTE(james): a few sizes so the pushes straddle block ends at different points
+        u32 words = 1 + (index % 5);
+        u64* allocation = PushArray(*push->arena, words, u64, Align(8, false));
+        for(u32 word = 0; word < words; ++word)
+        {
+            allocation[word] = index;
+        }
+        push->allocations[index] = allocation;
+    }
+}
+
+b32 TestConcurrentArena(platform_work_queue* queue)
+{
+    memory_arena scratch = {};
+    concurrent_memory_arena arena = {};
+    // small blocks, so the pushes keep racing to chain on new ones
+    SetMinimumBlockSize(arena, 4096);
+
+    const u32 jobCount = 16;
+    const u32 pushesPerJob = 1024;
+    u64** allocations = PushArray(scratch, jobCount * pushesPerJob, u64*);
+    test_concurrent_push* jobs = PushArray(scratch, jobCount, test_concurrent_push);
+
+    platform_work_counter counter = {};
+    for(u32 job = 0; job < jobCount; ++job)
+    {
+        jobs[job] = { &arena, job * pushesPerJob, pushesPerJob, allocations };
+        Platform.AddCountedWorkEntry(queue, TestConcurrentPush, jobs + job, &counter);
+    }
+    Platform.CompleteCounterWork(queue, &counter);
+
+    // an overlap would have had another push write over part of this one
+    for(u32 index = 0; index < jobCount * pushesPerJob; ++index)
+    {
+        u64* allocation = allocations[index];
+        EXPECT(allocation && ((umm)allocation & 7) == 0);
+        for(u32 word = 0; word < 1 + (index % 5); ++word)
+        {
+            EXPECT(allocation[word] == index);
+        }
+    }
+
+    // temporary memory that chains on new blocks gives them all back
+    platform_memory_block* startBlock = arena.currentBlock;
+    umm startUsed = startBlock->used;
+    concurrent_temporary_memory temp = BeginTemporaryMemory(arena);
+    for(u32 index = 0; index < 64; ++index)
+    {
+        PushSize(arena, 1024);
+    }
+    EXPECT(arena.currentBlock != startBlock);
+    EndTemporaryMemory(temp);
+    EXPECT(arena.currentBlock == startBlock);
+    EXPECT(arena.currentBlock->used == startUsed);
+    EXPECT(arena.tempCount == 0);
+
+    // and from an arena with no blocks at all
+    Clear(arena);
+    temp = BeginTemporaryMemory(arena);
+    PushSize(arena, 10000);
+    EXPECT(arena.currentBlock);
+    EndTemporaryMemory(temp);
+    EXPECT(!arena.currentBlock);
+
+    Clear(scratch);
+    return true;
+}
+
+struct test_mpmc_job
+{
+    mpmc_queue<u32>* queue;
+    u32 producer;
+    u32 pushCount;
+    u32 poppedCount;
+    u32* popped;
+};
+
+internal
+PLATFORM_WORK_QUEUE_CALLBACK(TestMpmcProduceConsume)
+{
+    test_mpmc_job* job = (test_mpmc_job*)data;
+    mpmc_queue<u32>& ring = *job->queue;
+
+    // NOTE(james): every job pushes and pops, and makes room itself when the queue is
+    // full, so nobody waits on a job that hasn't been picked up yet
+    for(u32 index = 0; index < job->pushCount; ++index)
+    {
+        u32 value = (job->producer << 16) | index;
+        while(!ring.push(value))
+        {
+            u32 popped;
+            if(ring.pop(&popped))
+            {
+                job->popped[job->poppedCount++] = popped;
+            }
+            else
+            {
+                YieldProcessor();
+            }
+        }
+
+        u32 popped;
+        if((index & 1) && ring.pop(&popped))
+        {
+            job->popped[job->poppedCount++] = popped;
+        }
+    }
+}
+
+b32 TestMpmcQueueThreaded(platform_work_queue* workQueue)
+{
+    memory_arena scratch = {};
+
+    // a small ring so the pushes and pops keep lapping each other
+    mpmc_queue<u32>& queue = *mpmc_queue_create(scratch, u32, 64);
+
+    const u32 jobCount = 8;
+    const u32 pushesPerJob = 8192;
+    const u32 total = jobCount * pushesPerJob;
+    test_mpmc_job* jobs = PushArray(scratch, jobCount + 1, test_mpmc_job);
+    platform_work_counter counter = {};
+    for(u32 job = 0; job < jobCount; ++job)
+    {
+        jobs[job] = { &queue, job, pushesPerJob, 0, PushArray(scratch, total, u32, NoClear()) };
+        Platform.AddCountedWorkEntry(workQueue, TestMpmcProduceConsume, jobs + job, &counter);
+    }
+    Platform.CompleteCounterWork(workQueue, &counter);
+
+    // whatever is left gets drained here, as one more consumer
+    test_mpmc_job& drain = jobs[jobCount];
+    drain.popped = PushArray(scratch, total, u32, NoClear());
+    u32 value;
+    while(queue.pop(&value))
+    {
+        drain.popped[drain.poppedCount++] = value;
+    }
+    EXPECT(queue.empty());
+
+    // every value came out exactly once, and any one consumer saw each producer's
+    // values in the order they went in
+    u8* seen = PushArray(scratch, total, u8);
+    for(u32 consumer = 0; consumer <= jobCount; ++consumer)
+    {
+        u32 nextIndex[jobCount] = {};
+        for(u32 index = 0; index < jobs[consumer].poppedCount; ++index)
+        {
+            u32 popped = jobs[consumer].popped[index];
+            u32 producer = popped >> 16;
+            u32 pushIndex = popped & 0xFFFF;
+            EXPECT(producer < jobCount && pushIndex < pushesPerJob);
+            EXPECT(pushIndex >= nextIndex[producer]);
+            nextIndex[producer] = pushIndex + 1;
+
+            u32 slot = producer * pushesPerJob + pushIndex;
+            EXPECT(!seen[slot]);
+            seen[slot] = 1;
+        }
+    }
+    for(u32 slot = 0; slot < total; ++slot)
+    {
+        EXPECT(seen[slot]);
+    }
+
+    Clear(scratch);
+    return true;
+}
+
+b32 TestParallelSort(platform_work_queue* queue)
+{
+    memory_arena scratch = {};
+
+    // NOTE(james): big enough for a few chunks with a ragged last one, and the keys
+    // repeat a lot so stability across chunks gets checked through the payload
+    const u32 count = 5*sort::parallel_sort_chunk_items + 1234;
+    array<test_radix_item>& serial = *array_create(scratch, test_radix_item, count);
+    array<test_radix_item>& parallel = *array_create(scratch, test_radix_item, count);
+    array<u64>& serial64 = *array_create(scratch, u64, count);
+    array<u64>& parallel64 = *array_create(scratch, u64, count);
+    for(u32 pattern = 0; pattern < 3; ++pattern)
+    {
+        serial.clear();
+        serial64.clear();
+        u32 random = 54321;
+        for(u32 i = 0; i < count; ++i)
+        {
+            random = random * 1664525 + 1013904223;
+            u32 key = pattern == 0 ? random % 1000 : pattern == 1 ? (random & 0xFF00FF00) : random;
+            serial.push_back(test_radix_item{ key, i });
+            serial64.push_back(((u64)(key % 77) << 40) | (random >> 8));
+        }
+        parallel.set_size(count);
+        CopyArray(count, serial.data(), parallel.data());
+        parallel64.set_size(count);
+        CopyArray(count, serial64.data(), parallel64.data());
+
+        sort::radixSort(serial, scratch);
+        sort::parallelRadixSort(queue, parallel, scratch);
+        sort::radixSort(serial64, scratch);
+        sort::parallelRadixSort(queue, parallel64, scratch);
+
+        for(u32 i = 0; i < count; ++i)
+        {
+            EXPECT(parallel[i].key == serial[i].key);
+            EXPECT(parallel[i].index == serial[i].index);
+            EXPECT(parallel64[i] == serial64[i]);
+        }
+    }
 
     Clear(scratch);
     return true;
 }
 
-b32 TestCollections()
+// NOTE(james): the threaded tests only run when there is a work queue to run them on
+b32 TestCollections(platform_work_queue* queue)
 {
     b32 passed = true;
     passed &= TestArray();
     passed &= TestSort();
     passed &= TestHashTable();
+    passed &= TestSlotMap();
+    passed &= TestBucketArray();
+    passed &= TestSoaArray();
+    passed &= TestBitsets();
+    passed &= TestMpmcQueue();
+
+    if(queue)
+    {
+        passed &= TestConcurrentArena(queue);
+        passed &= TestParallelSort(queue);
+        passed &= TestMpmcQueueThreaded(queue);
+    }
 
     return passed;
 }
-#endif
\ No newline at end of file
+#endif
+
+#if BENCH_COLLECTIONS
+// NOTE(james): timings are in cycles per element from __rdtsc, so only compare them on the same machine
+
+enum class BenchSortInput { Sorted, Reversed, Random, Count };
+
+template<typename T>
+internal void
+FillBenchSortInput(array<T>& items, u32 count, BenchSortInput input)
+{
+    items.set_size(count);
+    u64 random = 0x2545F4914F6CDD1Dull;
+    for(u32 i = 0; i < count; ++i)
+    {
+        random ^= random << 13; random ^= random >> 7; random ^= random << 17;
+        T key = input == BenchSortInput::Sorted ? (T)i : input == BenchSortInput::Reversed ? (T)(count - i) : (T)random;
+        items[i] = key;
+    }
+}
+
+template<typename T, typename FNSORT>
+internal f64
+BenchSortCycles(memory_arena& arena, u32 count, BenchSortInput input, FNSORT sortFn)
+{
+    temporary_memory temp = BeginTemporaryMemory(arena);
+    array<T>& items = *array_create(arena, T, count);
+    FillBenchSortInput(items, count, input);
+
+    u64 start = __rdtsc();
+    sortFn(items);
+    u64 cycles = __rdtsc() - start;
+
+    for(u32 i = 1; i < count; ++i)
+    {
+        ASSERT(items[i-1] <= items[i]);
+    }
+
+    EndTemporaryMemory(temp);
+    return (f64)cycles / (f64)count;
+}
+
+void BenchSort()
+{
+    memory_arena arena = {};
+    arena.allocationFlags = PlatformMemoryFlags::NotRestored;
+    memory_arena& scratch = *BootstrapScratchArena("BenchSortScratch", NonRestoredArena());
+
+    const char* inputNames[] = { "sorted", "reversed", "random" };
+    for(u32 count = 1000; count <= 10000000; count *= 10)
+    {
+        for(u32 input = 0; input < (u32)BenchSortInput::Count; ++input)
+        {
+            BenchSortInput in = (BenchSortInput)input;
+            f64 intro32 = BenchSortCycles<u32>(arena, count, in, [](array<u32>& a) { sort::introSort(a); });
+            f64 heap32 = BenchSortCycles<u32>(arena, count, in, [](array<u32>& a) { sort::heapSort(a); });
+            f64 radix32 = BenchSortCycles<u32>(arena, count, in, [&](array<u32>& a) { sort::radixSort(a, scratch); });
+            f64 intro64 = BenchSortCycles<u64>(arena, count, in, [](array<u64>& a) { sort::introSort(a); });
+            f64 radix64 = BenchSortCycles<u64>(arena, count, in, [&](array<u64>& a) { sort::radixSort(a, scratch); });
+
+            Platform.Log(LogLevel::Info, "sort %8u %-8s | u32 intro %7.1f heap %7.1f radix %7.1f | u64 intro %7.1f radix %7.1f cycles/item",
+                         count, inputNames[input], intro32, heap32, radix32, intro64, radix64);
+        }
+    }
+
+    Clear(scratch);
+    Clear(arena);
+}
+
+// NOTE(james): needs the platform work queue, so platform startup runs it with the high priority queue
+void BenchParallelSort(platform_work_queue* queue)
+{
+    memory_arena arena = {};
+    arena.allocationFlags = PlatformMemoryFlags::NotRestored;
+    memory_arena& scratch = *BootstrapScratchArena("BenchSortScratch", NonRestoredArena());
+
+    for(u32 count = 100000; count <= 10000000; count *= 10)
+    {
+        f64 serial32 = BenchSortCycles<u32>(arena, count, BenchSortInput::Random, [&](array<u32>& a) { sort::radixSort(a, scratch); });
+        f64 parallel32 = BenchSortCycles<u32>(arena, count, BenchSortInput::Random, [&](array<u32>& a) { sort::parallelRadixSort(queue, a, scratch); });
+        f64 serial64 = BenchSortCycles<u64>(arena, count, BenchSortInput::Random, [&](array<u64>& a) { sort::radixSort(a, scratch); });
+        f64 parallel64 = BenchSortCycles<u64>(arena, count, BenchSortInput::Random, [&](array<u64>& a) { sort::parallelRadixSort(queue, a, scratch); });
+
+        Platform.Log(LogLevel::Info, "parallel sort %8u random | u32 serial %7.1f parallel %7.1f | u64 serial %7.1f parallel %7.1f cycles/item",
+                     count, serial32, parallel32, serial64, parallel64);
+    }
+
+    Clear(scratch);
+    Clear(arena);
+}
+#endif
@@ -0,0 +1,122 @@
+/*******************************************************************************
+
+    Directory listing and change list helpers shared by the platform layers
+
+    The OS reports every step of a save, an editor writing a temp file,
+    renaming it over the original and touching it again, so changes get
+    folded together per file as they come in.  The game only ever sees where
+    each file ended up since the last poll.
+
+    Names are always relative to the file location with forward slashes, so
+    whatever comes out of here can go straight back into OpenFile or MapFile.
+
+********************************************************************************/
+
+// NOTE(james): turns "", "shaders" or "shaders/" into "" or "shaders/" so names can be
+// made by sticking the file name on the end
+internal void
+MakeDirectoryPrefix(const char* directory, char* dest, umm destSize)
+{
+    CopyString(directory, dest, destSize - 1);
+
+    umm length = (umm)StringLength(dest);
+    for(umm index = 0; index < length; ++index)
+    {
+        if(dest[index] == '\\') dest[index] = '/';
+    }
+
+    if(length && dest[length-1] != '/')
+    {
+        dest[length] = '/';
+        dest[length+1] = 0;
+    }
+}
+
+internal platform_file_info*
+PushFileInfo(memory_arena& arena, platform_file_list& list, const char* name)
+{
+    platform_file_info* info = PushStruct(arena, platform_file_info);
+    info->name = PushStringZ(arena, name);
+
+    info->next = list.first;
+    list.first = info;
+    ++list.count;
+
+    return info;
+}
+
+// NOTE(james): the change list as it's being built.  Start it zeroed, it only makes the
+// lookup once the first change comes in, and hand back list when done.
+struct file_change_builder
+{
+    platform_file_change_list list;
+    // where the next new change gets linked in
+    platform_file_change** tail;
+    // NOTE(james): maps each file to the link pointing at its change, so a change can be
+    // found and dropped without walking the list
+    hashtable<platform_file_change**>* links;
+};
+
+inline internal u64
+FileChangeKey(FileLocation location, const char* name)
+{
+    return MurmurHash64(name, (u32)StringLength(name), (u64)location);
+}
+
+internal void
+PushFileChange(memory_arena& arena, file_change_builder& changes, FileLocation location, const char* name, FileChangeType type)
+{
+    if(!changes.links)
+    {
+        changes.links = hashtable_create(arena, platform_file_change**, 64);
+        changes.tail = &changes.list.first;
+    }
+
+    u64 key = FileChangeKey(location, name);
+    platform_file_change** link = 0;
+    if(changes.links->try_get(key, &link))
+    {
+        platform_file_change* change = *link;
+        if(type == FileChangeType::Removed)
+        {
+            if(change->type == FileChangeType::Added)
+            {
+                // came and went before anybody looked
+                *link = change->next;
+                changes.links->erase(key);
+                if(change->next)
+                {
+                    changes.links->set(FileChangeKey(change->next->location, change->next->name), link);
+                }
+                else
+                {
+                    changes.tail = link;
+                }
+                --changes.list.count;
+            }
+            else
+            {
+                change->type = FileChangeType::Removed;
+            }
+        }
+        else if(change->type == FileChangeType::Removed)
+        {
+            // NOTE(james): replaced, which is how a lot of editors save
+            change->type = FileChangeType::Modified;
+        }
+        // anything else was already added or modified, and still is
+        return;
+    }
+
+    // NOTE(james): appended so changes come out in the order they first happened
+    platform_file_change* change = PushStruct(arena, platform_file_change);
+    change->type = type;
+    change->location = location;
+    change->name = PushStringZ(arena, name);
+    change->next = 0;
+
+    *changes.tail = change;
+    changes.links->set(key, changes.tail);
+    changes.tail = &change->next;
+    ++changes.list.count;
+}
@@ -141,6 +141,7 @@ GAME_UPDATE_AND_RENDER(GameUpdateAndRender)
     // NOTE(james): Setup scratch memory for the frame...
     EndTemporaryMemory(gameState.temporaryFrameMemory);
     gameState.temporaryFrameMemory = BeginTemporaryMemory(*gameState.frameArena);
+    DEBUG_MEMORY_FRAME_END();
 
     // simple rotation update
     GameClock& clock = input.clock;
@@ -212,16 +212,28 @@ FindLeastSignificantSetBit(uint32 Value)
 #if COMPILER_MSVC
     Result.Found = _BitScanForward((unsigned long *)&Result.Index, Value);
 #else
-    for(i32 Test = 0;
-        Test < 32;
-        ++Test)
+    if(Value)
     {
-        if(Value & (1 << Test))
-        {
-            Result.Index = Test;
-            Result.Found = true;
-            break;
-        }
+        Result.Index = __builtin_ctz(Value);
+        Result.Found = true;
+    }
+#endif
+
+    return(Result);
+}
+
+inline bit_scan_result
+FindLeastSignificantSetBit(u64 Value)
+{
+    bit_scan_result Result = {};
+
+#if COMPILER_MSVC
+    Result.Found = _BitScanForward64((unsigned long *)&Result.Index, Value);
+#else
+    if(Value)
+    {
+        Result.Index = __builtin_ctzll(Value);
+        Result.Found = true;
     }
 #endif
 
@@ -236,22 +248,94 @@ FindMostSignificantSetBit(uint32 Value)
 #if COMPILER_MSVC
     Result.Found = _BitScanReverse((unsigned long *)&Result.Index, Value);
 #else
-    for(i32 Test = 32;
-        Test > 0;
-        --Test)
+    if(Value)
     {
-        if(Value & (1 << (Test - 1)))
-        {
-            Result.Index = Test - 1;
-            Result.Found = true;
-            break;
-        }
+        Result.Index = 31 - __builtin_clz(Value);
+        Result.Found = true;
     }
 #endif
 
     return(Result);
 }
 
+inline bit_scan_result
+FindMostSignificantSetBit(u64 Value)
+{
+    bit_scan_result Result = {};
+
+#if COMPILER_MSVC
+    Result.Found = _BitScanReverse64((unsigned long *)&Result.Index, Value);
+#else
+    if(Value)
+    {
+        Result.Index = 63 - __builtin_clzll(Value);
+        Result.Found = true;
+    }
+#endif
+
+    return(Result);
+}
+
+inline u32
+CountSetBits(u32 Value)
+{
+#if COMPILER_MSVC
+    u32 Result = __popcnt(Value);
+#else
+    u32 Result = __builtin_popcount(Value);
+#endif
+
+    return(Result);
+}
+
+inline u32
+CountSetBits(u64 Value)
+{
+#if COMPILER_MSVC
+    u32 Result = (u32)__popcnt64(Value);
+#else
+    u32 Result = __builtin_popcountll(Value);
+#endif
+
+    return(Result);
+}
+
+inline u16
+ByteSwap(u16 Value)
+{
+#if COMPILER_MSVC
+    u16 Result = _byteswap_ushort(Value);
+#else
+    u16 Result = __builtin_bswap16(Value);
+#endif
+
+    return(Result);
+}
+
+inline u32
+ByteSwap(u32 Value)
+{
+#if COMPILER_MSVC
+    u32 Result = _byteswap_ulong(Value);
+#else
+    u32 Result = __builtin_bswap32(Value);
+#endif
+
+    return(Result);
+}
+
+inline u64
+ByteSwap(u64 Value)
+{
+#if COMPILER_MSVC
+    u64 Result = _byteswap_uint64(Value);
+#else
+    u64 Result = __builtin_bswap64(Value);
+#endif
+
+    return(Result);
+}
+
 internal void
 SetDefaultFPBehavior(void)
 {
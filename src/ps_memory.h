@@ -5,6 +5,11 @@
     scratch memory area and then quickly reset back once you are
     done with it
 
+    Arenas made with the ReserveOnly flag reserve one big range of
+    address space up front and commit pages as pushes reach them, so the
+    data stays contiguous, the last push can grow in place and resetting
+    temporary memory never goes back to the OS.
+
 ********************************************************************************/
 
 struct memory_arena
@@ -14,6 +19,12 @@ struct memory_arena
 
     PlatformMemoryFlags allocationFlags;
     s32 tempCount;
+
+#if PROJECTSUPER_INTERNAL
+    // NOTE(james): named after the first push (or the bootstrap) for the allocation dump
+    const char* debugGuid;
+    umm debugUsed;
+#endif
 };
 
 struct temporary_memory
@@ -89,7 +100,7 @@ Align(u32 alignment, b32 clear)
 inline arena_push_params
 NoClear()
 {
-    arena_push_params params = {};
+    arena_push_params params = DefaultArenaParams();
     params.flags = ArenaPushFlags::NoClear;
     return params;
 }
@@ -118,18 +129,248 @@ NonRestoredArena(umm initialSize = 0, umm minBlockSize = 0)
     return(Params);
 }
 
+inline arena_bootstrap_params
+ReservedArena(umm reserveSize = Gigabytes(1), PlatformMemoryFlags flags = PlatformMemoryFlags::NotRestored)
+{
+    arena_bootstrap_params Params = DefaultBootstrapParams();
+    Params.allocationFlags = flags | PlatformMemoryFlags::ReserveOnly;
+    Params.initialAllocatedSize = reserveSize;
+    Params.minimumBlockSize = reserveSize;
+    return(Params);
+}
+
+
+#if PROJECTSUPER_INTERNAL
+/*******************************************************************************
+
+    Allocation tracking for internal builds.  Every push is counted against
+    its call site (the GUID is "Name file(line)", so the pointer is unique
+    per site) and against the arena it came from, which keeps its high
+    water mark and how many blocks it had to chain on.  Per-frame numbers
+    roll over in DEBUGMemoryFrameEnd.
+
+    Each module has its own table, so the game dll only sees its own
+    allocations and starts counting again after a reload.
+
+********************************************************************************/
+
+#define DEBUG_MEMORY_MAX_SITES 1024
+#define DEBUG_MEMORY_MAX_ARENAS 256
+
+struct debug_memory_site
+{
+    const char* volatile guid;
+
+    u64 volatile totalBytes;
+    u64 volatile totalCount;
+    u64 volatile frameBytes;
+    u64 volatile frameCount;
+
+    u64 lastFrameBytes;
+    u64 lastFrameCount;
+};
+
+struct debug_memory_arena_stats
+{
+    const char* volatile guid;
+
+    u64 volatile highWater;
+    u64 volatile blockAllocations;
+    u64 volatile blockFrees;
+    u64 volatile frameBlockAllocations;
+
+    u64 lastFrameBlockAllocations;
+};
+
+struct debug_memory_table
+{
+    debug_memory_site sites[DEBUG_MEMORY_MAX_SITES];
+    debug_memory_arena_stats arenas[DEBUG_MEMORY_MAX_ARENAS];
+
+    u32 volatile droppedRecords;
+};
+
+global_variable debug_memory_table GlobalDebugMemoryTable;
+
+template<typename T, u32 N>
+inline T*
+DEBUGGetMemoryRecord(T (&records)[N], const char* guid)
+{
+    CompileAssert((N & (N-1)) == 0);
+
+    // NOTE(james): open addressing on the guid pointer, slots are only ever claimed
+    // so a lookup can stop at the first empty one
+    u32 hash = (u32)((((umm)guid >> 3) * 0x9E3779B97F4A7C15ull) >> 32);
+    for(u32 probe = 0; probe < N; ++probe)
+    {
+        T* record = records + ((hash + probe) & (N-1));
+        const char* existing = record->guid;
+        if(!existing)
+        {
+            existing = (const char*)AtomicCompareExchangeU64((u64 volatile*)&record->guid, (u64)guid, 0);
+            if(!existing)
+            {
+                return record;
+            }
+        }
+        if(existing == guid)
+        {
+            return record;
+        }
+    }
+
+    AtomicAddU32(&GlobalDebugMemoryTable.droppedRecords, 1);
+    return 0;
+}
+
+inline void
+DEBUGRecordSiteAllocation(const char* guid, umm size)
+{
+    debug_memory_site* site = DEBUGGetMemoryRecord(GlobalDebugMemoryTable.sites, guid);
+    if(site)
+    {
+        AtomicAddU64(&site->totalBytes, size);
+        AtomicAddU64(&site->totalCount, 1);
+        AtomicAddU64(&site->frameBytes, size);
+        AtomicAddU64(&site->frameCount, 1);
+    }
+}
+
+inline void
+DEBUGRecordAllocation(memory_arena& arena, const char* guid, umm size, umm sizeInit)
+{
+    DEBUGRecordSiteAllocation(guid, sizeInit);
+
+    arena.debugUsed += size;
+    debug_memory_arena_stats* stats = DEBUGGetMemoryRecord(GlobalDebugMemoryTable.arenas, arena.debugGuid);
+    if(stats)
+    {
+        u64 highWater = stats->highWater;
+        while(arena.debugUsed > highWater)
+        {
+            u64 prior = AtomicCompareExchangeU64(&stats->highWater, arena.debugUsed, highWater);
+            if(prior == highWater)
+            {
+                break;
+            }
+            highWater = prior;
+        }
+    }
+}
 
-// TODO(james): Implement memory allocation debug hooks
+template<typename arena_type>
+inline void
+DEBUGRecordBlockAllocation(arena_type& arena, const char* guid)
+{
+    if(!arena.debugGuid)
+    {
+        arena.debugGuid = guid;
+    }
+
+    debug_memory_arena_stats* stats = DEBUGGetMemoryRecord(GlobalDebugMemoryTable.arenas, arena.debugGuid);
+    if(stats)
+    {
+        AtomicAddU64(&stats->blockAllocations, 1);
+        AtomicAddU64(&stats->frameBlockAllocations, 1);
+    }
+}
+
+template<typename arena_type>
+inline void
+DEBUGRecordBlockFree(arena_type& arena, platform_memory_block* block)
+{
+    arena.debugUsed -= Minimum(arena.debugUsed, block->used);
+
+    debug_memory_arena_stats* stats = DEBUGGetMemoryRecord(GlobalDebugMemoryTable.arenas, arena.debugGuid);
+    if(stats)
+    {
+        AtomicAddU64(&stats->blockFrees, 1);
+    }
+}
+
+template<typename arena_type>
+inline void
+DEBUGRecordBlockTruncate(arena_type& arena, platform_memory_block* block, umm newUsed)
+{
+    arena.debugUsed -= Minimum(arena.debugUsed, block->used - newUsed);
+}
+
+internal void
+DEBUGMemoryFrameEnd()
+{
+    for(u32 siteIndex = 0; siteIndex < DEBUG_MEMORY_MAX_SITES; ++siteIndex)
+    {
+        debug_memory_site& site = GlobalDebugMemoryTable.sites[siteIndex];
+        if(site.guid)
+        {
+            site.lastFrameBytes = AtomicExchangeU64(&site.frameBytes, 0);
+            site.lastFrameCount = AtomicExchangeU64(&site.frameCount, 0);
+        }
+    }
+
+    for(u32 arenaIndex = 0; arenaIndex < DEBUG_MEMORY_MAX_ARENAS; ++arenaIndex)
+    {
+        debug_memory_arena_stats& stats = GlobalDebugMemoryTable.arenas[arenaIndex];
+        if(stats.guid)
+        {
+            stats.lastFrameBlockAllocations = AtomicExchangeU64(&stats.frameBlockAllocations, 0);
+        }
+    }
+}
+
+internal void
+DEBUGDumpMemoryStats()
+{
+    debug_platform_memory_stats platformStats = Platform.DEBUG_GetMemoryStats();
+    Platform.Log(LogLevel::Info, "Memory: %u blocks, %llu of %llu bytes used, peak %llu bytes",
+                 platformStats.blockCount, platformStats.totalUsed, platformStats.totalSize, platformStats.peakSize);
+    Platform.Log(LogLevel::Info, "Block cache: %llu bytes in %u blocks, %llu hits, %llu misses",
+                 platformStats.cachedSize, platformStats.cachedBlockCount, platformStats.cacheHits, platformStats.cacheMisses);
+
+    for(u32 arenaIndex = 0; arenaIndex < DEBUG_MEMORY_MAX_ARENAS; ++arenaIndex)
+    {
+        debug_memory_arena_stats& stats = GlobalDebugMemoryTable.arenas[arenaIndex];
+        if(stats.guid)
+        {
+            Platform.Log(LogLevel::Info, "Arena %s: high water %llu bytes, %llu blocks allocated (%llu last frame), %llu freed",
+                         stats.guid, stats.highWater, stats.blockAllocations, stats.lastFrameBlockAllocations, stats.blockFrees);
+        }
+    }
+
+    for(u32 siteIndex = 0; siteIndex < DEBUG_MEMORY_MAX_SITES; ++siteIndex)
+    {
+        debug_memory_site& site = GlobalDebugMemoryTable.sites[siteIndex];
+        if(site.guid)
+        {
+            Platform.Log(LogLevel::Info, "%s: %llu bytes in %llu pushes, last frame %llu bytes in %llu pushes",
+                         site.guid, site.totalBytes, site.totalCount, site.lastFrameBytes, site.lastFrameCount);
+        }
+    }
+
+    if(GlobalDebugMemoryTable.droppedRecords)
+    {
+        Platform.Log(LogLevel::Info, "%u allocations went unrecorded, the tracking tables are full", GlobalDebugMemoryTable.droppedRecords);
+    }
+}
+
+#define DEBUG_RECORD_ALLOCATION(Arena, GUID, Size, SizeInit) DEBUGRecordAllocation(Arena, GUID, Size, SizeInit)
+#define DEBUG_RECORD_BLOCK_ALLOCATION(Arena, GUID) DEBUGRecordBlockAllocation(Arena, GUID)
+#define DEBUG_RECORD_BLOCK_FREE(Arena, Block) DEBUGRecordBlockFree(Arena, Block)
+#define DEBUG_RECORD_BLOCK_TRUNCATE(Arena, Block, NewUsed) DEBUGRecordBlockTruncate(Arena, Block, NewUsed)
+#define DEBUG_MEMORY_FRAME_END() DEBUGMemoryFrameEnd()
+
+#define DEBUG_NAME__(File, Line) File "(" #Line ")"
+#define DEBUG_NAME_(File, Line) DEBUG_NAME__(File, Line)
+#define DEBUG_MEMORY_NAME(Name) Name " " DEBUG_NAME_(__FILE__, __LINE__),
+#define INTERNAL_MEMORY_PARAM const char *GUID,
+#define INTERNAL_MEMORY_PASS GUID,
+#else
 #define DEBUG_RECORD_ALLOCATION(...)
 #define DEBUG_RECORD_BLOCK_ALLOCATION(...)
 #define DEBUG_RECORD_BLOCK_FREE(...)
 #define DEBUG_RECORD_BLOCK_TRUNCATE(...)
+#define DEBUG_MEMORY_FRAME_END()
 
-#if 0 //defined(PROJECTSUPER_INTERNAL)
-#define DEBUG_MEMORY_NAME(Name) DEBUG_NAME_(__FILE__, __LINE__, __COUNTER__),
-#define INTERNAL_MEMORY_PARAM char *GUID,
-#define INTERNAL_MEMORY_PASS GUID,
-#else
 #define DEBUG_MEMORY_NAME(Name)
 #define INTERNAL_MEMORY_PARAM 
 #define INTERNAL_MEMORY_PASS 
@@ -184,7 +425,7 @@ PushSize_(INTERNAL_MEMORY_PARAM
         else if(!arena.minimumBlockSize)
         {
             // TODO(james): Tune default block size eventually?
-            arena.minimumBlockSize = Kilobytes(64);
+            arena.minimumBlockSize = IS_FLAG_BIT_SET(arena.allocationFlags, PlatformMemoryFlags::ReserveOnly) ? Gigabytes(1) : Kilobytes(64);
         }
         
         memory_index blockSize = Maximum(size, arena.minimumBlockSize);
@@ -192,10 +433,16 @@ PushSize_(INTERNAL_MEMORY_PARAM
         platform_memory_block *newBlock = Platform.AllocateMemoryBlock(blockSize, arena.allocationFlags);
         newBlock->prev_block = arena.currentBlock;
         arena.currentBlock = newBlock;
-        DEBUG_RECORD_BLOCK_ALLOCATION(arena.currentBlock); 
+        DEBUG_RECORD_BLOCK_ALLOCATION(arena, GUID);
     }    
     
     ASSERT((arena.currentBlock->used + size) <= arena.currentBlock->size);
+
+    if((arena.currentBlock->used + size) > arena.currentBlock->committed)
+    {
+        b32 committed = Platform.CommitMemoryBlock(arena.currentBlock, arena.currentBlock->used + size);
+        ASSERT(committed);
+    }
     
     memory_index alignmentOffset = GetAlignmentOffset(arena, params.alignment);
     umm offsetInBlock = arena.currentBlock->used + alignmentOffset;
@@ -213,7 +460,7 @@ PushSize_(INTERNAL_MEMORY_PARAM
         ZeroSize(sizeInit, result);
     }
     
-    DEBUG_RECORD_ALLOCATION(arena.currentBlock, GUID, size, sizeInit, offsetInBlock);
+    DEBUG_RECORD_ALLOCATION(arena, GUID, size, sizeInit);
     
     return result;
 }
@@ -302,6 +549,38 @@ PushAndNullTerminate_(INTERNAL_MEMORY_PARAM
     return dest;
 }
 
+// NOTE(james): grows the most recent push without moving it, fails if anything
+// else was pushed after it or the block doesn't have the room
+inline b32
+TryGrowInPlace(memory_arena& arena, void* ptr, umm oldSize, umm newSize, arena_push_params params = DefaultArenaParams())
+{
+    platform_memory_block* block = arena.currentBlock;
+    if(!block || newSize < oldSize || ((u8*)ptr + oldSize) != (block->base + block->used))
+    {
+        return false;
+    }
+
+    umm used = block->used + (newSize - oldSize);
+    if(used > block->size)
+    {
+        return false;
+    }
+
+    if(used > block->committed && !Platform.CommitMemoryBlock(block, used))
+    {
+        return false;
+    }
+
+    block->used = used;
+    DEBUG_RECORD_ALLOCATION(arena, "TryGrowInPlace", newSize - oldSize, newSize - oldSize);
+    if(IS_FLAG_BIT_SET(params.flags, ArenaPushFlags::Clear))
+    {
+        ZeroSize(newSize - oldSize, (u8*)ptr + oldSize);
+    }
+
+    return true;
+}
+
 inline temporary_memory
 BeginTemporaryMemory(memory_arena& arena)
 {
@@ -320,7 +599,7 @@ inline void
 FreeLastBlock(memory_arena& arena)
 {
     platform_memory_block *free = arena.currentBlock;
-    DEBUG_RECORD_BLOCK_FREE(free);
+    DEBUG_RECORD_BLOCK_FREE(arena, free);
     arena.currentBlock = free->prev_block;
     Platform.DeallocateMemoryBlock(free);
 }
@@ -337,8 +616,8 @@ EndTemporaryMemory(const temporary_memory& tempMem)
     if(arena.currentBlock)
     {
         ASSERT(arena.currentBlock->used >= tempMem.used);
+        DEBUG_RECORD_BLOCK_TRUNCATE(arena, arena.currentBlock, tempMem.used);
         arena.currentBlock->used = tempMem.used;
-        DEBUG_RECORD_BLOCK_TRUNCATE(arena.currentBlock);
     }
     
     ASSERT(arena.tempCount > 0);
@@ -376,6 +655,185 @@ CheckArena(const memory_arena& arena)
     ASSERT(arena.tempCount == 0);
 }
 
+/*******************************************************************************
+
+    Concurrent arenas let any number of threads push at the same time, for
+    things like jobs emitting render items into one frame-lifetime buffer.
+    A push that fits is a single fetch-add on the block cursor, only
+    chaining a new block takes the mutex.  Temporary memory works the same
+    way as the normal arena, but nobody may be pushing while it begins or
+    ends, so do it from one thread between batches of work.
+
+********************************************************************************/
+
+struct concurrent_memory_arena
+{
+    platform_memory_block* volatile currentBlock;
+    umm minimumBlockSize;
+
+    PlatformMemoryFlags allocationFlags;
+    s32 tempCount;
+
+    // NOTE(james): only taken to chain on a new block
+    ticket_mutex blockMutex;
+
+#if PROJECTSUPER_INTERNAL
+    // NOTE(james): pushes race each other, so only the call sites and blocks are
+    // tracked, there is no high water mark
+    const char* debugGuid;
+    umm debugUsed;
+#endif
+};
+
+struct concurrent_temporary_memory
+{
+    concurrent_memory_arena* arena;
+    platform_memory_block* block;
+    umm used;
+};
+
+inline void
+SetMinimumBlockSize(concurrent_memory_arena& arena, umm minimumSize)
+{
+    arena.minimumBlockSize = minimumSize;
+}
+
+inline void *
+PushSize_(INTERNAL_MEMORY_PARAM
+          concurrent_memory_arena &arena, memory_index sizeInit, arena_push_params params = DefaultArenaParams())
+{
+    ASSERT(params.alignment <= 128);
+    ASSERT(IsPow2(params.alignment));
+    // NOTE(james): nothing would commit the pages the cursor runs into
+    ASSERT(IS_FLAG_BIT_NOT_SET(arena.allocationFlags, PlatformMemoryFlags::ReserveOnly));
+
+    // NOTE(james): the cursor is bumped before we know where it lands, so reserve
+    // enough to align from any starting offset
+    memory_index size = sizeInit + (params.alignment - 1);
+
+    u8 *result = 0;
+    platform_memory_block *block = (platform_memory_block *)AtomicLoadAcquireU64((u64 volatile *)&arena.currentBlock);
+    while(!result)
+    {
+        if(block)
+        {
+            // NOTE(james): a push that doesn't fit still moves the cursor, so the
+            // used of a block that has been chained past can read larger than its size
+            umm offset = AtomicAddU64((u64 volatile *)&block->used, size);
+            if(offset + size <= block->size)
+            {
+                result = block->base + offset;
+                break;
+            }
+        }
+
+        // NOTE(james): only one thread needs to chain the block, everybody else
+        // goes back to the cursor instead of lining up behind the allocation
+        if(!TryBeginTicketMutex(&arena.blockMutex))
+        {
+            YieldProcessor();
+            block = (platform_memory_block *)AtomicLoadAcquireU64((u64 volatile *)&arena.currentBlock);
+            continue;
+        }
+
+        platform_memory_block *current = arena.currentBlock;
+        if(current == block)
+        {
+            memory_index blockSize = size;
+            if(IS_ANY_FLAG_SET(arena.allocationFlags, PlatformMemoryFlags::OverflowCheck|PlatformMemoryFlags::UnderflowCheck))
+            {
+                arena.minimumBlockSize = 0;
+            }
+            else if(!arena.minimumBlockSize)
+            {
+                arena.minimumBlockSize = Kilobytes(64);
+            }
+            blockSize = Maximum(blockSize, arena.minimumBlockSize);
+
+            platform_memory_block *newBlock = Platform.AllocateMemoryBlock(blockSize, arena.allocationFlags);
+            newBlock->prev_block = block;
+            // NOTE(james): take our push before anybody else can see the block
+            newBlock->used = size;
+            result = newBlock->base;
+            AtomicStoreReleaseU64((u64 volatile *)&arena.currentBlock, (u64)newBlock);
+            DEBUG_RECORD_BLOCK_ALLOCATION(arena, GUID);
+        }
+        EndTicketMutex(&arena.blockMutex);
+
+        // somebody else chained a block while we waited, try again on theirs
+        block = current;
+    }
+
+    memory_index alignmentMask = params.alignment - 1;
+    if((umm)result & alignmentMask)
+    {
+        result += params.alignment - ((umm)result & alignmentMask);
+    }
+
+    if(IS_FLAG_BIT_SET(params.flags, ArenaPushFlags::Clear))
+    {
+        ZeroSize(sizeInit, result);
+    }
+
+#if PROJECTSUPER_INTERNAL
+    DEBUGRecordSiteAllocation(GUID, sizeInit);
+#endif
+
+    return result;
+}
+
+inline concurrent_temporary_memory
+BeginTemporaryMemory(concurrent_memory_arena& arena)
+{
+    concurrent_temporary_memory result;
+
+    result.arena = &arena;
+    result.block = arena.currentBlock;
+    result.used = arena.currentBlock ? arena.currentBlock->used : 0;
+
+    ++arena.tempCount;
+
+    return result;
+}
+
+inline void
+FreeLastBlock(concurrent_memory_arena& arena)
+{
+    platform_memory_block *free = arena.currentBlock;
+    DEBUG_RECORD_BLOCK_FREE(arena, free);
+    arena.currentBlock = free->prev_block;
+    Platform.DeallocateMemoryBlock(free);
+}
+
+inline void
+EndTemporaryMemory(const concurrent_temporary_memory& tempMem)
+{
+    concurrent_memory_arena& arena = *tempMem.arena;
+    while(arena.currentBlock != tempMem.block)
+    {
+        FreeLastBlock(arena);
+    }
+
+    if(arena.currentBlock)
+    {
+        ASSERT(arena.currentBlock->used >= tempMem.used);
+        DEBUG_RECORD_BLOCK_TRUNCATE(arena, arena.currentBlock, tempMem.used);
+        arena.currentBlock->used = tempMem.used;
+    }
+
+    ASSERT(arena.tempCount > 0);
+    --arena.tempCount;
+}
+
+inline void
+Clear(concurrent_memory_arena& arena)
+{
+    while(arena.currentBlock)
+    {
+        FreeLastBlock(arena);
+    }
+}
+
 inline void *
 BootstrapPushSize_(INTERNAL_MEMORY_PARAM umm structSize, umm offsetToArena,
                    arena_bootstrap_params bootstrapParams = DefaultBootstrapParams(), 
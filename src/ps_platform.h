@@ -32,6 +32,27 @@ struct platform_file
     b32 error;
     u64 size;
     void* platform;
+    // NOTE(james): a second OS handle for platforms that can only read asynchronously
+    // through a differently opened file, made on the first async read
+    void* platformAsync;
+};
+
+// NOTE(james): tells the OS how a mapped file is going to be read so it can read ahead
+// (or not) accordingly
+enum class FileAccessHint
+{
+    Normal,
+    Sequential,
+    Random
+};
+
+// NOTE(james): a read-only view of a whole file, straight out of the OS page cache
+struct platform_mapped_file
+{
+    b32 error;
+    u64 size;
+    const u8* data;
+    void* platform;
 };
 
 enum class PlatformMemoryFlags : u64
@@ -39,6 +60,12 @@ enum class PlatformMemoryFlags : u64
     NotRestored     = 0x01,
     UnderflowCheck  = 0x02,
     OverflowCheck   = 0x04,
+    // NOTE(james): the block size is only reserved address space, pages get
+    // committed as they are needed with CommitMemoryBlock
+    ReserveOnly     = 0x08,
+    // NOTE(james): back the block with large pages when the OS lets us, quietly
+    // falls back to normal pages otherwise.  Ignored with the guard page checks.
+    LargePages      = 0x10,
     MAX             = U64MAX
 };
 MAKE_ENUM_FLAG(u64, PlatformMemoryFlags);
@@ -50,6 +77,18 @@ struct platform_memory_block
     u8* base;
     umm used;
     platform_memory_block* prev_block;
+    // NOTE(james): bytes from base that are backed by memory, always size unless ReserveOnly
+    umm committed;
+};
+
+// NOTE(james): the same physical pages mapped twice back to back, so base[size + i] is
+// base[i].  size is what was asked for rounded up to the OS mapping granularity (a page,
+// 64k on windows).  These are never part of a looped recording.
+struct platform_mirrored_memory
+{
+    u8* base;
+    umm size;
+    void* platform;
 };
 
 enum class LogLevel
@@ -62,32 +101,161 @@ enum class LogLevel
 #if PROJECTSUPER_INTERNAL
 struct debug_platform_memory_stats
 {
+    u32 blockCount;
     u64 totalSize;
     u64 totalUsed;
+    // NOTE(james): largest totalSize seen since startup
+    u64 peakSize;
+
+    // NOTE(james): freed blocks held back for reuse, these are not part of the totals above
+    u64 cachedSize;
+    u32 cachedBlockCount;
+    u64 cacheHits;
+    u64 cacheMisses;
 };
 #endif
 
 struct platform_work_queue;
 
+// NOTE(james): counts the outstanding entries added with it, zero once they have all run
+struct platform_work_counter
+{
+    u32 volatile count;
+};
+
+struct memory_arena;
 
-#define PLATFORM_WORK_QUEUE_CALLBACK(name) void name(platform_work_queue* queue, void* data)
+// NOTE(james): scratch belongs to the thread running the callback and is reset once the callback returns
+#define PLATFORM_WORK_QUEUE_CALLBACK(name) void name(platform_work_queue* queue, void* data, memory_arena& scratch)
 typedef PLATFORM_WORK_QUEUE_CALLBACK(platform_work_queue_callback);
 
+struct platform_work_item
+{
+    platform_work_queue_callback* callback;
+    void* data;
+};
+
+struct platform_file_info
+{
+    platform_file_info* next;
+    // NOTE(james): relative to the file location, so it can go straight back into OpenFile
+    char* name;
+    u64 size;
+    // NOTE(james): platform time, only good for comparing against other write times
+    u64 writeTime;
+    b32 isDirectory;
+};
+
+struct platform_file_list
+{
+    u32 count;
+    platform_file_info* first;
+};
+
+enum class FileChangeType : u32
+{
+    Added,
+    Modified,
+    Removed
+};
+
+// NOTE(james): changes to the same file are folded together between polls, a rename
+// shows up as the old name removed and the new one added
+struct platform_file_change
+{
+    platform_file_change* next;
+    FileChangeType type;
+    FileLocation location;
+    // NOTE(james): relative to the file location, like platform_file_info
+    char* name;
+};
+
+struct platform_file_change_list
+{
+    u32 count;
+    platform_file_change* first;
+    // NOTE(james): the OS dropped changes, anything under the watches may be different
+    // now so it's time to rescan with ListFiles
+    b32 overflowed;
+};
+
+// NOTE(james): zero is never a valid watch
+struct platform_directory_watch
+{
+    u32 id;
+};
+
+// NOTE(james): identifies a read started with ReadFileAsync.  Every read has to be waited
+// on once with WaitForFileRead, even after IsFileReadComplete says it's done, since that's
+// what hands back how much was read and frees the read up for reuse.
+struct platform_file_read_handle
+{
+    u32 index;
+    u32 generation;
+};
+
+struct platform_file_read_request
+{
+    platform_file* file;
+    u64 offset;
+    u64 size;
+    void* dest;
+};
+
+// NOTE(james): identifies a batch added with AddWorkBatch.  Handles go stale once the
+// batch finishes, a stale (or zeroed) handle always reads as complete.
+struct platform_work_handle
+{
+    u32 index;
+    u32 generation;
+};
+
 struct platform_api
 {
     API_FUNCTION(void, Log, LogLevel level, const char* format, ...);
 
     API_FUNCTION(void, AddWorkEntry, platform_work_queue* queue, platform_work_queue_callback *callback, void* data);
     API_FUNCTION(void, CompleteAllWork, platform_work_queue* queue);
+    API_FUNCTION(void, AddCountedWorkEntry, platform_work_queue* queue, platform_work_queue_callback *callback, void* data, platform_work_counter* counter);
+    API_FUNCTION(void, CompleteCounterWork, platform_work_queue* queue, platform_work_counter* counter);
+    // NOTE(james): the batch won't start until every prerequisite batch on the same queue has finished,
+    // the items are copied so they don't have to outlive the call
+    API_FUNCTION(platform_work_handle, AddWorkBatch, platform_work_queue* queue, u32 itemCount, const platform_work_item* items, u32 prerequisiteCount, const platform_work_handle* prerequisites);
+    API_FUNCTION(void, WaitForWork, platform_work_queue* queue, platform_work_handle handle);
+    API_FUNCTION(b32, IsWorkComplete, platform_work_queue* queue, platform_work_handle handle);
     
+    // NOTE(james): blocks can be recycled from the platform block cache, so don't count on
+    // a new block coming back zeroed
     API_FUNCTION(platform_memory_block*, AllocateMemoryBlock, memory_index size, PlatformMemoryFlags flags);
     API_FUNCTION(void, DeallocateMemoryBlock, platform_memory_block*);
+    API_FUNCTION(b32, CommitMemoryBlock, platform_memory_block* block, umm size);
+    API_FUNCTION(void, SetMemoryBlockCacheLimit, umm size);
+    // NOTE(james): base is zero if the OS couldn't set up the double mapping
+    API_FUNCTION(platform_mirrored_memory, AllocateMirroredMemory, umm size);
+    API_FUNCTION(void, DeallocateMirroredMemory, platform_mirrored_memory& memory);
 
     API_FUNCTION(platform_file, OpenFile, FileLocation location, const char* filename, FileUsage usage);
     API_FUNCTION(u64, ReadFile, platform_file& file, void* buffer, u64 size);
     API_FUNCTION(u64, WriteFile, platform_file& file, const void* buffer, u64 size);
     API_FUNCTION(void, CloseFile, platform_file& file);
-    // TODO(james): Add list files API
+    // NOTE(james): an empty file maps fine, it just has no data
+    API_FUNCTION(platform_mapped_file, MapFile, FileLocation location, const char* filename, FileAccessHint hint);
+    API_FUNCTION(void, UnmapFile, platform_mapped_file& file);
+    // NOTE(james): reads size bytes from offset into dest without blocking, dest has to stay
+    // put until the read has been waited on.  A single read is limited to 4GB.
+    API_FUNCTION(platform_file_read_handle, ReadFileAsync, platform_file& file, u64 offset, u64 size, void* dest);
+    // starts all of them together, handles needs room for count
+    API_FUNCTION(void, ReadFileAsyncBatch, u32 count, const platform_file_read_request* requests, platform_file_read_handle* handles);
+    API_FUNCTION(b32, IsFileReadComplete, platform_file_read_handle handle);
+    // returns the bytes read, which comes up short at the end of the file or on an error
+    API_FUNCTION(u64, WaitForFileRead, platform_file_read_handle handle);
+    // NOTE(james): directory is relative to the location, empty lists the location itself
+    API_FUNCTION(platform_file_list, ListFiles, memory_arena& arena, FileLocation location, const char* directory, b32 recursive);
+    // NOTE(james): watches always cover subdirectories too
+    API_FUNCTION(platform_directory_watch, WatchDirectory, FileLocation location, const char* directory);
+    API_FUNCTION(void, UnwatchDirectory, platform_directory_watch watch);
+    // NOTE(james): everything that changed under the watches since the last call
+    API_FUNCTION(platform_file_change_list, GetFileChanges, memory_arena& arena);
     // TODO(james): Add window creation APIs? (Editor??)
     
 #if PROJECTSUPER_INTERNAL
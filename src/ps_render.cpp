@@ -59,36 +59,39 @@
 
 gfx_api gfx;
 
-internal b32
-LoadShaderBlob(memory_arena& memory, const char* filename, GfxShaderDesc* pShaderDesc)
+// NOTE(james): the shader desc points straight into the mapped file, so it's only good
+// until the file is unmapped
+internal platform_mapped_file
+LoadShaderBlob(const char* filename, GfxShaderDesc* pShaderDesc)
 {
-    platform_file file = Platform.OpenFile(FileLocation::Content, filename, FileUsage::Read);
+    platform_mapped_file file = Platform.MapFile(FileLocation::Content, filename, FileAccessHint::Sequential);
+    ASSERT(!file.error);
     ASSERT(file.size <= (u64)U32MAX);
-    if(file.error) return false;
+    if(file.error) return file;
 
     pShaderDesc->size = file.size;
-    pShaderDesc->data = PushSize(memory, file.size);
-    u64 bytesRead = Platform.ReadFile(file, pShaderDesc->data, file.size);
-    ASSERT(bytesRead == file.size);
+    pShaderDesc->data = (void*)file.data;
 
-    Platform.CloseFile(file);
-
-    return true;
+    return file;
 }
 
 internal GfxProgram
-LoadProgram(memory_arena& memory, const char* vert_file, const char* frag_file)
+LoadProgram(const char* vert_file, const char* frag_file)
 {
     GfxShaderDesc vertex = {};
     GfxShaderDesc fragment = {};
-    LoadShaderBlob(memory, vert_file, &vertex);
-    LoadShaderBlob(memory, frag_file, &fragment);
+    platform_mapped_file vertexFile = LoadShaderBlob(vert_file, &vertex);
+    platform_mapped_file fragmentFile = LoadShaderBlob(frag_file, &fragment);
     
     GfxProgramDesc programDesc = {};
     programDesc.vertex = &vertex;
     programDesc.fragment = &fragment;
     GfxProgram program = gfx.CreateProgram(gfx.device, programDesc);
     GFX_ASSERT_VALID(program);
+
+    // the device has its own copy of the code once the program exists
+    Platform.UnmapFile(vertexFile);
+    Platform.UnmapFile(fragmentFile);
     
     return program;
 }
@@ -296,7 +299,7 @@ StageBufferData(render_context& rc, u64 size, const void* data, GfxBuffer buffer
     }
 
     void* stagingData = gfx.GetBufferData(gfx.device, rc.stagingBuffer);
-    Copy(size, data, OffsetPtr(stagingData, rc.stagingPos));
+    CopyStreaming(size, data, OffsetPtr(stagingData, rc.stagingPos));
     gfx.CmdCopyBufferRange(rc.stagingCmds, rc.stagingBuffer, rc.stagingPos, buffer, 0, size);
 
     rc.stagingPos += size;
@@ -315,7 +318,7 @@ StageTextureData(render_context& rc, u64 size, const void* data, GfxTexture text
     }
 
     void* stagingData = gfx.GetBufferData(gfx.device, rc.stagingBuffer);
-    Copy(size, data, OffsetPtr(stagingData, rc.stagingPos));
+    CopyStreaming(size, data, OffsetPtr(stagingData, rc.stagingPos));
 
     gfx.CmdCopyBufferToTexture(rc.stagingCmds, rc.stagingBuffer, rc.stagingPos, texture);
  
@@ -339,23 +342,16 @@ EndStagingData(render_context& rc)
 internal void
 TempLoadImagePixels(memory_arena& arena, const char* filename, u32 desiredChannelCount, u32* width, u32* height, u32* channels, void*& pixeldata)
 {
-    temporary_memory temp = BeginTemporaryMemory(arena);
-
-    platform_file file = Platform.OpenFile(FileLocation::Content, filename, FileUsage::Read);
-    ASSERT(file.size <= (u64)U32MAX);
-
-    void* fileBytes = PushSize(arena, file.size);
-    u64 bytesRead = Platform.ReadFile(file, fileBytes, file.size);
-    ASSERT(bytesRead == file.size);
-
-    Platform.CloseFile(file);
+    platform_mapped_file file = Platform.MapFile(FileLocation::Content, filename, FileAccessHint::Sequential);
+    ASSERT(!file.error);
+    ASSERT(file.size <= (u64)S32MAX);
 
     int texWidth, texHeight, texChannels;
-    stbi_uc *pixels = stbi_load_from_memory((stbi_uc*)fileBytes, (int)file.size, &texWidth, &texHeight, &texChannels, desiredChannelCount);
+    stbi_uc *pixels = stbi_load_from_memory(file.data, (int)file.size, &texWidth, &texHeight, &texChannels, desiredChannelCount);
     ASSERT(pixels);
     ASSERT((u32)texChannels <= desiredChannelCount);
 
-    EndTemporaryMemory(temp);
+    Platform.UnmapFile(file);
 
 
     if(width) *width = (u32)texWidth;
@@ -373,14 +369,14 @@ TempLoadGltfGeometry(render_context& rc, const char* filename, u32* pNumMeshes,
     ASSERT(pNumMeshes);
     ASSERT(pOutMeshes);
 
-    platform_file file = Platform.OpenFile(FileLocation::Content, filename, FileUsage::Read);
-    void* bytes = PushSize(*rc.frameArena, file.size); 
-    u64 bytesRead = Platform.ReadFile(file, bytes, file.size);
-    ASSERT(bytesRead == file.size);
+    // NOTE(james): the glb buffers are used in place, so the file stays mapped until
+    // everything has been staged
+    platform_mapped_file file = Platform.MapFile(FileLocation::Content, filename, FileAccessHint::Sequential);
+    ASSERT(!file.error);
     
     cgltf_options options = {};
     cgltf_data* data = NULL;
-    cgltf_result result = cgltf_parse(&options, bytes, file.size, &data);
+    cgltf_result result = cgltf_parse(&options, file.data, file.size, &data);
 
     if(result == cgltf_result_success)
     {
@@ -472,7 +468,7 @@ TempLoadGltfGeometry(render_context& rc, const char* filename, u32* pNumMeshes,
         cgltf_free(data);
     }
 
-    Platform.CloseFile(file);   
+    Platform.UnmapFile(file);
 }
 
 #if 0
@@ -901,15 +897,15 @@ SetupRenderer(game_state& game)
     rc.ground.indexBuffer = gfx.CreateBuffer(gfx.device, ib, 0);
     rc.ground.vertexBuffer = gfx.CreateBuffer(gfx.device, vb, 0);
     rc.groundMaterial = gfx.CreateBuffer(gfx.device, mb, 0);
-    rc.groundProgram = LoadProgram(*rc.frameArena, "shader.vert.spv", "shader.frag.spv");
+    rc.groundProgram = LoadProgram("shader.vert.spv", "shader.frag.spv");
     rc.groundKernel = gfx.CreateGraphicsKernel(gfx.device, rc.groundProgram, DefaultPipeline(true));
 
     rc.meshSceneBuffer = gfx.CreateBuffer(gfx.device, UniformBuffer(sizeof(SceneBufferObject), GfxMemoryAccess::CpuToGpu), 0);
     rc.meshMaterial = gfx.CreateBuffer(gfx.device, UniformBuffer(sizeof(render_material) * NUM_ROWS * NUM_COLS), 0);
-    rc.meshProgram = LoadProgram(*rc.frameArena, "pbrbox.vert.spv", "pbrbox.frag.spv");
+    rc.meshProgram = LoadProgram("pbrbox.vert.spv", "pbrbox.frag.spv");
     rc.meshKernel = gfx.CreateGraphicsKernel(gfx.device, rc.meshProgram, DefaultPipeline(true));
 
-    rc.lightProgram = LoadProgram(*rc.frameArena, "lightbox.vert.spv", "lightbox.frag.spv");
+    rc.lightProgram = LoadProgram("lightbox.vert.spv", "lightbox.frag.spv");
     rc.lightKernel = gfx.CreateGraphicsKernel(gfx.device, rc.lightProgram, DefaultPipeline(true));
 
     rc.depthTarget = gfx.CreateRenderTarget(gfx.device, DepthRenderTarget(gc.windowWidth, gc.windowHeight));
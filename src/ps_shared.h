@@ -7,14 +7,66 @@
 
 
 
-// NOTE(james): This copy does NOT work if the src and dst pointers
-// will overlap!  If you need that, write another copy method that
-// supports that case.
+//---- Memory copy/compare/clear
+//------------------------
 
-#define CopyBuffer(src, dest) Copy(src.size, src.data, dest.data)
-#define CopyArray(count, src, dest) Copy((count)*sizeof(*(src)), (src), (dest))
-internal void*
-Copy(umm size, const void* src, void* dst)
+// NOTE(james): SSE2 is always there on x64, AVX2 is picked at runtime the first time
+// one of these gets called.  Each module (the game dll included) works it out for itself.
+enum class CpuSimdLevel : u32
+{
+    Unknown,
+    SSE2,
+    AVX2
+};
+global_variable CpuSimdLevel GlobalCpuSimdLevel;
+
+#if COMPILER_MSVC
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+internal CpuSimdLevel
+DetectCpuSimdLevel()
+{
+    CpuSimdLevel result = CpuSimdLevel::SSE2;
+#if COMPILER_MSVC
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] >= 7)
+    {
+        __cpuid(info, 1);
+        b32 osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 0x6) == 0x6);
+        __cpuidex(info, 7, 0);
+        if(osSavesYmm && (info[1] & (1 << 5)))
+        {
+            result = CpuSimdLevel::AVX2;
+        }
+    }
+#else
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+    {
+        result = CpuSimdLevel::AVX2;
+    }
+#endif
+    return result;
+}
+
+inline CpuSimdLevel
+GetCpuSimdLevel()
+{
+    // NOTE(james): racing threads all detect the same answer, so no need for anything atomic
+    if(GlobalCpuSimdLevel == CpuSimdLevel::Unknown)
+    {
+        GlobalCpuSimdLevel = DetectCpuSimdLevel();
+    }
+    return GlobalCpuSimdLevel;
+}
+
+// NOTE(james): below a vector width we go a machine word at a time
+inline void
+CopyWords(umm size, const void* src, void* dst)
 {
     CompileAssert(sizeof(umm)==sizeof(src));   // verify pointer size
     memory_index chunks = size / sizeof(src);  // Copy by CPU bit width
@@ -36,6 +88,136 @@ Copy(umm size, const void* src, void* dst)
 
     ASSERT3(s8 == ((u8*)src + size));
     ASSERT3(d8 == ((u8*)dst + size));
+}
+
+// NOTE(james): the SIMD versions finish with one unaligned vector that ends exactly at
+// the end of the range, overlapping what was already done, instead of a byte tail
+internal void
+CopySSE2(umm size, const void* src, void* dst)
+{
+    ASSERT3(size >= 16);
+    const u8* s = (const u8*)src;
+    u8* d = (u8*)dst;
+    const u8* sEnd = s + size;
+    u8* dEnd = d + size;
+
+    while(size >= 64)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(s + 0));
+        __m128i b = _mm_loadu_si128((const __m128i*)(s + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(s + 32));
+        __m128i e = _mm_loadu_si128((const __m128i*)(s + 48));
+        _mm_storeu_si128((__m128i*)(d + 0), a);
+        _mm_storeu_si128((__m128i*)(d + 16), b);
+        _mm_storeu_si128((__m128i*)(d + 32), c);
+        _mm_storeu_si128((__m128i*)(d + 48), e);
+        s += 64; d += 64; size -= 64;
+    }
+    while(size >= 16)
+    {
+        _mm_storeu_si128((__m128i*)d, _mm_loadu_si128((const __m128i*)s));
+        s += 16; d += 16; size -= 16;
+    }
+    if(size)
+    {
+        _mm_storeu_si128((__m128i*)(dEnd - 16), _mm_loadu_si128((const __m128i*)(sEnd - 16)));
+    }
+}
+
+TARGET_AVX2 internal void
+CopyAVX2(umm size, const void* src, void* dst)
+{
+    ASSERT3(size >= 32);
+    const u8* s = (const u8*)src;
+    u8* d = (u8*)dst;
+    const u8* sEnd = s + size;
+    u8* dEnd = d + size;
+
+    while(size >= 128)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(s + 0));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(s + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(s + 64));
+        __m256i e = _mm256_loadu_si256((const __m256i*)(s + 96));
+        _mm256_storeu_si256((__m256i*)(d + 0), a);
+        _mm256_storeu_si256((__m256i*)(d + 32), b);
+        _mm256_storeu_si256((__m256i*)(d + 64), c);
+        _mm256_storeu_si256((__m256i*)(d + 96), e);
+        s += 128; d += 128; size -= 128;
+    }
+    while(size >= 32)
+    {
+        _mm256_storeu_si256((__m256i*)d, _mm256_loadu_si256((const __m256i*)s));
+        s += 32; d += 32; size -= 32;
+    }
+    if(size)
+    {
+        _mm256_storeu_si256((__m256i*)(dEnd - 32), _mm256_loadu_si256((const __m256i*)(sEnd - 32)));
+    }
+}
+
+// NOTE(james): This copy does NOT work if the src and dst pointers
+// will overlap!  If you need that, write another copy method that
+// supports that case.
+
+#define CopyBuffer(src, dest) Copy(src.size, src.data, dest.data)
+#define CopyArray(count, src, dest) Copy((count)*sizeof(*(src)), (src), (dest))
+internal void*
+Copy(umm size, const void* src, void* dst)
+{
+    if(size < 16)
+    {
+        CopyWords(size, src, dst);
+    }
+    else if(size >= 32 && GetCpuSimdLevel() == CpuSimdLevel::AVX2)
+    {
+        CopyAVX2(size, src, dst);
+    }
+    else
+    {
+        CopySSE2(size, src, dst);
+    }
+    return dst;
+}
+
+// NOTE(james): Past this size a copy won't fit in the cache anyway, so the streaming
+// copy writes around it instead of evicting everything else on the way through.
+#define STREAMING_COPY_THRESHOLD Kilobytes(256)
+
+// NOTE(james): Use this for big copies into memory the CPU won't read back, like the
+// mapped staging buffers from gfx.GetBufferData.  Same overlap rules as Copy.
+internal void*
+CopyStreaming(umm size, const void* src, void* dst)
+{
+    if(size < STREAMING_COPY_THRESHOLD)
+    {
+        return Copy(size, src, dst);
+    }
+
+    const u8* s = (const u8*)src;
+    u8* d = (u8*)dst;
+
+    // non-temporal stores need an aligned destination
+    umm head = AlignPow2((umm)d, 16) - (umm)d;
+    Copy(head, s, d);
+    s += head; d += head; size -= head;
+
+    while(size >= 64)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(s + 0));
+        __m128i b = _mm_loadu_si128((const __m128i*)(s + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(s + 32));
+        __m128i e = _mm_loadu_si128((const __m128i*)(s + 48));
+        _mm_stream_si128((__m128i*)(d + 0), a);
+        _mm_stream_si128((__m128i*)(d + 16), b);
+        _mm_stream_si128((__m128i*)(d + 32), c);
+        _mm_stream_si128((__m128i*)(d + 48), e);
+        s += 64; d += 64; size -= 64;
+    }
+    Copy(size, s, d);
+
+    // streaming stores are weakly ordered, make them visible before anyone (the GPU) reads them
+    _mm_sfence();
     return dst;
 }
 
@@ -70,8 +252,8 @@ SparseCopyArray(u32 count, umm offset, umm elementSize, umm stride, const void*
     return dst;
 }
 
-internal b32
-MemCompare(umm size, const void* a, const void* b)
+inline b32
+MemCompareWords(umm size, const void* a, const void* b)
 {
     CompileAssert(sizeof(umm)==sizeof(a));   // verify pointer size
     memory_index chunks = size / sizeof(a);  // Compare by CPU bit width
@@ -94,11 +276,69 @@ MemCompare(umm size, const void* a, const void* b)
     return true;
 }
 
-#define ZeroStruct(instance) ZeroSize(sizeof(instance), &(instance))
-#define ZeroArray(count, array_ptr) ZeroSize((count)*sizeof((array_ptr)[0]), (array_ptr))
-#define ZeroBuffer(buffer) ZeroSize(buffer.size, buffer.data)
-internal void
-ZeroSize(umm size, void* ptr)
+internal b32
+MemCompareSSE2(umm size, const void* a, const void* b)
+{
+    ASSERT3(size >= 16);
+    const u8* l = (const u8*)a;
+    const u8* r = (const u8*)b;
+    const u8* lEnd = l + size;
+    const u8* rEnd = r + size;
+
+    while(size >= 16)
+    {
+        __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)l), _mm_loadu_si128((const __m128i*)r));
+        if(_mm_movemask_epi8(eq) != 0xFFFF) { return false; }
+        l += 16; r += 16; size -= 16;
+    }
+    if(size)
+    {
+        __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(lEnd - 16)), _mm_loadu_si128((const __m128i*)(rEnd - 16)));
+        if(_mm_movemask_epi8(eq) != 0xFFFF) { return false; }
+    }
+    return true;
+}
+
+TARGET_AVX2 internal b32
+MemCompareAVX2(umm size, const void* a, const void* b)
+{
+    ASSERT3(size >= 32);
+    const u8* l = (const u8*)a;
+    const u8* r = (const u8*)b;
+    const u8* lEnd = l + size;
+    const u8* rEnd = r + size;
+
+    while(size >= 32)
+    {
+        __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)l), _mm256_loadu_si256((const __m256i*)r));
+        if((u32)_mm256_movemask_epi8(eq) != 0xFFFFFFFF) { return false; }
+        l += 32; r += 32; size -= 32;
+    }
+    if(size)
+    {
+        __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(lEnd - 32)), _mm256_loadu_si256((const __m256i*)(rEnd - 32)));
+        if((u32)_mm256_movemask_epi8(eq) != 0xFFFFFFFF) { return false; }
+    }
+    return true;
+}
+
+// NOTE(james): only answers equal or not, there is no ordering
+internal b32
+MemCompare(umm size, const void* a, const void* b)
+{
+    if(size < 16)
+    {
+        return MemCompareWords(size, a, b);
+    }
+    else if(size >= 32 && GetCpuSimdLevel() == CpuSimdLevel::AVX2)
+    {
+        return MemCompareAVX2(size, a, b);
+    }
+    return MemCompareSSE2(size, a, b);
+}
+
+inline void
+ZeroWords(umm size, void* ptr)
 {
     CompileAssert(sizeof(umm)==sizeof(ptr));   // verify pointer size
     memory_index chunks = size/sizeof(ptr);
@@ -119,6 +359,80 @@ ZeroSize(umm size, void* ptr)
     ASSERT3(s == ((u8*)ptr + size));
 }
 
+internal void
+ZeroSSE2(umm size, void* ptr)
+{
+    ASSERT3(size >= 16);
+    u8* p = (u8*)ptr;
+    u8* pEnd = p + size;
+    __m128i zero = _mm_setzero_si128();
+
+    while(size >= 64)
+    {
+        _mm_storeu_si128((__m128i*)(p + 0), zero);
+        _mm_storeu_si128((__m128i*)(p + 16), zero);
+        _mm_storeu_si128((__m128i*)(p + 32), zero);
+        _mm_storeu_si128((__m128i*)(p + 48), zero);
+        p += 64; size -= 64;
+    }
+    while(size >= 16)
+    {
+        _mm_storeu_si128((__m128i*)p, zero);
+        p += 16; size -= 16;
+    }
+    if(size)
+    {
+        _mm_storeu_si128((__m128i*)(pEnd - 16), zero);
+    }
+}
+
+TARGET_AVX2 internal void
+ZeroAVX2(umm size, void* ptr)
+{
+    ASSERT3(size >= 32);
+    u8* p = (u8*)ptr;
+    u8* pEnd = p + size;
+    __m256i zero = _mm256_setzero_si256();
+
+    while(size >= 128)
+    {
+        _mm256_storeu_si256((__m256i*)(p + 0), zero);
+        _mm256_storeu_si256((__m256i*)(p + 32), zero);
+        _mm256_storeu_si256((__m256i*)(p + 64), zero);
+        _mm256_storeu_si256((__m256i*)(p + 96), zero);
+        p += 128; size -= 128;
+    }
+    while(size >= 32)
+    {
+        _mm256_storeu_si256((__m256i*)p, zero);
+        p += 32; size -= 32;
+    }
+    if(size)
+    {
+        _mm256_storeu_si256((__m256i*)(pEnd - 32), zero);
+    }
+}
+
+#define ZeroStruct(instance) ZeroSize(sizeof(instance), &(instance))
+#define ZeroArray(count, array_ptr) ZeroSize((count)*sizeof((array_ptr)[0]), (array_ptr))
+#define ZeroBuffer(buffer) ZeroSize(buffer.size, buffer.data)
+internal void
+ZeroSize(umm size, void* ptr)
+{
+    if(size < 16)
+    {
+        ZeroWords(size, ptr);
+    }
+    else if(size >= 32 && GetCpuSimdLevel() == CpuSimdLevel::AVX2)
+    {
+        ZeroAVX2(size, ptr);
+    }
+    else
+    {
+        ZeroSSE2(size, ptr);
+    }
+}
+
 inline internal b32x
 IsValid(const buffer& buff)
 {
@@ -286,6 +600,7 @@ inline b32x IsPow2(u32 Value)
 #if COMPILER_MSVC
 #define CompletePreviousReadsBeforeFutureReads _ReadBarrier()
 #define CompletePreviousWritesBeforeFutureWrites _WriteBarrier()
+#define CompletePreviousMemoryOpsBeforeFutureMemoryOps _mm_mfence()
 #define YieldProcessor _mm_pause
 inline uint32 AtomicCompareExchangeUInt32(uint32 volatile *Value, uint32 New, uint32 Expected)
 {
@@ -293,12 +608,51 @@ inline uint32 AtomicCompareExchangeUInt32(uint32 volatile *Value, uint32 New, ui
     
     return(Result);
 }
+inline u64 AtomicCompareExchangeU64(u64 volatile *Value, u64 New, u64 Expected)
+{
+    u64 Result = _InterlockedCompareExchange64((__int64 volatile *)Value, New, Expected);
+    
+    return(Result);
+}
 inline u64 AtomicExchangeU64(u64 volatile *Value, u64 New)
 {
     u64 Result = _InterlockedExchange64((__int64 volatile *)Value, New);
     
     return(Result);
 }
+inline u32 AtomicAddU32(u32 volatile *Value, u32 Addend)
+{
+    // NOTE: Returns the original value _prior_ to adding
+    u32 Result = _InterlockedExchangeAdd((long volatile *)Value, Addend);
+    
+    return(Result);
+}
+// NOTE(james): x86 loads already have acquire and stores already have release
+// semantics, these only need to keep the compiler from reordering around them
+inline u32 AtomicLoadAcquireU32(u32 volatile *Value)
+{
+    u32 Result = *Value;
+    _ReadWriteBarrier();
+    
+    return(Result);
+}
+inline u64 AtomicLoadAcquireU64(u64 volatile *Value)
+{
+    u64 Result = *Value;
+    _ReadWriteBarrier();
+    
+    return(Result);
+}
+inline void AtomicStoreReleaseU32(u32 volatile *Value, u32 New)
+{
+    _ReadWriteBarrier();
+    *Value = New;
+}
+inline void AtomicStoreReleaseU64(u64 volatile *Value, u64 New)
+{
+    _ReadWriteBarrier();
+    *Value = New;
+}
 inline u64 AtomicAddU64(u64 volatile *Value, u64 Addend)
 {
     // NOTE: Returns the original value _prior_ to adding
@@ -334,6 +688,7 @@ inline u32 GetThreadID(void)
 #define CompletePreviousReadsBeforeFutureReads asm volatile("" ::: "memory")
 #define CompletePreviousWritesBeforeFutureWrites asm volatile("" ::: "memory")
 // TODO(james): is this right for llvm?
+#define CompletePreviousMemoryOpsBeforeFutureMemoryOps __atomic_thread_fence(__ATOMIC_SEQ_CST)
 #define YieldProcessor _mm_pause
 inline uint32 AtomicCompareExchangeUInt32(uint32 volatile *Value, uint32 New, uint32 Expected)
 {
@@ -341,12 +696,45 @@ inline uint32 AtomicCompareExchangeUInt32(uint32 volatile *Value, uint32 New, ui
     
     return(Result);
 }
+inline u64 AtomicCompareExchangeU64(u64 volatile *Value, u64 New, u64 Expected)
+{
+    u64 Result = __sync_val_compare_and_swap(Value, Expected, New);
+    
+    return(Result);
+}
 inline u64 AtomicExchangeU64(u64 volatile *Value, u64 New)
 {
     u64 Result = __sync_lock_test_and_set(Value, New);
     
     return(Result);
 }
+inline u32 AtomicAddU32(u32 volatile *Value, u32 Addend)
+{
+    // NOTE: Returns the original value _prior_ to adding
+    u32 Result = __sync_fetch_and_add(Value, Addend);
+    
+    return(Result);
+}
+inline u32 AtomicLoadAcquireU32(u32 volatile *Value)
+{
+    u32 Result = __atomic_load_n(Value, __ATOMIC_ACQUIRE);
+    
+    return(Result);
+}
+inline u64 AtomicLoadAcquireU64(u64 volatile *Value)
+{
+    u64 Result = __atomic_load_n(Value, __ATOMIC_ACQUIRE);
+    
+    return(Result);
+}
+inline void AtomicStoreReleaseU32(u32 volatile *Value, u32 New)
+{
+    __atomic_store_n(Value, New, __ATOMIC_RELEASE);
+}
+inline void AtomicStoreReleaseU64(u64 volatile *Value, u64 New)
+{
+    __atomic_store_n(Value, New, __ATOMIC_RELEASE);
+}
 inline u64 AtomicAddU64(u64 volatile *Value, u64 Addend)
 {
     // NOTE: Returns the original value _prior_ to adding
@@ -426,6 +814,15 @@ BeginTicketMutex(ticket_mutex *mutex)
 }
 
 
+inline b32
+TryBeginTicketMutex(ticket_mutex *mutex)
+{
+    // NOTE(james): only take a ticket if it would be served right away
+    u64 Serving = mutex->serving;
+    b32 Result = (AtomicCompareExchangeU64(&mutex->ticket, Serving + 1, Serving) == Serving);
+    return(Result);
+}
+
 inline void
 EndTicketMutex(ticket_mutex *mutex)
 {
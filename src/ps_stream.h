@@ -8,6 +8,8 @@ struct ps_ringmemory_stream
 	memory_index 		max_size;
 	PsRingPosition	write_cursor;
 	PsRingPosition  read_cursor;
+	// NOTE(james): base_pointer[max_size + i] aliases base_pointer[i], see AllocateMirroredMemory
+	b32				mirrored;
 };
 
 internal
@@ -22,16 +24,30 @@ ps_ringmemory_stream psMakeRingMemoryStream(void* baseptr, memory_index max_size
 	return mem_stream;
 }
 
+// NOTE(james): on mirrored memory every read and write is a single copy, even across the end
+internal
+ps_ringmemory_stream psMakeRingMemoryStream(const platform_mirrored_memory& memory)
+{
+	ASSERT(memory.base);
+	ps_ringmemory_stream mem_stream = psMakeRingMemoryStream(memory.base, memory.size);
+	mem_stream.mirrored = true;
+
+	return mem_stream;
+}
+
 internal
 memory_index psRingMemoryWrite(ps_ringmemory_stream& stream, const void* src, memory_index writeSize)
 {
+	ASSERT(writeSize <= stream.max_size);
+
 	PsRingPosition next_pos = stream.write_cursor + writeSize;
 	void* dest = OffsetPtr(stream.base_pointer, stream.write_cursor);
 
-	if(next_pos < stream.max_size)
+	if(stream.mirrored || next_pos <= stream.max_size)
 	{
 		// all we need is a simple copy here
 		Copy(writeSize, src, dest);
+		IFF(next_pos >= stream.max_size, next_pos -= stream.max_size);
 	}
 	else
 	{
@@ -60,13 +76,16 @@ memory_index psRingMemoryRead(ps_ringmemory_stream& stream, memory_index sizeToR
 	memory_index readSize = sizeToRead;
 	IFF(sizeToRead > maxOutBufferSize, readSize = maxOutBufferSize);
 
+	ASSERT(readSize <= stream.max_size);
+
 	PsRingPosition next_pos = stream.read_cursor + readSize;
 	void* src = OffsetPtr(stream.base_pointer, stream.read_cursor);
 
-	if(next_pos < stream.max_size)
+	if(stream.mirrored || next_pos <= stream.max_size)
 	{
 		// just a simple copy to the outbuffer
 		Copy(readSize, src, outbuffer);
+		IFF(next_pos >= stream.max_size, next_pos -= stream.max_size);
 	}
 	else
 	{
@@ -86,4 +105,836 @@ memory_index psRingMemoryRead(ps_ringmemory_stream& stream, memory_index sizeToR
 	stream.read_cursor = next_pos;
 
 	return readSize;
-}
\ No newline at end of file
+}
+
+// NOTE(james): Single producer / single consumer version of the ring for handing bytes
+// between two threads without a lock (audio mixing, streamed asset data).  The positions
+// are running byte totals that never wrap, so write - read is always exactly how much is
+// waiting and a full ring can't be confused with an empty one.  Only the producer ever
+// stores write_position and only the consumer stores read_position; the release store
+// of a position publishes the bytes copied before it.
+// It's meant to live somewhere both threads can see, so set it up in place.
+struct ps_spsc_ring_stream
+{
+	u64 volatile	write_position;
+	u8				pad0[56];
+	u64 volatile	read_position;
+	u8				pad1[56];
+
+	void*			base_pointer;
+	memory_index	max_size;
+	b32				mirrored;
+};
+
+internal
+void psInitSpscRingStream(ps_spsc_ring_stream& stream, void* baseptr, memory_index max_size)
+{
+	ASSERT(baseptr && max_size);
+	stream.base_pointer = baseptr;
+	stream.max_size = max_size;
+	stream.mirrored = false;
+	stream.read_position = 0;
+	AtomicStoreReleaseU64(&stream.write_position, 0);
+}
+
+// NOTE(james): on mirrored memory regions never come back split, so a consumer can parse
+// a record that straddles the end of the buffer in place
+internal
+void psInitSpscRingStream(ps_spsc_ring_stream& stream, const platform_mirrored_memory& memory)
+{
+	psInitSpscRingStream(stream, memory.base, memory.size);
+	stream.mirrored = true;
+}
+
+// NOTE(james): A piece of the ring handed straight to the caller.  It comes in two parts
+// when it runs off the end of the buffer and wraps around to the start, unless the ring
+// is mirrored; second_size is zero otherwise.
+struct ps_ring_region
+{
+	void*			first;
+	memory_index	first_size;
+	void*			second;
+	memory_index	second_size;
+};
+
+inline memory_index
+psRingRegionSize(const ps_ring_region& region)
+{
+	return region.first_size + region.second_size;
+}
+
+internal
+ps_ring_region psSpscRingRegionAt(ps_spsc_ring_stream& stream, u64 position, memory_index size)
+{
+	ps_ring_region region{};
+	memory_index offset = position % stream.max_size;
+	memory_index size_to_end = stream.max_size - offset;
+
+	region.first = OffsetPtr(stream.base_pointer, offset);
+	if(stream.mirrored || size <= size_to_end)
+	{
+		region.first_size = size;
+	}
+	else
+	{
+		region.first_size = size_to_end;
+		region.second = stream.base_pointer;
+		region.second_size = size - size_to_end;
+	}
+
+	return region;
+}
+
+// NOTE(james): bytes the consumer can read right now.  Safe to call from either side, but
+// from the producer it's only a lower bound on free space the moment it returns.
+internal
+memory_index psSpscRingReadAvailable(ps_spsc_ring_stream& stream)
+{
+	u64 read_position = AtomicLoadAcquireU64(&stream.read_position);
+	u64 write_position = AtomicLoadAcquireU64(&stream.write_position);
+	return (memory_index)(write_position - read_position);
+}
+
+internal
+memory_index psSpscRingWriteAvailable(ps_spsc_ring_stream& stream)
+{
+	return stream.max_size - psSpscRingReadAvailable(stream);
+}
+
+// NOTE(james): Zero copy access for producers that can write straight into the ring (a
+// decoder, a file read) and consumers that can work straight out of it (staging uploads,
+// the audio device).  Reserve/Peek hand back up to size bytes of what's free/waiting -
+// ask for max_size to get all of it - and nothing moves until Commit/Consume, which can
+// be for less than was handed out.  Reserve/Commit are producer only, Peek/Consume are
+// consumer only.
+internal
+ps_ring_region psSpscRingReserve(ps_spsc_ring_stream& stream, memory_index size)
+{
+	u64 write_position = stream.write_position;
+	u64 read_position = AtomicLoadAcquireU64(&stream.read_position);
+
+	memory_index free_size = stream.max_size - (memory_index)(write_position - read_position);
+	IFF(size > free_size, size = free_size);
+
+	return psSpscRingRegionAt(stream, write_position, size);
+}
+
+internal
+void psSpscRingCommit(ps_spsc_ring_stream& stream, memory_index size)
+{
+	u64 write_position = stream.write_position;
+	ASSERT(size <= stream.max_size - (memory_index)(write_position - AtomicLoadAcquireU64(&stream.read_position)));
+	AtomicStoreReleaseU64(&stream.write_position, write_position + size);
+}
+
+internal
+ps_ring_region psSpscRingPeek(ps_spsc_ring_stream& stream, memory_index size)
+{
+	u64 read_position = stream.read_position;
+	u64 write_position = AtomicLoadAcquireU64(&stream.write_position);
+
+	memory_index waiting_size = (memory_index)(write_position - read_position);
+	IFF(size > waiting_size, size = waiting_size);
+
+	return psSpscRingRegionAt(stream, read_position, size);
+}
+
+internal
+void psSpscRingConsume(ps_spsc_ring_stream& stream, memory_index size)
+{
+	u64 read_position = stream.read_position;
+	ASSERT(size <= (memory_index)(AtomicLoadAcquireU64(&stream.write_position) - read_position));
+	AtomicStoreReleaseU64(&stream.read_position, read_position + size);
+}
+
+// Producer only.  Writes as much of src as currently fits and returns how much that was.
+internal
+memory_index psSpscRingTryWrite(ps_spsc_ring_stream& stream, const void* src, memory_index writeSize)
+{
+	ps_ring_region region = psSpscRingReserve(stream, writeSize);
+	memory_index written = psRingRegionSize(region);
+	if(written)
+	{
+		Copy(region.first_size, src, region.first);
+		Copy(region.second_size, OffsetPtr(src, region.first_size), region.second);
+		psSpscRingCommit(stream, written);
+	}
+
+	return written;
+}
+
+// Consumer only.  Reads up to readSize bytes of whatever is waiting and returns how much that was.
+internal
+memory_index psSpscRingTryRead(ps_spsc_ring_stream& stream, void* outbuffer, memory_index readSize)
+{
+	ps_ring_region region = psSpscRingPeek(stream, readSize);
+	memory_index read = psRingRegionSize(region);
+	if(read)
+	{
+		Copy(region.first_size, region.first, outbuffer);
+		Copy(region.second_size, region.second, OffsetPtr(outbuffer, region.first_size));
+		psSpscRingConsume(stream, read);
+	}
+
+	return read;
+}
+
+// NOTE(james): The blocking versions spin until everything has gone through, a piece at
+// a time as the other side makes room, so sizes bigger than the ring are fine.  They never
+// go to sleep - the ring has no way to wake anybody up - so they're only for when the other
+// side is running right now and keeping up, like the mixer feeding the audio thread.
+// Anything that could be waiting a while (a loader behind the disk) should use the Try
+// versions and go do something else when they come back short.
+internal
+void psSpscRingWrite(ps_spsc_ring_stream& stream, const void* src, memory_index writeSize)
+{
+	while(writeSize)
+	{
+		memory_index written = psSpscRingTryWrite(stream, src, writeSize);
+		if(written)
+		{
+			src = OffsetPtr(src, written);
+			writeSize -= written;
+		}
+		else
+		{
+			YieldProcessor();
+		}
+	}
+}
+
+internal
+void psSpscRingRead(ps_spsc_ring_stream& stream, void* outbuffer, memory_index readSize)
+{
+	while(readSize)
+	{
+		memory_index read = psSpscRingTryRead(stream, outbuffer, readSize);
+		if(read)
+		{
+			outbuffer = OffsetPtr(outbuffer, read);
+			readSize -= read;
+		}
+		else
+		{
+			YieldProcessor();
+		}
+	}
+}
+
+// NOTE(james): Binary reader/writer for packed data (asset packs, save states, input
+// recordings).  Everything is stored little endian unless a function says BE.  Values go
+// in and out with a Copy, since the cursor is rarely aligned for them, which on a little
+// endian machine still comes out as a plain unaligned load/store.
+// Running off the end doesn't ASSERT, since the bytes may well have come off disk;
+// the stream sets a sticky error flag instead, writes stop and reads return zero, so a
+// loader can read a whole header and check the flag once at the end.
+#ifdef PLATFORM_BIG_ENDIAN
+#define psLittleEndian(value) ByteSwap(value)
+#define psBigEndian(value) (value)
+#else
+#define psLittleEndian(value) (value)
+#define psBigEndian(value) ByteSwap(value)
+#endif
+
+// a u64 in LEB128 takes at most 10 bytes
+#define PS_VARINT_MAX_SIZE 10
+
+inline u64
+psZigZagEncode(s64 value)
+{
+	// small magnitudes of either sign map to small unsigned values: 0, -1, 1, -2 -> 0, 1, 2, 3
+	return ((u64)value << 1) ^ (u64)(value >> 63);
+}
+
+inline s64
+psZigZagDecode(u64 value)
+{
+	return (s64)(value >> 1) ^ -(s64)(value & 1);
+}
+
+struct ps_binary_writer
+{
+	u8*				base_pointer;
+	memory_index	max_size;
+	memory_index	cursor;
+	// NOTE(james): when set, the writer grows on this arena instead of failing
+	memory_arena*	arena;
+	b32				error;
+};
+
+internal
+ps_binary_writer psMakeBinaryWriter(buffer dest)
+{
+	ps_binary_writer writer{};
+	writer.base_pointer = dest.data;
+	writer.max_size = dest.size;
+
+	return writer;
+}
+
+internal
+ps_binary_writer psMakeBinaryWriter(memory_arena& arena, memory_index initial_size = Kilobytes(4))
+{
+	ps_binary_writer writer{};
+	writer.arena = &arena;
+	writer.base_pointer = (u8*)PushSize(arena, initial_size, AlignNoClear(16));
+	writer.max_size = initial_size;
+
+	return writer;
+}
+
+// NOTE(james): what has been written so far
+inline buffer
+psBinaryWriterBuffer(const ps_binary_writer& writer)
+{
+	buffer result = { writer.cursor, writer.base_pointer };
+	return result;
+}
+
+internal
+b32 psBinaryWriterGrow(ps_binary_writer& writer, memory_index size)
+{
+	if(!writer.arena)
+	{
+		return false;
+	}
+
+	memory_index new_size = Maximum(writer.max_size*2, writer.cursor + size);
+	if(!TryGrowInPlace(*writer.arena, writer.base_pointer, writer.max_size, new_size, NoClear()))
+	{
+		// NOTE(james): the old copy stays behind on the arena until the arena is cleared
+		u8* new_base = (u8*)PushSize(*writer.arena, new_size, AlignNoClear(16));
+		Copy(writer.cursor, writer.base_pointer, new_base);
+		writer.base_pointer = new_base;
+	}
+	writer.max_size = new_size;
+
+	return true;
+}
+
+// NOTE(james): hands back room for size bytes and moves past it, zero once the writer has
+// failed.  Good for filling something in place instead of building it on the side.
+internal
+void* psWriteReserve(ps_binary_writer& writer, memory_index size)
+{
+	if(writer.error)
+	{
+		return 0;
+	}
+	if(size > writer.max_size - writer.cursor && !psBinaryWriterGrow(writer, size))
+	{
+		writer.error = true;
+		return 0;
+	}
+
+	void* result = writer.base_pointer + writer.cursor;
+	writer.cursor += size;
+
+	return result;
+}
+
+internal
+b32 psWriteBytes(ps_binary_writer& writer, const void* src, memory_index size)
+{
+	void* dest = psWriteReserve(writer, size);
+	if(dest)
+	{
+		Copy(size, src, dest);
+	}
+
+	return dest != 0;
+}
+
+// pads with zeros up to the next multiple of alignment
+internal
+b32 psWriteAlign(ps_binary_writer& writer, memory_index alignment)
+{
+	ASSERT(alignment && IsPow2((u32)alignment));
+	memory_index padding = AlignPow2(writer.cursor, alignment) - writer.cursor;
+	void* dest = psWriteReserve(writer, padding);
+	if(dest)
+	{
+		ZeroSize(padding, dest);
+	}
+
+	return !writer.error;
+}
+
+// NOTE(james): a bulk array of fixed size elements, aligned so psReadSpan can hand it
+// back in place.  Alignment is relative to the start of the stream, so keep the start of
+// the stream at least that aligned when it's loaded back.
+internal
+b32 psWriteSpan(ps_binary_writer& writer, const void* src, memory_index size, memory_index alignment)
+{
+	return psWriteAlign(writer, alignment) && psWriteBytes(writer, src, size);
+}
+
+#define psWriteSpanOf(writer, src, type, count) psWriteSpan(writer, src, sizeof(type)*(count), alignof(type))
+
+template<typename T>
+inline b32
+psWriteValue_(ps_binary_writer& writer, T value)
+{
+	void* dest = psWriteReserve(writer, sizeof(T));
+	if(dest)
+	{
+		Copy(sizeof(T), &value, dest);
+	}
+
+	return dest != 0;
+}
+
+inline b32 psWriteU8(ps_binary_writer& writer, u8 value) { return psWriteValue_(writer, value); }
+inline b32 psWriteU16(ps_binary_writer& writer, u16 value) { return psWriteValue_(writer, psLittleEndian(value)); }
+inline b32 psWriteU32(ps_binary_writer& writer, u32 value) { return psWriteValue_(writer, psLittleEndian(value)); }
+inline b32 psWriteU64(ps_binary_writer& writer, u64 value) { return psWriteValue_(writer, psLittleEndian(value)); }
+inline b32 psWriteS32(ps_binary_writer& writer, s32 value) { return psWriteU32(writer, (u32)value); }
+inline b32 psWriteS64(ps_binary_writer& writer, s64 value) { return psWriteU64(writer, (u64)value); }
+inline b32 psWriteF32(ps_binary_writer& writer, f32 value) { u32 bits; Copy(sizeof(bits), &value, &bits); return psWriteU32(writer, bits); }
+inline b32 psWriteF64(ps_binary_writer& writer, f64 value) { u64 bits; Copy(sizeof(bits), &value, &bits); return psWriteU64(writer, bits); }
+
+inline b32 psWriteU16BE(ps_binary_writer& writer, u16 value) { return psWriteValue_(writer, psBigEndian(value)); }
+inline b32 psWriteU32BE(ps_binary_writer& writer, u32 value) { return psWriteValue_(writer, psBigEndian(value)); }
+inline b32 psWriteU64BE(ps_binary_writer& writer, u64 value) { return psWriteValue_(writer, psBigEndian(value)); }
+
+// LEB128, 7 bits a byte with the high bit set on all but the last
+internal
+b32 psWriteVarU64(ps_binary_writer& writer, u64 value)
+{
+	u8 bytes[PS_VARINT_MAX_SIZE];
+	u32 count = 0;
+	while(value >= 0x80)
+	{
+		bytes[count++] = (u8)value | 0x80;
+		value >>= 7;
+	}
+	bytes[count++] = (u8)value;
+
+	return psWriteBytes(writer, bytes, count);
+}
+
+inline b32 psWriteVarS64(ps_binary_writer& writer, s64 value) { return psWriteVarU64(writer, psZigZagEncode(value)); }
+
+struct ps_binary_reader
+{
+	const u8*		base_pointer;
+	memory_index	size;
+	memory_index	cursor;
+	b32				error;
+};
+
+internal
+ps_binary_reader psMakeBinaryReader(const void* src, memory_index size)
+{
+	ps_binary_reader reader{};
+	reader.base_pointer = (const u8*)src;
+	reader.size = size;
+
+	return reader;
+}
+
+internal
+ps_binary_reader psMakeBinaryReader(buffer src)
+{
+	return psMakeBinaryReader(src.data, src.size);
+}
+
+inline memory_index
+psBinaryReaderRemaining(const ps_binary_reader& reader)
+{
+	return reader.size - reader.cursor;
+}
+
+inline b32
+psBinaryReaderAtEnd(const ps_binary_reader& reader)
+{
+	return reader.cursor == reader.size;
+}
+
+// NOTE(james): points at the next size bytes in place and moves past them, zero if there
+// aren't that many left (which also fails the reader)
+internal
+const void* psReadBytesInPlace(ps_binary_reader& reader, memory_index size)
+{
+	if(reader.error || size > reader.size - reader.cursor)
+	{
+		reader.error = true;
+		return 0;
+	}
+
+	const void* result = reader.base_pointer + reader.cursor;
+	reader.cursor += size;
+
+	return result;
+}
+
+internal
+b32 psReadBytes(ps_binary_reader& reader, void* dest, memory_index size)
+{
+	const void* src = psReadBytesInPlace(reader, size);
+	if(src)
+	{
+		Copy(size, src, dest);
+	}
+	else
+	{
+		ZeroSize(size, dest);
+	}
+
+	return src != 0;
+}
+
+internal
+b32 psReadAlign(ps_binary_reader& reader, memory_index alignment)
+{
+	ASSERT(alignment && IsPow2((u32)alignment));
+	memory_index padding = AlignPow2(reader.cursor, alignment) - reader.cursor;
+	psReadBytesInPlace(reader, padding);
+
+	return !reader.error;
+}
+
+// NOTE(james): the other half of psWriteSpan, the data is handed back without a copy.
+// The alignment has to match what it was written with.
+internal
+const void* psReadSpan(ps_binary_reader& reader, memory_index size, memory_index alignment)
+{
+	if(!psReadAlign(reader, alignment))
+	{
+		return 0;
+	}
+
+	return psReadBytesInPlace(reader, size);
+}
+
+#define psReadSpanOf(reader, type, count) ((const type*)psReadSpan(reader, sizeof(type)*(count), alignof(type)))
+
+template<typename T>
+inline T
+psReadValue_(ps_binary_reader& reader)
+{
+	T value = 0;
+	const void* src = psReadBytesInPlace(reader, sizeof(T));
+	if(src)
+	{
+		Copy(sizeof(T), src, &value);
+	}
+
+	return value;
+}
+
+inline u8 psReadU8(ps_binary_reader& reader) { return psReadValue_<u8>(reader); }
+inline u16 psReadU16(ps_binary_reader& reader) { return psLittleEndian(psReadValue_<u16>(reader)); }
+inline u32 psReadU32(ps_binary_reader& reader) { return psLittleEndian(psReadValue_<u32>(reader)); }
+inline u64 psReadU64(ps_binary_reader& reader) { return psLittleEndian(psReadValue_<u64>(reader)); }
+inline s32 psReadS32(ps_binary_reader& reader) { return (s32)psReadU32(reader); }
+inline s64 psReadS64(ps_binary_reader& reader) { return (s64)psReadU64(reader); }
+inline f32 psReadF32(ps_binary_reader& reader) { u32 bits = psReadU32(reader); f32 value; Copy(sizeof(value), &bits, &value); return value; }
+inline f64 psReadF64(ps_binary_reader& reader) { u64 bits = psReadU64(reader); f64 value; Copy(sizeof(value), &bits, &value); return value; }
+
+inline u16 psReadU16BE(ps_binary_reader& reader) { return psBigEndian(psReadValue_<u16>(reader)); }
+inline u32 psReadU32BE(ps_binary_reader& reader) { return psBigEndian(psReadValue_<u32>(reader)); }
+inline u64 psReadU64BE(ps_binary_reader& reader) { return psBigEndian(psReadValue_<u64>(reader)); }
+
+internal
+u64 psReadVarU64(ps_binary_reader& reader)
+{
+	if(reader.error)
+	{
+		return 0;
+	}
+
+	const u8* src = reader.base_pointer + reader.cursor;
+	memory_index remaining = reader.size - reader.cursor;
+	// only look at what's there, and never further than a u64 can go
+	memory_index max_count = Minimum(remaining, (memory_index)PS_VARINT_MAX_SIZE);
+
+	u64 value = 0;
+	for(memory_index index = 0; index < max_count; ++index)
+	{
+		u8 byte = src[index];
+		value |= (u64)(byte & 0x7F) << (7*index);
+		if(!(byte & 0x80))
+		{
+			reader.cursor += index + 1;
+			return value;
+		}
+	}
+
+	// ran off the end of the data, or more continuation bytes than a u64 can have
+	reader.error = true;
+	return 0;
+}
+
+inline s64 psReadVarS64(ps_binary_reader& reader) { return psZigZagDecode(psReadVarU64(reader)); }
+
+#if TEST_COLLECTIONS
+// NOTE(james): EXPECT looks at its condition twice, so every read goes into a local first
+b32 TestBinaryStream()
+{
+	memory_arena scratch = {};
+
+	// a tiny start so the writer has to grow, and a byte up front so nothing after it is aligned
+	ps_binary_writer writer = psMakeBinaryWriter(scratch, 8);
+	psWriteU8(writer, 0xAB);
+	psWriteU16(writer, 0x1234);
+	psWriteU32(writer, 0xDEADBEEF);
+	psWriteU64(writer, 0x0123456789ABCDEFull);
+	psWriteS32(writer, -12345);
+	psWriteS64(writer, -1234567890123ll);
+	psWriteF32(writer, 1.5f);
+	psWriteF64(writer, -0.25);
+	psWriteU16BE(writer, 0x0102);
+	psWriteU32BE(writer, 0x01020304);
+	psWriteU64BE(writer, 0x0102030405060708ull);
+	EXPECT(!writer.error);
+
+	buffer written = psBinaryWriterBuffer(writer);
+	EXPECT(written.size == 1+2+4+8+4+8+4+8+2+4+8);
+	// little endian unless it says otherwise
+	EXPECT(written.data[1] == 0x34 && written.data[2] == 0x12);
+	EXPECT(written.data[39] == 0x01 && written.data[40] == 0x02);
+	EXPECT(written.data[41] == 0x01 && written.data[44] == 0x04);
+	EXPECT(written.data[45] == 0x01 && written.data[52] == 0x08);
+
+	ps_binary_reader reader = psMakeBinaryReader(written);
+	u8 readU8 = psReadU8(reader);
+	u16 readU16 = psReadU16(reader);
+	u32 readU32 = psReadU32(reader);
+	u64 readU64 = psReadU64(reader);
+	s32 readS32 = psReadS32(reader);
+	s64 readS64 = psReadS64(reader);
+	f32 readF32 = psReadF32(reader);
+	f64 readF64 = psReadF64(reader);
+	u16 readU16BE = psReadU16BE(reader);
+	u32 readU32BE = psReadU32BE(reader);
+	u64 readU64BE = psReadU64BE(reader);
+	EXPECT(readU8 == 0xAB && readU16 == 0x1234 && readU32 == 0xDEADBEEF && readU64 == 0x0123456789ABCDEFull);
+	EXPECT(readS32 == -12345 && readS64 == -1234567890123ll);
+	EXPECT(readF32 == 1.5f && readF64 == -0.25);
+	EXPECT(readU16BE == 0x0102 && readU32BE == 0x01020304 && readU64BE == 0x0102030405060708ull);
+	EXPECT(psBinaryReaderAtEnd(reader) && !reader.error);
+
+	// varints right at the edges of each byte count
+	u64 unsignedValues[] = { 0, 127, 128, 16383, 16384, U32MAX, 0xFFFFFFFFFFFFFFFFull };
+	u32 unsignedSizes[] = { 1, 1, 2, 2, 3, 5, PS_VARINT_MAX_SIZE };
+	s64 signedValues[] = { 0, -1, 1, -64, 64, (s64)0x7FFFFFFFFFFFFFFFll, -(s64)0x7FFFFFFFFFFFFFFFll - 1 };
+	u32 signedSizes[] = { 1, 1, 1, 1, 2, PS_VARINT_MAX_SIZE, PS_VARINT_MAX_SIZE };
+	EXPECT(psZigZagEncode(-1) == 1 && psZigZagEncode(1) == 2 && psZigZagEncode(-2) == 3);
+
+	writer = psMakeBinaryWriter(scratch);
+	for(u32 index = 0; index < ARRAY_COUNT(unsignedValues); ++index)
+	{
+		memory_index start = writer.cursor;
+		psWriteVarU64(writer, unsignedValues[index]);
+		EXPECT(writer.cursor - start == unsignedSizes[index]);
+	}
+	for(u32 index = 0; index < ARRAY_COUNT(signedValues); ++index)
+	{
+		memory_index start = writer.cursor;
+		psWriteVarS64(writer, signedValues[index]);
+		EXPECT(writer.cursor - start == signedSizes[index]);
+	}
+
+	reader = psMakeBinaryReader(psBinaryWriterBuffer(writer));
+	for(u32 index = 0; index < ARRAY_COUNT(unsignedValues); ++index)
+	{
+		u64 value = psReadVarU64(reader);
+		EXPECT(value == unsignedValues[index]);
+	}
+	for(u32 index = 0; index < ARRAY_COUNT(signedValues); ++index)
+	{
+		s64 value = psReadVarS64(reader);
+		EXPECT(value == signedValues[index]);
+	}
+	EXPECT(psBinaryReaderAtEnd(reader) && !reader.error);
+
+	// a fixed buffer stops at the end, and stays stopped even for things that would fit
+	u8 fixed[6] = {};
+	writer = psMakeBinaryWriter(buffer{ sizeof(fixed), fixed });
+	b32 wroteFirst = psWriteU32(writer, 0x11223344);
+	b32 wroteSecond = psWriteU32(writer, 0x55667788);
+	EXPECT(wroteFirst && !wroteSecond);
+	EXPECT(writer.error && writer.cursor == 4);
+	b32 wroteAfter = psWriteU8(writer, 1);
+	EXPECT(!wroteAfter && writer.cursor == 4 && fixed[4] == 0);
+
+	reader = psMakeBinaryReader(fixed, 4);
+	u16 inside = psReadU16(reader);
+	u32 pastEnd = psReadU32(reader);
+	EXPECT(inside == 0x3344 && pastEnd == 0 && reader.error);
+	u8 afterError = psReadU8(reader);
+	EXPECT(afterError == 0 && reader.cursor == 2);
+
+	// varints cut short, and ones with more continuation bytes than a u64 can have
+	u8 truncated[] = { 0x80, 0x80 };
+	reader = psMakeBinaryReader(truncated, sizeof(truncated));
+	u64 truncatedValue = psReadVarU64(reader);
+	EXPECT(truncatedValue == 0 && reader.error);
+	u8 overlong[PS_VARINT_MAX_SIZE + 1];
+	for(u32 index = 0; index < ARRAY_COUNT(overlong); ++index)
+	{
+		overlong[index] = 0x80;
+	}
+	overlong[PS_VARINT_MAX_SIZE] = 0;
+	reader = psMakeBinaryReader(overlong, sizeof(overlong));
+	u64 overlongValue = psReadVarU64(reader);
+	EXPECT(overlongValue == 0 && reader.error && reader.cursor == 0);
+
+	// spans come back in place and aligned after an odd sized header
+	u32 words[5] = { 1, 2, 3, 4, 5 };
+	u64 longs[3] = { 10, 20, 30 };
+	writer = psMakeBinaryWriter(scratch);
+	psWriteU8(writer, 7);
+	psWriteSpanOf(writer, words, u32, ARRAY_COUNT(words));
+	psWriteU8(writer, 9);
+	psWriteSpanOf(writer, longs, u64, ARRAY_COUNT(longs));
+	EXPECT(!writer.error);
+
+	reader = psMakeBinaryReader(psBinaryWriterBuffer(writer));
+	u8 firstHeader = psReadU8(reader);
+	const u32* readWords = psReadSpanOf(reader, u32, ARRAY_COUNT(words));
+	u8 secondHeader = psReadU8(reader);
+	const u64* readLongs = psReadSpanOf(reader, u64, ARRAY_COUNT(longs));
+	EXPECT(firstHeader == 7 && secondHeader == 9);
+	EXPECT(readWords && ((umm)readWords & (alignof(u32) - 1)) == 0);
+	EXPECT(MemCompare(sizeof(words), readWords, words));
+	EXPECT(readLongs && ((umm)readLongs & (alignof(u64) - 1)) == 0);
+	EXPECT(MemCompare(sizeof(longs), readLongs, longs));
+	EXPECT(psBinaryReaderAtEnd(reader) && !reader.error);
+
+	// asking for more than is left fails the span and the reader
+	reader = psMakeBinaryReader(psBinaryWriterBuffer(writer));
+	psReadU8(reader);
+	const u32* tooMany = psReadSpanOf(reader, u32, 100);
+	EXPECT(!tooMany && reader.error);
+
+	Clear(scratch);
+	return true;
+}
+
+struct test_spsc_producer
+{
+	ps_spsc_ring_stream* stream;
+	memory_index size;
+	b32 zeroCopy;
+};
+
+internal u8
+TestSpscByte(memory_index index)
+{
+	return (u8)((index * 31) ^ (index >> 8));
+}
+
+internal
+PLATFORM_WORK_QUEUE_CALLBACK(TestSpscProduce)
+{
+	test_spsc_producer* producer = (test_spsc_producer*)data;
+	ps_spsc_ring_stream& stream = *producer->stream;
+
+	u8 chunk[97];
+	memory_index produced = 0;
+	while(produced < producer->size)
+	{
+		// odd sized pieces, so they keep landing across the end of the buffer
+		memory_index size = Minimum((memory_index)(1 + (produced % ARRAY_COUNT(chunk))), producer->size - produced);
+		if(producer->zeroCopy)
+		{
+			ps_ring_region region = psSpscRingReserve(stream, size);
+			memory_index reserved = psRingRegionSize(region);
+			for(memory_index index = 0; index < reserved; ++index)
+			{
+				u8* dest = index < region.first_size ? (u8*)region.first + index : (u8*)region.second + (index - region.first_size);
+				*dest = TestSpscByte(produced + index);
+			}
+			psSpscRingCommit(stream, reserved);
+			produced += reserved;
+			if(!reserved)
+			{
+				YieldProcessor();
+			}
+		}
+		else
+		{
+			for(memory_index index = 0; index < size; ++index)
+			{
+				chunk[index] = TestSpscByte(produced + index);
+			}
+			psSpscRingWrite(stream, chunk, size);
+			produced += size;
+		}
+	}
+}
+
+b32 TestSpscRingStream(platform_work_queue* queue)
+{
+	memory_arena scratch = {};
+
+	// not a power of two, and a lot smaller than what goes through it
+	const memory_index ringSize = 1000;
+	const memory_index totalSize = 1024*1024;
+	void* ringMemory = PushSize(scratch, ringSize);
+	u8* received = (u8*)PushSize(scratch, totalSize, NoClear());
+
+	for(b32 zeroCopy = 0; zeroCopy < 2; ++zeroCopy)
+	{
+		ps_spsc_ring_stream stream = {};
+		psInitSpscRingStream(stream, ringMemory, ringSize);
+
+		// NOTE(james): the producer goes to a worker and this thread stays the consumer, it
+		// only helps out on the queue once everything has come through
+		test_spsc_producer producer = { &stream, totalSize, zeroCopy };
+		platform_work_counter counter = {};
+		Platform.AddCountedWorkEntry(queue, TestSpscProduce, &producer, &counter);
+
+		memory_index consumed = 0;
+		while(consumed < totalSize)
+		{
+			memory_index size = Minimum((memory_index)(1 + (consumed % 251)), totalSize - consumed);
+			if(zeroCopy)
+			{
+				ps_ring_region region = psSpscRingPeek(stream, size);
+				Copy(region.first_size, region.first, received + consumed);
+				Copy(region.second_size, region.second, received + consumed + region.first_size);
+				memory_index peeked = psRingRegionSize(region);
+				psSpscRingConsume(stream, peeked);
+				consumed += peeked;
+				if(!peeked)
+				{
+					YieldProcessor();
+				}
+			}
+			else
+			{
+				psSpscRingRead(stream, received + consumed, size);
+				consumed += size;
+			}
+		}
+		Platform.CompleteCounterWork(queue, &counter);
+
+		EXPECT(psSpscRingReadAvailable(stream) == 0);
+		EXPECT(stream.read_position == totalSize && stream.write_position == totalSize);
+		for(memory_index index = 0; index < totalSize; ++index)
+		{
+			EXPECT(received[index] == TestSpscByte(index));
+		}
+	}
+
+	Clear(scratch);
+	return true;
+}
+
+// NOTE(james): the threaded tests only run when there is a work queue to run them on
+b32 TestStreams(platform_work_queue* queue)
+{
+	b32 passed = true;
+	passed &= TestBinaryStream();
+
+	if(queue)
+	{
+		passed &= TestSpscRingStream(queue);
+	}
+
+	return passed;
+}
+#endif
@@ -7,6 +7,10 @@
 #define PROJECTSUPER_MACOS 0
 #endif
 
+#if !defined(PROJECTSUPER_LINUX)
+#define PROJECTSUPER_LINUX 0
+#endif
+
 #if PROJECTSUPER_SLOW
 // define NDEBUG so that assert.h will compile out assert(..)
 #define NDEBUG 1
@@ -0,0 +1,922 @@
+/*******************************************************************************
+
+    Work stealing job queue shared by the platform layers
+
+    Each worker thread owns a Chase-Lev deque.  The owner pushes and pops
+    at the bottom, every other thread steals from the top, so a job that
+    spawns more jobs keeps them local until somebody idle comes looking.
+    Threads that are not workers of a queue (the main thread, workers of the
+    other queue) submit through a small ticket-locked injection ring.
+
+    Batches sit on top of that.  A batch holds a counter slot with a
+    generation, so the handle handed back to the game can go stale safely,
+    and a list of dependent batches that get released when it finishes.
+    A batch with unfinished prerequisites keeps its entries on a deferred
+    list until the last prerequisite completes.
+
+    Every thread that runs work gets its own scratch arena, bootstrapped
+    the first time it runs an entry.  Each callback runs inside a
+    temporary memory scope on it, so jobs can allocate freely without
+    touching a shared arena or pre-allocating from the main thread.
+
+    The including platform layer has to provide, before including this file:
+
+        platform_semaphore
+        internal void PlatformSemaphoreSignal(platform_semaphore& semaphore, u32 count);
+        internal void PlatformSemaphoreWait(platform_semaphore& semaphore);
+        internal void PlatformYieldThread();
+
+********************************************************************************/
+
+#define PLATFORM_WORK_MAX_WORKERS 16
+#define PLATFORM_WORK_DEQUE_SIZE 512
+#define PLATFORM_WORK_INJECTION_SIZE 1024
+#define PLATFORM_WORK_SPIN_COUNT 64
+#define PLATFORM_WORK_MAX_BATCHES 256
+#define PLATFORM_WORK_MAX_DEPENDENTS 16
+#define PLATFORM_WORK_MAX_DEFERRED 4096
+#define PLATFORM_WORK_SCRATCH_BLOCK_SIZE Megabytes(1)
+
+CompileAssert((PLATFORM_WORK_DEQUE_SIZE & (PLATFORM_WORK_DEQUE_SIZE-1)) == 0);
+CompileAssert((PLATFORM_WORK_INJECTION_SIZE & (PLATFORM_WORK_INJECTION_SIZE-1)) == 0);
+
+struct platform_work_batch;
+
+struct platform_work_queue_entry
+{
+    platform_work_queue_callback *callback;
+    void *data;
+    platform_work_counter *counter;
+    platform_work_batch *batch;
+};
+
+struct platform_work_deferred
+{
+    platform_work_queue_entry entry;
+    platform_work_deferred* next;
+};
+
+struct platform_work_batch
+{
+    // NOTE(james): entries still to run, plus one until the batch has been released
+    platform_work_counter counter;
+    // NOTE(james): unfinished prerequisites, plus one while the batch is being added
+    u32 volatile pendingPrerequisites;
+    u32 volatile generation;
+
+    u32 dependentCount;
+    u32 dependents[PLATFORM_WORK_MAX_DEPENDENTS];
+    platform_work_deferred* deferred;
+};
+
+struct platform_work_deque
+{
+    // NOTE(james): top and bottom are signed so an owner pop on an empty deque
+    // can briefly drop bottom below top.  Kept on their own cache lines since
+    // thieves hammer top while the owner hammers bottom.
+    s64 volatile top;
+    u8 pad0[56];
+    s64 volatile bottom;
+    u8 pad1[56];
+
+    platform_work_queue_entry entries[PLATFORM_WORK_DEQUE_SIZE];
+};
+
+struct platform_work_worker
+{
+    platform_work_deque deque;
+
+    platform_work_queue* queue;
+    u32 workerIndex;
+    u32 stealSeed;
+};
+
+struct platform_work_queue
+{
+    u32 volatile countToComplete;
+    u32 volatile countCompleted;
+
+    u32 workerCount;
+    platform_work_worker workers[PLATFORM_WORK_MAX_WORKERS];
+
+    // NOTE(james): To touch the injection ring, you have to take a ticket!
+    ticket_mutex injectionMutex;
+    u32 volatile injectionReadIndex;
+    u32 volatile injectionWriteIndex;
+    platform_work_queue_entry injection[PLATFORM_WORK_INJECTION_SIZE];
+
+    platform_semaphore semaphore;
+
+    // NOTE(james): To touch the batch free list, dependents or deferred entries,
+    // you have to take a ticket!
+    ticket_mutex batchMutex;
+    u32 freeBatchCount;
+    u32 freeBatches[PLATFORM_WORK_MAX_BATCHES];
+    platform_work_batch batches[PLATFORM_WORK_MAX_BATCHES];
+
+    u32 freeDeferredCount;
+    platform_work_deferred* firstFreeDeferred;
+    platform_work_deferred deferredPool[PLATFORM_WORK_MAX_DEFERRED];
+};
+
+global_variable thread_local platform_work_worker* ThreadLocalWorker;
+global_variable thread_local memory_arena* ThreadLocalScratch;
+
+inline platform_work_worker*
+GetLocalWorker(platform_work_queue* queue)
+{
+    platform_work_worker* worker = ThreadLocalWorker;
+    return (worker && worker->queue == queue) ? worker : 0;
+}
+
+//------------------------
+//---- CHASE-LEV DEQUE
+//------------------------
+
+internal b32
+WorkDequePush(platform_work_deque& deque, const platform_work_queue_entry& entry)
+{
+    s64 bottom = deque.bottom;
+    s64 top = (s64)AtomicLoadAcquireU64((u64 volatile*)&deque.top);
+
+    if(bottom - top >= PLATFORM_WORK_DEQUE_SIZE)
+    {
+        return false;
+    }
+
+    deque.entries[bottom & (PLATFORM_WORK_DEQUE_SIZE-1)] = entry;
+    AtomicStoreReleaseU64((u64 volatile*)&deque.bottom, (u64)(bottom + 1));
+    return true;
+}
+
+internal b32
+WorkDequePop(platform_work_deque& deque, platform_work_queue_entry* entry)
+{
+    s64 bottom = deque.bottom - 1;
+    deque.bottom = bottom;
+    // NOTE(james): the store to bottom has to be visible before we read top,
+    // otherwise a thief and the owner can both take the last entry
+    CompletePreviousMemoryOpsBeforeFutureMemoryOps;
+    s64 top = deque.top;
+
+    b32 result = false;
+    if(top <= bottom)
+    {
+        *entry = deque.entries[bottom & (PLATFORM_WORK_DEQUE_SIZE-1)];
+        result = true;
+
+        if(top == bottom)
+        {
+            // last entry, race any thieves for it
+            if(AtomicCompareExchangeU64((u64 volatile*)&deque.top, (u64)(top + 1), (u64)top) != (u64)top)
+            {
+                result = false;
+            }
+            deque.bottom = bottom + 1;
+        }
+    }
+    else
+    {
+        deque.bottom = bottom + 1;
+    }
+
+    return result;
+}
+
+internal b32
+WorkDequeSteal(platform_work_deque& deque, platform_work_queue_entry* entry)
+{
+    s64 top = (s64)AtomicLoadAcquireU64((u64 volatile*)&deque.top);
+    CompletePreviousReadsBeforeFutureReads;
+    s64 bottom = (s64)AtomicLoadAcquireU64((u64 volatile*)&deque.bottom);
+
+    if(top < bottom)
+    {
+        *entry = deque.entries[top & (PLATFORM_WORK_DEQUE_SIZE-1)];
+        if(AtomicCompareExchangeU64((u64 volatile*)&deque.top, (u64)(top + 1), (u64)top) == (u64)top)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//------------------------
+//---- INJECTION RING
+//------------------------
+
+internal b32
+WorkInjectionPush(platform_work_queue* queue, const platform_work_queue_entry& entry)
+{
+    b32 result = false;
+
+    BeginTicketMutex(&queue->injectionMutex);
+    u32 writeIndex = queue->injectionWriteIndex;
+    if(writeIndex - queue->injectionReadIndex < PLATFORM_WORK_INJECTION_SIZE)
+    {
+        queue->injection[writeIndex & (PLATFORM_WORK_INJECTION_SIZE-1)] = entry;
+        AtomicStoreReleaseU32(&queue->injectionWriteIndex, writeIndex + 1);
+        result = true;
+    }
+    EndTicketMutex(&queue->injectionMutex);
+
+    return result;
+}
+
+internal b32
+WorkInjectionPop(platform_work_queue* queue, platform_work_queue_entry* entry)
+{
+    // NOTE(james): peek without the lock, and never wait on it, so idle workers
+    // don't convoy behind each other.  Whoever holds it is already draining.
+    if(AtomicLoadAcquireU32(&queue->injectionWriteIndex) == queue->injectionReadIndex ||
+       !TryBeginTicketMutex(&queue->injectionMutex))
+    {
+        return false;
+    }
+
+    b32 result = false;
+
+    u32 readIndex = queue->injectionReadIndex;
+    if(readIndex != queue->injectionWriteIndex)
+    {
+        *entry = queue->injection[readIndex & (PLATFORM_WORK_INJECTION_SIZE-1)];
+        queue->injectionReadIndex = readIndex + 1;
+        result = true;
+    }
+    EndTicketMutex(&queue->injectionMutex);
+
+    return result;
+}
+
+//------------------------
+//---- QUEUE
+//------------------------
+
+internal void WorkBatchDecrement(platform_work_queue* queue, platform_work_batch* batch);
+
+inline memory_arena&
+GetThreadScratchArena()
+{
+    if(!ThreadLocalScratch)
+    {
+        // NOTE(james): not restored, looped live code shouldn't replay job scratch
+        ThreadLocalScratch = BootstrapScratchArena("WorkScratch", NonRestoredArena(PLATFORM_WORK_SCRATCH_BLOCK_SIZE, PLATFORM_WORK_SCRATCH_BLOCK_SIZE));
+    }
+    return *ThreadLocalScratch;
+}
+
+inline void
+ExecuteWorkEntry(platform_work_queue* queue, const platform_work_queue_entry& entry)
+{
+    // NOTE(james): entries can nest when a job waits on other work, the
+    // temporary memory scopes unwind in the same order
+    memory_arena& scratch = GetThreadScratchArena();
+    temporary_memory scratchMemory = BeginTemporaryMemory(scratch);
+    entry.callback(queue, entry.data, scratch);
+    EndTemporaryMemory(scratchMemory);
+
+    if(entry.counter)
+    {
+        AtomicAddU32(&entry.counter->count, (u32)-1);
+    }
+    if(entry.batch)
+    {
+        WorkBatchDecrement(queue, entry.batch);
+    }
+    // NOTE(james): this has to come after the batch, so that CompleteAllWork can't
+    // return while a finished batch is still releasing its dependents
+    AtomicAddU32(&queue->countCompleted, 1);
+}
+
+// NOTE(james): the entry must already be counted in countToComplete
+internal void
+QueueWorkEntry(platform_work_queue* queue, const platform_work_queue_entry& entry)
+{
+    platform_work_worker* worker = GetLocalWorker(queue);
+    b32 queued = worker ? WorkDequePush(worker->deque, entry) : WorkInjectionPush(queue, entry);
+
+    if(queued)
+    {
+        PlatformSemaphoreSignal(queue->semaphore, 1);
+    }
+    else
+    {
+        // NOTE(james): there is no room anywhere, so do the work now instead of
+        // blocking the producer.  This is also what keeps deep recursive job
+        // trees from deadlocking once every deque fills up.
+        ExecuteWorkEntry(queue, entry);
+    }
+}
+
+internal void
+AddWorkQueueEntry_(platform_work_queue* queue, const platform_work_queue_entry& entry)
+{
+    AtomicAddU32(&queue->countToComplete, 1);
+    if(entry.counter)
+    {
+        AtomicAddU32(&entry.counter->count, 1);
+    }
+
+    QueueWorkEntry(queue, entry);
+}
+
+internal void
+AddWorkQueueEntry(platform_work_queue* queue, platform_work_queue_callback* callback, void* data)
+{
+    platform_work_queue_entry entry = { callback, data, 0, 0 };
+    AddWorkQueueEntry_(queue, entry);
+}
+
+internal void
+AddCountedWorkQueueEntry(platform_work_queue* queue, platform_work_queue_callback* callback, void* data, platform_work_counter* counter)
+{
+    platform_work_queue_entry entry = { callback, data, counter, 0 };
+    AddWorkQueueEntry_(queue, entry);
+}
+
+internal b32
+FindWorkQueueEntry(platform_work_queue* queue, platform_work_worker* worker, platform_work_queue_entry* entry)
+{
+    if(worker && WorkDequePop(worker->deque, entry))
+    {
+        return true;
+    }
+
+    if(WorkInjectionPop(queue, entry))
+    {
+        return true;
+    }
+
+    u32 workerCount = queue->workerCount;
+    if(workerCount)
+    {
+        // NOTE(james): start at a random victim so thieves spread out instead of
+        // all piling onto worker 0
+        u32 start = 0;
+        if(worker)
+        {
+            u32 x = worker->stealSeed;
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            worker->stealSeed = x;
+            start = x;
+        }
+        else
+        {
+            start = (u32)__rdtsc();
+        }
+
+        for(u32 victimOffset = 0; victimOffset < workerCount; ++victimOffset)
+        {
+            platform_work_worker* victim = queue->workers + ((start + victimOffset) % workerCount);
+            if(victim != worker && WorkDequeSteal(victim->deque, entry))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+internal b32
+DoNextWorkQueueEntry(platform_work_queue* queue)
+{
+    platform_work_queue_entry entry;
+    if(FindWorkQueueEntry(queue, GetLocalWorker(queue), &entry))
+    {
+        ExecuteWorkEntry(queue, entry);
+        return true;
+    }
+
+    return false;
+}
+
+inline void
+WaitForWorkQueueEntry(platform_work_queue* queue, u32* spinCount)
+{
+    if(DoNextWorkQueueEntry(queue))
+    {
+        *spinCount = 0;
+    }
+    else if(++*spinCount < PLATFORM_WORK_SPIN_COUNT)
+    {
+        YieldProcessor();
+    }
+    else
+    {
+        // NOTE(james): whatever we are waiting on is running on another thread,
+        // give up the core in case that thread is waiting for one
+        PlatformYieldThread();
+    }
+}
+
+internal void
+CompleteAllWorkQueueWork(platform_work_queue* queue)
+{
+    // NOTE(james): the counts only ever go up so that other threads can keep
+    // adding while we wait, u32 wrap around is fine for the compare
+    u32 spinCount = 0;
+    while(AtomicLoadAcquireU32(&queue->countToComplete) != AtomicLoadAcquireU32(&queue->countCompleted))
+    {
+        WaitForWorkQueueEntry(queue, &spinCount);
+    }
+}
+
+internal void
+CompleteCounterWork(platform_work_queue* queue, platform_work_counter* counter)
+{
+    // help out with whatever work is available until our own batch is done
+    u32 spinCount = 0;
+    while(AtomicLoadAcquireU32(&counter->count) != 0)
+    {
+        WaitForWorkQueueEntry(queue, &spinCount);
+    }
+}
+
+//------------------------
+//---- BATCHES
+//------------------------
+
+internal void WorkBatchRelease(platform_work_queue* queue, platform_work_batch* batch);
+
+internal void
+WorkBatchComplete(platform_work_queue* queue, platform_work_batch* batch)
+{
+    u32 dependentCount = 0;
+    u32 dependents[PLATFORM_WORK_MAX_DEPENDENTS];
+
+    BeginTicketMutex(&queue->batchMutex);
+    // NOTE(james): nobody can add a dependent once the generation moves on, so the
+    // copy is the final list
+    dependentCount = batch->dependentCount;
+    for(u32 index = 0; index < dependentCount; ++index)
+    {
+        dependents[index] = batch->dependents[index];
+    }
+    batch->dependentCount = 0;
+
+    u32 generation = batch->generation + 1;
+    if(generation == 0) generation = 1;
+    AtomicStoreReleaseU32(&batch->generation, generation);
+
+    queue->freeBatches[queue->freeBatchCount++] = (u32)(batch - queue->batches);
+    EndTicketMutex(&queue->batchMutex);
+
+    for(u32 index = 0; index < dependentCount; ++index)
+    {
+        platform_work_batch* dependent = queue->batches + dependents[index];
+        if(AtomicAddU32(&dependent->pendingPrerequisites, (u32)-1) == 1)
+        {
+            WorkBatchRelease(queue, dependent);
+        }
+    }
+}
+
+internal void
+WorkBatchDecrement(platform_work_queue* queue, platform_work_batch* batch)
+{
+    if(AtomicAddU32(&batch->counter.count, (u32)-1) == 1)
+    {
+        WorkBatchComplete(queue, batch);
+    }
+}
+
+internal void
+WorkBatchRelease(platform_work_queue* queue, platform_work_batch* batch)
+{
+    // NOTE(james): only the thread that dropped the last prerequisite gets here,
+    // so the deferred list is ours once it has been unhooked
+    BeginTicketMutex(&queue->batchMutex);
+    platform_work_deferred* first = batch->deferred;
+    batch->deferred = 0;
+    EndTicketMutex(&queue->batchMutex);
+
+    platform_work_deferred* last = 0;
+    u32 deferredCount = 0;
+    for(platform_work_deferred* deferred = first; deferred; deferred = deferred->next)
+    {
+        QueueWorkEntry(queue, deferred->entry);
+        last = deferred;
+        ++deferredCount;
+    }
+
+    if(last)
+    {
+        BeginTicketMutex(&queue->batchMutex);
+        last->next = queue->firstFreeDeferred;
+        queue->firstFreeDeferred = first;
+        queue->freeDeferredCount += deferredCount;
+        EndTicketMutex(&queue->batchMutex);
+    }
+
+    // drop the reference that kept the batch open until it was released
+    WorkBatchDecrement(queue, batch);
+}
+
+// NOTE(james): the batch mutex has to be held.  Returns the first prerequisite that is
+// still running, or an empty handle when they have all finished.
+internal platform_work_handle
+FindRunningPrerequisite(platform_work_queue* queue, u32 prerequisiteCount, const platform_work_handle* prerequisites, b32 onlyFull)
+{
+    platform_work_handle result = {};
+    for(u32 index = 0; index < prerequisiteCount; ++index)
+    {
+        platform_work_handle prerequisite = prerequisites[index];
+        if(!prerequisite.generation)
+        {
+            continue;
+        }
+
+        ASSERT(prerequisite.index < PLATFORM_WORK_MAX_BATCHES);
+        platform_work_batch* other = queue->batches + prerequisite.index;
+        if(other->generation == prerequisite.generation &&
+           (!onlyFull || other->dependentCount == PLATFORM_WORK_MAX_DEPENDENTS))
+        {
+            result = prerequisite;
+            break;
+        }
+    }
+    return result;
+}
+
+internal b32
+IsWorkQueueBatchComplete(platform_work_queue* queue, platform_work_handle handle)
+{
+    if(!handle.generation)
+    {
+        return true;
+    }
+
+    ASSERT(handle.index < PLATFORM_WORK_MAX_BATCHES);
+    return AtomicLoadAcquireU32(&queue->batches[handle.index].generation) != handle.generation;
+}
+
+internal void
+WaitForWorkQueueBatch(platform_work_queue* queue, platform_work_handle handle)
+{
+    // help out with whatever work is available until the batch is done
+    u32 spinCount = 0;
+    while(!IsWorkQueueBatchComplete(queue, handle))
+    {
+        WaitForWorkQueueEntry(queue, &spinCount);
+    }
+}
+
+internal platform_work_handle
+AddWorkQueueBatch(platform_work_queue* queue, u32 itemCount, const platform_work_item* items, u32 prerequisiteCount, const platform_work_handle* prerequisites)
+{
+    platform_work_handle handle = {};
+
+    // NOTE(james): make sure there is room for everything the batch needs before touching
+    // any of it.  Whatever ran out gets waited out by helping with the work, the same way
+    // QueueWorkEntry runs entries itself when every deque is full.
+    u32 spinCount = 0;
+    for(;;)
+    {
+        BeginTicketMutex(&queue->batchMutex);
+
+        platform_work_handle wait = {};
+        if(queue->freeDeferredCount < itemCount)
+        {
+            // no room to park the entries, so let the prerequisites finish and the
+            // batch goes straight onto the queue instead
+            wait = FindRunningPrerequisite(queue, prerequisiteCount, prerequisites, false);
+        }
+        else
+        {
+            // a prerequisite can't take another dependent until it finishes
+            wait = FindRunningPrerequisite(queue, prerequisiteCount, prerequisites, true);
+        }
+
+        if(!wait.generation && queue->freeBatchCount)
+        {
+            break;
+        }
+        EndTicketMutex(&queue->batchMutex);
+
+        if(wait.generation)
+        {
+            WaitForWorkQueueBatch(queue, wait);
+        }
+        else
+        {
+            // every batch is live, one of them has to finish first
+            WaitForWorkQueueEntry(queue, &spinCount);
+        }
+    }
+
+    // NOTE(james): the batch mutex is still held from the loop
+    u32 batchIndex = queue->freeBatches[--queue->freeBatchCount];
+    platform_work_batch* batch = queue->batches + batchIndex;
+
+    batch->counter.count = itemCount + 1;
+    batch->dependentCount = 0;
+    batch->deferred = 0;
+
+    handle.index = batchIndex;
+    handle.generation = batch->generation;
+
+    // NOTE(james): nothing can finish a prerequisite while we hold the mutex, so the count
+    // only has to be published once it's all added up
+    u32 pendingPrerequisites = 1;
+    for(u32 index = 0; index < prerequisiteCount; ++index)
+    {
+        platform_work_handle prerequisite = prerequisites[index];
+        if(!prerequisite.generation)
+        {
+            continue;
+        }
+
+        // NOTE(james): a handle listed twice only takes one dependent slot, which is all
+        // the capacity check above made room for
+        b32 listedBefore = false;
+        for(u32 earlier = 0; earlier < index && !listedBefore; ++earlier)
+        {
+            listedBefore = (prerequisites[earlier].index == prerequisite.index &&
+                            prerequisites[earlier].generation == prerequisite.generation);
+        }
+        if(listedBefore)
+        {
+            continue;
+        }
+
+        ASSERT(prerequisite.index < PLATFORM_WORK_MAX_BATCHES);
+        platform_work_batch* other = queue->batches + prerequisite.index;
+        // NOTE(james): a stale generation means the prerequisite already finished
+        if(other->generation == prerequisite.generation)
+        {
+            ASSERT(other->dependentCount < PLATFORM_WORK_MAX_DEPENDENTS);
+            other->dependents[other->dependentCount++] = batchIndex;
+            ++pendingPrerequisites;
+        }
+    }
+    batch->pendingPrerequisites = pendingPrerequisites;
+
+    b32 deferred = (pendingPrerequisites > 1);
+    if(deferred)
+    {
+        // copy the entries now, the batch will be released from whatever thread
+        // finishes the last prerequisite
+        for(u32 index = itemCount; index > 0; --index)
+        {
+            platform_work_deferred* entry = queue->firstFreeDeferred;
+            queue->firstFreeDeferred = entry->next;
+            --queue->freeDeferredCount;
+
+            entry->entry.callback = items[index-1].callback;
+            entry->entry.data = items[index-1].data;
+            entry->entry.counter = 0;
+            entry->entry.batch = batch;
+            entry->next = batch->deferred;
+            batch->deferred = entry;
+        }
+    }
+    EndTicketMutex(&queue->batchMutex);
+
+    AtomicAddU32(&queue->countToComplete, itemCount);
+
+    if(AtomicAddU32(&batch->pendingPrerequisites, (u32)-1) == 1)
+    {
+        if(deferred)
+        {
+            // the prerequisites all finished while we were adding
+            WorkBatchRelease(queue, batch);
+        }
+        else
+        {
+            for(u32 index = 0; index < itemCount; ++index)
+            {
+                platform_work_queue_entry entry = { items[index].callback, items[index].data, 0, batch };
+                QueueWorkEntry(queue, entry);
+            }
+            WorkBatchDecrement(queue, batch);
+        }
+    }
+
+    return handle;
+}
+
+//------------------------
+//---- THREADS
+//------------------------
+
+internal void
+WorkQueueThreadLoop(platform_work_worker* worker)
+{
+    ThreadLocalWorker = worker;
+    platform_work_queue* queue = worker->queue;
+
+    for(;;)
+    {
+        if(!DoNextWorkQueueEntry(queue))
+        {
+            PlatformSemaphoreWait(queue->semaphore);
+        }
+    }
+}
+
+internal void
+InitWorkQueueWorkers(platform_work_queue* queue, u32 numThreads)
+{
+    ASSERT(numThreads <= PLATFORM_WORK_MAX_WORKERS);
+
+    queue->countToComplete = 0;
+    queue->countCompleted = 0;
+    queue->injectionReadIndex = 0;
+    queue->injectionWriteIndex = 0;
+    queue->workerCount = numThreads;
+
+    for(u32 workerIndex = 0; workerIndex < numThreads; ++workerIndex)
+    {
+        platform_work_worker* worker = queue->workers + workerIndex;
+        worker->deque.top = 0;
+        worker->deque.bottom = 0;
+        worker->queue = queue;
+        worker->workerIndex = workerIndex;
+        // xorshift can't start from zero
+        worker->stealSeed = 0x9E3779B9u * (workerIndex + 1);
+    }
+
+    queue->freeBatchCount = 0;
+    for(u32 batchIndex = PLATFORM_WORK_MAX_BATCHES; batchIndex > 0; --batchIndex)
+    {
+        platform_work_batch* batch = queue->batches + (batchIndex - 1);
+        batch->counter.count = 0;
+        batch->pendingPrerequisites = 0;
+        // NOTE(james): generation zero is reserved for the empty handle
+        batch->generation = 1;
+        batch->dependentCount = 0;
+        batch->deferred = 0;
+        queue->freeBatches[queue->freeBatchCount++] = batchIndex - 1;
+    }
+
+    queue->firstFreeDeferred = 0;
+    queue->freeDeferredCount = PLATFORM_WORK_MAX_DEFERRED;
+    for(u32 deferredIndex = 0; deferredIndex < PLATFORM_WORK_MAX_DEFERRED; ++deferredIndex)
+    {
+        platform_work_deferred* deferred = queue->deferredPool + deferredIndex;
+        deferred->next = queue->firstFreeDeferred;
+        queue->firstFreeDeferred = deferred;
+    }
+}
+
+#if TEST_COLLECTIONS
+//------------------------
+//---- TESTS
+//------------------------
+
+struct test_work_state
+{
+    u32 volatile stageA;
+    u32 volatile stageB;
+    u32 volatile stageD;
+    u32 volatile counted;
+    u32 volatile gateDone;
+    u32 volatile afterGate;
+    u32 volatile chainNext;
+    u32 volatile bad;
+};
+global_variable test_work_state TestWork;
+
+internal PLATFORM_WORK_QUEUE_CALLBACK(TestWorkCount) { AtomicAddU32(&TestWork.counted, 1); }
+internal PLATFORM_WORK_QUEUE_CALLBACK(TestWorkStageA) { AtomicAddU32(&TestWork.stageA, 1); }
+internal PLATFORM_WORK_QUEUE_CALLBACK(TestWorkStageB)
+{
+    if(AtomicLoadAcquireU32(&TestWork.stageA) != 100) AtomicAddU32(&TestWork.bad, 1);
+    AtomicAddU32(&TestWork.stageB, 1);
+}
+internal PLATFORM_WORK_QUEUE_CALLBACK(TestWorkStageD)
+{
+    if(AtomicLoadAcquireU32(&TestWork.stageB) != 100) AtomicAddU32(&TestWork.bad, 1);
+    AtomicAddU32(&TestWork.stageD, 1);
+}
+
+// NOTE(james): holds its batch open for a while, so whatever gets added behind it runs
+// out of dependents, batches or deferred entries and has to take the slow path
+internal PLATFORM_WORK_QUEUE_CALLBACK(TestWorkGate)
+{
+    u64 until = __rdtsc() + 100000000ull;
+    while(__rdtsc() < until)
+    {
+        PlatformYieldThread();
+    }
+    AtomicStoreReleaseU32(&TestWork.gateDone, 1);
+}
+
+internal PLATFORM_WORK_QUEUE_CALLBACK(TestWorkAfterGate)
+{
+    if(!AtomicLoadAcquireU32(&TestWork.gateDone)) AtomicAddU32(&TestWork.bad, 1);
+    AtomicAddU32(&TestWork.afterGate, 1);
+}
+
+internal PLATFORM_WORK_QUEUE_CALLBACK(TestWorkChain)
+{
+    u32 link = (u32)(umm)data;
+    if(!AtomicLoadAcquireU32(&TestWork.gateDone) || TestWork.chainNext != link) AtomicAddU32(&TestWork.bad, 1);
+    AtomicStoreReleaseU32(&TestWork.chainNext, link + 1);
+}
+
+b32 TestWorkQueue(platform_work_queue* queue)
+{
+    ZeroStruct(TestWork);
+
+    // counted entries
+    platform_work_counter counter = {};
+    for(u32 i = 0; i < 100; ++i)
+    {
+        AddCountedWorkQueueEntry(queue, TestWorkCount, 0, &counter);
+    }
+    CompleteCounterWork(queue, &counter);
+    EXPECT(counter.count == 0);
+    EXPECT(TestWork.counted == 100);
+
+    // prerequisites, including an empty batch in the middle and a stale handle
+    platform_work_item itemsA[100], itemsB[100], itemsD[10];
+    for(u32 i = 0; i < 100; ++i)
+    {
+        itemsA[i] = { TestWorkStageA, 0 };
+        itemsB[i] = { TestWorkStageB, 0 };
+    }
+    for(u32 i = 0; i < 10; ++i)
+    {
+        itemsD[i] = { TestWorkStageD, 0 };
+    }
+
+    platform_work_handle empty = {};
+    EXPECT(IsWorkQueueBatchComplete(queue, empty));
+
+    platform_work_handle batchA = AddWorkQueueBatch(queue, 100, itemsA, 0, 0);
+    platform_work_handle batchB = AddWorkQueueBatch(queue, 100, itemsB, 1, &batchA);
+    platform_work_handle batchC = AddWorkQueueBatch(queue, 0, 0, 1, &batchB);
+    platform_work_handle prerequisitesD[3] = { batchC, empty, batchA };
+    platform_work_handle batchD = AddWorkQueueBatch(queue, 10, itemsD, 3, prerequisitesD);
+    WaitForWorkQueueBatch(queue, batchD);
+
+    EXPECT(IsWorkQueueBatchComplete(queue, batchA));
+    EXPECT(IsWorkQueueBatchComplete(queue, batchB));
+    EXPECT(IsWorkQueueBatchComplete(queue, batchC));
+    EXPECT(TestWork.stageD == 10);
+    EXPECT(TestWork.bad == 0);
+
+    // a finished prerequisite doesn't hold anything up
+    platform_work_handle again = AddWorkQueueBatch(queue, 10, itemsD, 1, &batchA);
+    WaitForWorkQueueBatch(queue, again);
+    EXPECT(TestWork.stageD == 20);
+
+    // more dependents than a batch can hold, listing the gate twice after the first so
+    // one of them lands with a single slot left
+    platform_work_item gate = { TestWorkGate, 0 };
+    platform_work_item afterGate = { TestWorkAfterGate, 0 };
+    platform_work_handle gateBatch = AddWorkQueueBatch(queue, 1, &gate, 0, 0);
+    platform_work_handle gateTwice[2] = { gateBatch, gateBatch };
+    platform_work_handle dependents[PLATFORM_WORK_MAX_DEPENDENTS * 2];
+    for(u32 i = 0; i < ARRAY_COUNT(dependents); ++i)
+    {
+        dependents[i] = AddWorkQueueBatch(queue, 1, &afterGate, i ? 2 : 1, gateTwice);
+    }
+    for(u32 i = 0; i < ARRAY_COUNT(dependents); ++i)
+    {
+        WaitForWorkQueueBatch(queue, dependents[i]);
+    }
+    EXPECT(TestWork.afterGate == ARRAY_COUNT(dependents));
+    EXPECT(TestWork.bad == 0);
+
+    // more batches live at once than there are batches
+    TestWork.gateDone = 0;
+    platform_work_handle previous = AddWorkQueueBatch(queue, 1, &gate, 0, 0);
+    for(u32 i = 0; i < PLATFORM_WORK_MAX_BATCHES + 50; ++i)
+    {
+        platform_work_item link = { TestWorkChain, (void*)(umm)i };
+        previous = AddWorkQueueBatch(queue, 1, &link, 1, &previous);
+    }
+    WaitForWorkQueueBatch(queue, previous);
+    EXPECT(TestWork.chainNext == PLATFORM_WORK_MAX_BATCHES + 50);
+    EXPECT(TestWork.bad == 0);
+
+    // more deferred entries than the pool holds
+    TestWork.gateDone = 0;
+    TestWork.afterGate = 0;
+    memory_arena scratch = {};
+    u32 bigCount = PLATFORM_WORK_MAX_DEFERRED + 100;
+    platform_work_item* bigItems = PushArray(scratch, bigCount, platform_work_item);
+    for(u32 i = 0; i < bigCount; ++i)
+    {
+        bigItems[i] = afterGate;
+    }
+    gateBatch = AddWorkQueueBatch(queue, 1, &gate, 0, 0);
+    platform_work_handle big = AddWorkQueueBatch(queue, bigCount, bigItems, 1, &gateBatch);
+    WaitForWorkQueueBatch(queue, big);
+    Clear(scratch);
+    EXPECT(TestWork.afterGate == bigCount);
+    EXPECT(TestWork.bad == 0);
+
+    CompleteAllWorkQueueWork(queue);
+    EXPECT(queue->freeBatchCount == PLATFORM_WORK_MAX_BATCHES);
+    EXPECT(queue->freeDeferredCount == PLATFORM_WORK_MAX_DEFERRED);
+
+    return true;
+}
+#endif
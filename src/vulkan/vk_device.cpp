@@ -880,11 +880,12 @@ VkResult vgCreateSwapChain(vg_device& device, VkFormat preferredFormat, VkColorS
     vkGetSwapchainImagesKHR(device.handle, swapChain, &imageCount, pImages);
 
     device.swapChainImages = array_create(device.arena, vg_image*, imageCount);
+    device.swapChainRenderTargets = array_create(device.arena, u64, imageCount);
 
     u32 numBarriers = 0;
     VkImageMemoryBarrier* pImgBarriers = PushArray(*device.frameArena, imageCount, VkImageMemoryBarrier);
 
-    vg_resourceheap* pHeap = device.resourceHeaps->get(0);
+    vg_resourceheap* pHeap = device.defaultResourceHeap;
     //device.swapChainImages.resize(imageCount);
     for(u32 index = 0; index < imageCount; ++index)
     {
@@ -923,8 +924,7 @@ VkResult vgCreateSwapChain(vg_device& device, VkFormat preferredFormat, VkColorS
         pRTV->clearValue = VkClearValue{0.2f,0.2f,0.2f,0.0f} ;   // gray
         pRTV->sampleCount = VK_SAMPLE_COUNT_1_BIT;  // TODO(james): This should come from a graphics init config or something
  
-        u64 key = pHeap->rtvs->size()+1;
-        pHeap->rtvs->set(key, pRTV);
+        device.swapChainRenderTargets->push_back(pHeap->rtvs->insert(pRTV));
 
         VkImageMemoryBarrier& imgBarrier = pImgBarriers[numBarriers++];
         imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -1149,7 +1149,7 @@ vgDestroyResourceHeap(vg_device& device, vg_resourceheap* pHeap)
 // buffer
     for(auto entry: *pHeap->buffers)
     {
-        vg_buffer& buffer = **entry;
+        vg_buffer& buffer = *entry;
         if(buffer.mapped)
         {
             vmaUnmapMemory(device.allocator, buffer.allocation);
@@ -1161,7 +1161,7 @@ vgDestroyResourceHeap(vg_device& device, vg_resourceheap* pHeap)
     // image
     for(auto entry: *pHeap->textures)
     {
-        vg_image& image = **entry;
+        vg_image& image = *entry;
         vkDestroyImageView(device.handle, image.view, nullptr);
         vmaDestroyImage(device.allocator, image.handle, image.allocation);
     }
@@ -1169,19 +1169,19 @@ vgDestroyResourceHeap(vg_device& device, vg_resourceheap* pHeap)
     // sampler
     for(auto entry: *pHeap->samplers)
     {
-        vg_sampler& sampler = **entry;
+        vg_sampler& sampler = *entry;
         vkDestroySampler(device.handle, sampler.handle, nullptr);
     }
 
     for(auto entry: *pHeap->rtvs)
     {
-        vg_rendertargetview& rtv = **entry;
+        vg_rendertargetview& rtv = *entry;
     }
 
     // kernel
     for(auto entry: *pHeap->kernels)
     {
-        vg_kernel& kernel = **entry;
+        vg_kernel& kernel = *entry;
         
         vkDestroyPipeline(device.handle, kernel.pipeline, nullptr);
     }
@@ -1189,7 +1189,7 @@ vgDestroyResourceHeap(vg_device& device, vg_resourceheap* pHeap)
     // program
     for(auto entry: *pHeap->programs)
     {
-        vg_program& program = **entry;
+        vg_program& program = *entry;
         for(u32 i = 0; i < program.numShaders; ++i)
         {
             spvReflectDestroyShaderModule(program.shaderReflections[i]);
@@ -1222,13 +1222,15 @@ void vgDestroy(vg_backend& vb)
         vg_device& device = vb.device;
         for(auto entry: *device.resourceHeaps)
         {
-            vgDestroyResourceHeap(device, entry.value);
+            vgDestroyResourceHeap(device, entry);
         }
         device.resourceHeaps->clear();
+        vgDestroyResourceHeap(device, device.defaultResourceHeap);
+        device.defaultResourceHeap = 0;
 
         for(auto entry: *device.encoderPools)
         {
-            vgDestroyCmdEncoderPool(device, entry.value);
+            vgDestroyCmdEncoderPool(device, entry);
         }
         device.encoderPools->clear();
 
@@ -1304,12 +1306,12 @@ vgAllocateResourceHeap()
     vg_resourceheap* pHeap = BootstrapPushStructMember(vg_resourceheap, arena);
 
     // TODO(james): Tune these to the game
-    pHeap->buffers = hashtable_create(pHeap->arena, vg_buffer*, 1024);
-    pHeap->textures = hashtable_create(pHeap->arena, vg_image*, 1024);
-    pHeap->samplers = hashtable_create(pHeap->arena, vg_sampler*, 128);
-    pHeap->rtvs = hashtable_create(pHeap->arena, vg_rendertargetview*, 32);
-    pHeap->programs = hashtable_create(pHeap->arena, vg_program*, 128);
-    pHeap->kernels = hashtable_create(pHeap->arena, vg_kernel*, 128);
+    pHeap->buffers = slotmap_create(pHeap->arena, vg_buffer*, 1024);
+    pHeap->textures = slotmap_create(pHeap->arena, vg_image*, 1024);
+    pHeap->samplers = slotmap_create(pHeap->arena, vg_sampler*, 128);
+    pHeap->rtvs = slotmap_create(pHeap->arena, vg_rendertargetview*, 32);
+    pHeap->programs = slotmap_create(pHeap->arena, vg_program*, 128);
+    pHeap->kernels = slotmap_create(pHeap->arena, vg_kernel*, 128);
 
     return pHeap;
 }
@@ -1690,52 +1692,58 @@ vgCreateCommandPool(vg_device& device, GfxQueueType queueType, vg_command_encode
         VkResult result = vkCreateCommandPool(device.handle, &poolInfo, nullptr, &pool->cmdPool[i]);
         if(result != VK_SUCCESS) return result;
     }
-    pool->cmdcontexts = hashtable_create(device.arena, vg_cmd_context*, 32);
+    pool->cmdcontexts = slotmap_create(device.arena, vg_cmd_context*, 32);
     pool->queueType = queueType;
     pool->queue = queue;
 
     return VK_SUCCESS;
 }
 
+inline vg_resourceheap*
+vgResourceHeap(vg_device& device, u64 heapId)
+{
+    return heapId ? device.resourceHeaps->get(heapId) : device.defaultResourceHeap;
+}
+
 inline vg_buffer*
 FromGfxBuffer(vg_device& device, GfxBuffer resource)
 {
-    vg_resourceheap* pHeap = device.resourceHeaps->get(resource.heap);
+    vg_resourceheap* pHeap = vgResourceHeap(device, resource.heap);
     return pHeap->buffers->get(resource.id);
 }
 
 inline vg_image*
 FromGfxTexture(vg_device& device, GfxTexture resource)
 {
-    vg_resourceheap* pHeap = device.resourceHeaps->get(resource.heap);
+    vg_resourceheap* pHeap = vgResourceHeap(device, resource.heap);
     return pHeap->textures->get(resource.id);
 }
 
 inline vg_sampler*
 FromGfxSampler(vg_device& device, GfxSampler resource)
 {
-    vg_resourceheap* pHeap = device.resourceHeaps->get(resource.heap);
+    vg_resourceheap* pHeap = vgResourceHeap(device, resource.heap);
     return pHeap->samplers->get(resource.id);
 }
 
 inline vg_rendertargetview* 
 FromGfxRenderTarget(vg_device& device, GfxRenderTarget resource)
 {
-    vg_resourceheap* pHeap = device.resourceHeaps->get(resource.heap);
+    vg_resourceheap* pHeap = vgResourceHeap(device, resource.heap);
     return pHeap->rtvs->get(resource.id);
 }
 
 inline vg_program*
 FromGfxProgram(vg_device& device, GfxProgram resource)
 {
-    vg_resourceheap* pHeap = device.resourceHeaps->get(resource.heap);
+    vg_resourceheap* pHeap = vgResourceHeap(device, resource.heap);
     return pHeap->programs->get(resource.id);
 }
 
 inline vg_kernel*
 FromGfxKernel(vg_device& device, GfxKernel resource)
 {
-    vg_resourceheap* pHeap = device.resourceHeaps->get(resource.heap);
+    vg_resourceheap* pHeap = vgResourceHeap(device, resource.heap);
     return pHeap->kernels->get(resource.id);
 }
 
@@ -1857,7 +1865,7 @@ GfxRenderTarget AcquireNextSwapChainTarget(GfxDevice deviceHandle)
 
     vgResetDescriptorPools(device);
 
-    return GfxRenderTarget{0, device.curSwapChainIndex+1};
+    return GfxRenderTarget{0, (*device.swapChainRenderTargets)[device.curSwapChainIndex]};
 }
 
 internal
@@ -1865,16 +1873,14 @@ GfxResourceHeap CreateResourceHeap( GfxDevice deviceHandle )
 {
     vg_device& device = DeviceObject::From(deviceHandle);
 
-    if(device.resourceHeaps->size() == device.resourceHeaps->capacity())
+    if(device.resourceHeaps->full())
     {
         ASSERT(false);  // out of handles
         return GfxResourceHeap{GFX_INVALID_HANDLE};
     }
 
     vg_resourceheap* pHeap = vgAllocateResourceHeap();
-    u64 key = { HASH(device.resourceHeaps->size()+1) };
-
-    device.resourceHeaps->set(key, pHeap);
+    u64 key = device.resourceHeaps->insert(pHeap);
 
     return GfxResourceHeap{deviceHandle.id, key};
 }
@@ -1900,7 +1906,7 @@ internal
 GfxBuffer CreateBuffer( GfxDevice deviceHandle, const GfxBufferDesc& bufferDesc, void const* data)
 {
     vg_device& device = DeviceObject::From(deviceHandle);
-    vg_resourceheap& heap = *device.resourceHeaps->get(bufferDesc.heap.id);
+    vg_resourceheap& heap = *vgResourceHeap(device, bufferDesc.heap.id);
 
     VkBufferUsageFlags usage = 0;
     VmaMemoryUsage memUsage = VMA_MEMORY_USAGE_UNKNOWN;
@@ -1953,8 +1959,7 @@ GfxBuffer CreateBuffer( GfxDevice deviceHandle, const GfxBufferDesc& bufferDesc,
         Copy(bufferDesc.size, data, buffer->mapped);
     }
 
-    u64 key = HASH(heap.buffers->size()+1);
-    heap.buffers->set(key, buffer);
+    u64 key = heap.buffers->insert(buffer);
 
     return GfxBuffer{ bufferDesc.heap.id, key };
 }
@@ -1963,7 +1968,7 @@ internal
 void* GetBufferData( GfxDevice deviceHandle, GfxBuffer resource)
 {
     vg_device& device = DeviceObject::From(deviceHandle);
-    vg_resourceheap* pHeap = device.resourceHeaps->get(resource.heap);
+    vg_resourceheap* pHeap = vgResourceHeap(device, resource.heap);
     vg_buffer* buffer = pHeap->buffers->get(resource.id);
 
     if(!buffer->mapped)
@@ -1978,7 +1983,7 @@ internal
 GfxResult DestroyBuffer( GfxDevice deviceHandle, GfxBuffer resource)
 {
     vg_device& device = DeviceObject::From(deviceHandle);
-    vg_resourceheap* pHeap = device.resourceHeaps->get(resource.heap);
+    vg_resourceheap* pHeap = vgResourceHeap(device, resource.heap);
     vg_buffer* buffer = pHeap->buffers->get(resource.id);
 
     if(buffer->mapped)
@@ -1997,7 +2002,7 @@ internal
 GfxTexture CreateTexture( GfxDevice deviceHandle, const GfxTextureDesc& textureDesc)
 {
     vg_device& device = DeviceObject::From(deviceHandle);
-    vg_resourceheap* pHeap = device.resourceHeaps->get(textureDesc.heap.id);
+    vg_resourceheap* pHeap = vgResourceHeap(device, textureDesc.heap.id);
 
     VkImageType imageType = VK_IMAGE_TYPE_2D;
     VkImageViewType imageViewType = VK_IMAGE_VIEW_TYPE_2D;
@@ -2094,8 +2099,7 @@ GfxTexture CreateTexture( GfxDevice deviceHandle, const GfxTextureDesc& textureD
     image->layers = Maximum(textureDesc.slice_count, 1);
     image->numMipLevels = imageInfo.mipLevels;
 
-    u64 key = HASH(pHeap->textures->size()+1);
-    pHeap->textures->set(key, image);
+    u64 key = pHeap->textures->insert(image);
 
     return GfxTexture{textureDesc.heap.id, key};
 }
@@ -2104,7 +2108,7 @@ internal
 GfxResult DestroyTexture( GfxDevice deviceHandle, GfxTexture resource)
 {
     vg_device& device = DeviceObject::From(deviceHandle);
-    vg_resourceheap* pHeap = device.resourceHeaps->get(resource.heap);
+    vg_resourceheap* pHeap = vgResourceHeap(device, resource.heap);
     vg_image* image = pHeap->textures->get(resource.id);
 
     vkDestroyImageView(device.handle, image->view, nullptr);
@@ -2118,7 +2122,7 @@ internal
 GfxSampler CreateSampler( GfxDevice deviceHandle, const GfxSamplerDesc& samplerDesc)
 {
     vg_device& device = DeviceObject::From(deviceHandle);
-    vg_resourceheap* pHeap = device.resourceHeaps->get(samplerDesc.heap.id);
+    vg_resourceheap* pHeap = vgResourceHeap(device, samplerDesc.heap.id);
     vg_sampler* sampler = PushStruct(pHeap->arena, vg_sampler);
 
     VkSamplerCreateInfo samplerInfo = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
@@ -2146,8 +2150,7 @@ GfxSampler CreateSampler( GfxDevice deviceHandle, const GfxSamplerDesc& samplerD
     VkResult result = vkCreateSampler(device.handle, &samplerInfo, nullptr, &sampler->handle);
     if(result != VK_SUCCESS) return GfxSampler{};
 
-    u64 key = HASH(pHeap->samplers->size()+1);
-    pHeap->samplers->set(key, sampler);
+    u64 key = pHeap->samplers->insert(sampler);
 
     return GfxSampler{samplerDesc.heap.id, key};
 }
@@ -2156,7 +2159,7 @@ internal
 GfxResult DestroySampler( GfxDevice deviceHandle, GfxSampler resource)
 {
     vg_device& device = DeviceObject::From(deviceHandle);
-    vg_resourceheap* pHeap = device.resourceHeaps->get(resource.heap);
+    vg_resourceheap* pHeap = vgResourceHeap(device, resource.heap);
     vg_sampler* sampler = pHeap->samplers->get(resource.id);
 
     vkDestroySampler(device.handle, sampler->handle, nullptr);
@@ -2212,7 +2215,7 @@ GfxProgram CreateProgram( GfxDevice deviceHandle, const GfxProgramDesc& programD
 {
     VkResult result = VK_SUCCESS;
     vg_device& device = DeviceObject::From(deviceHandle);
-    vg_resourceheap* pHeap = device.resourceHeaps->get(programDesc.heap.id);
+    vg_resourceheap* pHeap = vgResourceHeap(device, programDesc.heap.id);
     vg_program* program = PushStruct(pHeap->arena, vg_program);
 
     if(programDesc.compute)
@@ -2440,8 +2443,7 @@ GfxProgram CreateProgram( GfxDevice deviceHandle, const GfxProgramDesc& programD
         return GfxProgram{};
     }
 
-    u64 key = HASH(pHeap->programs->size()+1);
-    pHeap->programs->set(key, program);
+    u64 key = pHeap->programs->insert(program);
 
     return GfxProgram{programDesc.heap.id, key};
 }
@@ -2450,7 +2452,7 @@ internal
 GfxResult DestroyProgram( GfxDevice deviceHandle, GfxProgram resource)
 {
     vg_device& device = DeviceObject::From(deviceHandle);
-    vg_resourceheap* pHeap = device.resourceHeaps->get(resource.heap);
+    vg_resourceheap* pHeap = vgResourceHeap(device, resource.heap);
     vg_program* program = pHeap->programs->get(resource.id);
 
     for(u32 i = 0; i < program->numShaders; ++i)
@@ -2482,7 +2484,7 @@ internal
 GfxRenderTarget CreateRenderTarget( GfxDevice deviceHandle, const GfxRenderTargetDesc& rtvDesc)
 {
     vg_device& device = DeviceObject::From(deviceHandle);
-    vg_resourceheap* pHeap = device.resourceHeaps->get(rtvDesc.heap.id);
+    vg_resourceheap* pHeap = vgResourceHeap(device, rtvDesc.heap.id);
 
     temporary_memory scoped = BeginTemporaryMemory(pHeap->arena);
 
@@ -2579,8 +2581,7 @@ GfxRenderTarget CreateRenderTarget( GfxDevice deviceHandle, const GfxRenderTarge
 
     vgInitialImageStateTransition(device, image, rtvDesc.initialState);
 
-    u64 imageKey = HASH(pHeap->textures->size() + 1);
-    pHeap->textures->set(imageKey, image);
+    u64 imageKey = pHeap->textures->insert(image);
 
     // This is just an image view with a little extra information on the device side
     vg_rendertargetview* rtv = PushStruct(pHeap->arena, vg_rendertargetview);
@@ -2590,8 +2591,7 @@ GfxRenderTarget CreateRenderTarget( GfxDevice deviceHandle, const GfxRenderTarge
     rtv->clearValue = VkClearValue{rtvDesc.clearValue[0],rtvDesc.clearValue[1],rtvDesc.clearValue[2],rtvDesc.clearValue[3]};
     rtv->sampleCount = ConvertSampleCount(rtvDesc.sampleCount);
 
-    u64 key = HASH(pHeap->rtvs->size() + 1);
-    pHeap->rtvs->set(key, rtv);
+    u64 key = pHeap->rtvs->insert(rtv);
 
     return GfxRenderTarget{rtvDesc.heap.id, key};
 }
@@ -2600,7 +2600,7 @@ internal
 GfxResult DestroyRenderTarget( GfxDevice deviceHandle, GfxRenderTarget resource )
 {
     vg_device& device = DeviceObject::From(deviceHandle);
-    vg_resourceheap* pHeap = device.resourceHeaps->get(resource.heap);
+    vg_resourceheap* pHeap = vgResourceHeap(device, resource.heap);
     vg_rendertargetview& rtv = *pHeap->rtvs->get(resource.id);
     vg_image* image = pHeap->textures->get(rtv.textureKey);
 
@@ -2624,9 +2624,9 @@ internal
 GfxKernel CreateGraphicsKernel( GfxDevice deviceHandle, GfxProgram resource, const GfxPipelineDesc& pipelineDesc)
 {
     vg_device& device = DeviceObject::From(deviceHandle);
-    vg_resourceheap* pHeap = device.resourceHeaps->get(resource.heap);
+    vg_resourceheap* pHeap = vgResourceHeap(device, resource.heap);
     vg_program* program = pHeap->programs->get(resource.id);
-    pHeap = device.resourceHeaps->get(pipelineDesc.heap.id);
+    pHeap = vgResourceHeap(device, pipelineDesc.heap.id);
 
     // just create a temporary render pass for pipeline creation
     VkRenderPass renderpass = VK_NULL_HANDLE;
@@ -2823,8 +2823,7 @@ GfxKernel CreateGraphicsKernel( GfxDevice deviceHandle, GfxProgram resource, con
     kernel->pipeline = pipeline;
     kernel->program = program;
 
-    u64 key = HASH(pHeap->kernels->size()+1);
-    pHeap->kernels->set(key, kernel);
+    u64 key = pHeap->kernels->insert(kernel);
 
     return GfxKernel{pipelineDesc.heap.id, key};
 }
@@ -2833,7 +2832,7 @@ internal
 GfxResult DestroyKernel( GfxDevice deviceHandle, GfxKernel resource)
 {
     vg_device& device = DeviceObject::From(deviceHandle);
-    vg_resourceheap* pHeap = device.resourceHeaps->get(resource.heap);
+    vg_resourceheap* pHeap = vgResourceHeap(device, resource.heap);
     vg_kernel* kernel = pHeap->kernels->get(resource.id);    
 
     vkDestroyPipeline(device.handle, kernel->pipeline, nullptr);
@@ -2860,8 +2859,7 @@ GfxCmdEncoderPool CreateEncoderPool( GfxDevice deviceHandle, const GfxCmdEncoder
     }
     KeepTemporaryMemory(temp);
 
-    u64 key = HASH(device.encoderPools->size()+1);
-    device.encoderPools->set(key, pool);
+    u64 key = device.encoderPools->insert(pool);
     return GfxCmdEncoderPool{deviceHandle.id, key};
 }
 
@@ -2906,8 +2904,7 @@ GfxCmdContext CreateEncoderContext( GfxCmdEncoderPool resource)
 
     KeepTemporaryMemory(scoped);
 
-    u64 key = HASH(pool->cmdcontexts->size()+1);
-    pool->cmdcontexts->set(key, context);
+    u64 key = pool->cmdcontexts->insert(context);
 
     return GfxCmdContext{resource.deviceId, resource.id, key};
 }
@@ -2946,8 +2943,7 @@ GfxResult CreateEncoderContexts(GfxCmdEncoderPool resource, u32 numContexts, Gfx
             vg_cmd_context* context = PushStruct(device.arena, vg_cmd_context);
             context->buffer[frameIdx] = buffers[i];
 
-            u64 key = HASH(pool->cmdcontexts->size()+1);
-            pool->cmdcontexts->set(key, context);
+            u64 key = pool->cmdcontexts->insert(context);
             pContexts[i].deviceId = resource.deviceId;
             pContexts[i].poolId = resource.id;
             pContexts[i].id = key;
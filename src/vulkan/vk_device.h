@@ -241,12 +241,12 @@ struct vg_resourceheap
 {
     memory_arena arena;
 
-    hashtable<vg_buffer*>* buffers;
-    hashtable<vg_image*>* textures;
-    hashtable<vg_sampler*>* samplers;
-    hashtable<vg_rendertargetview*>* rtvs;
-    hashtable<vg_program*>* programs;
-    hashtable<vg_kernel*>* kernels;
+    slotmap<vg_buffer*>* buffers;
+    slotmap<vg_image*>* textures;
+    slotmap<vg_sampler*>* samplers;
+    slotmap<vg_rendertargetview*>* rtvs;
+    slotmap<vg_program*>* programs;
+    slotmap<vg_kernel*>* kernels;
 };
 
 struct vg_renderpass
@@ -284,7 +284,7 @@ struct vg_command_encoder_pool
     GfxQueueType    queueType;
     vg_queue*       queue;
 
-    hashtable<vg_cmd_context*>* cmdcontexts;
+    slotmap<vg_cmd_context*>* cmdcontexts;
 };
 
 struct vg_device
@@ -313,6 +313,7 @@ struct vg_device
     VkSwapchainKHR swapChain;
     VkFormat swapChainFormat;
     array<vg_image*>* swapChainImages;  // NOTE(james): these are just easy references, they are owned by the default resource heap
+    array<u64>* swapChainRenderTargets; // NOTE(james): rtv ids in the default resource heap, one per swap chain image
     // VkFramebuffer* paFramebuffers;
 
     vg_descriptor_pool* descriptorPools[FRAME_OVERLAP];
@@ -334,8 +335,10 @@ struct vg_device
     memory_arena* frameArena;    // use for transient memory only valid for the current frame
     temporary_memory frameTemp;
 
-    hashtable<vg_resourceheap*>* resourceHeaps;
-    hashtable<vg_command_encoder_pool*>* encoderPools;
+    // NOTE(james): the default heap is id 0, which a slotmap never hands out, so it lives on its own
+    vg_resourceheap* defaultResourceHeap;
+    slotmap<vg_resourceheap*>* resourceHeaps;
+    slotmap<vg_command_encoder_pool*>* encoderPools;
 
     // used by internal backend to initial transition images, etc..
     VkCommandPool internal_cmd_pool; 
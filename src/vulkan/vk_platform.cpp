@@ -88,11 +88,11 @@ LOAD_GRAPHICS_BACKEND(platform_load_graphics_backend)
         // TODO(james): Tune these limits
         vb.device.frameArena = BootstrapScratchArena("VkDeviceFrameArena", NonRestoredArena(Megabytes(1)));
         vb.device.frameTemp = BeginTemporaryMemory(*vb.device.frameArena);
-        vb.device.resourceHeaps = hashtable_create(vb.device.arena, vg_resourceheap*, 32); // TODO(james): tune this to the actual application
+        vb.device.resourceHeaps = slotmap_create(vb.device.arena, vg_resourceheap*, 32); // TODO(james): tune this to the actual application
 
         // NOTE(james): default resource heap is always at key 0
-        vb.device.resourceHeaps->set(0, vgAllocateResourceHeap());
-        vb.device.encoderPools = hashtable_create(vb.device.arena, vg_command_encoder_pool*, 32); // TODO(james): tune this to the actual application
+        vb.device.defaultResourceHeap = vgAllocateResourceHeap();
+        vb.device.encoderPools = slotmap_create(vb.device.arena, vg_command_encoder_pool*, 32); // TODO(james): tune this to the actual application
 
         // TODO(james): Change swap chain creation to create the framebuffers and add them to the runtime lookup
         // At runtime the backend will allocate both framebuffers and renderpasses as required, so just
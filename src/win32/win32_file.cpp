@@ -172,5 +172,320 @@ Win32CloseFile(platform_file& file)
     if(!file.error)
     {
         CloseHandle((HANDLE)file.platform);
+        if(file.platformAsync)
+        {
+            CloseHandle((HANDLE)file.platformAsync);
+        }
+    }
+}
+internal platform_mapped_file
+Win32MapFile(FileLocation location, const char* filename, FileAccessHint hint)
+{
+    platform_mapped_file result { .error = 1 };
+
+    char filepath[WIN32_STATE_FILE_NAME_COUNT];
+    FormatString(filepath, WIN32_STATE_FILE_NAME_COUNT, "%s%s", FileLocationsTable[(u32)location].szFolder, filename);
+
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if(hint == FileAccessHint::Sequential) { flags |= FILE_FLAG_SEQUENTIAL_SCAN; }
+    else if(hint == FileAccessHint::Random) { flags |= FILE_FLAG_RANDOM_ACCESS; }
+
+    HANDLE hFile = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, flags, 0);
+    if(hFile == INVALID_HANDLE_VALUE)
+    {
+        LOG_ERROR("Win32MapFile: CreateFile error on %s: %d", filepath, GetLastError());
+        return result;
+    }
+
+    LARGE_INTEGER fileSize;
+    if(GetFileSizeEx(hFile, &fileSize))
+    {
+        result.size = (u64)fileSize.QuadPart;
+        if(result.size == 0)
+        {
+            // CreateFileMapping refuses an empty file
+            result.error = 0;
+        }
+        else
+        {
+            HANDLE hMapping = CreateFileMappingA(hFile, 0, PAGE_READONLY, 0, 0, 0);
+            if(hMapping)
+            {
+                void* data = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+                if(data)
+                {
+                    if(hint == FileAccessHint::Sequential)
+                    {
+                        // NOTE(james): it's all going to be read, so start pulling it in now
+                        WIN32_MEMORY_RANGE_ENTRY range = { data, (SIZE_T)result.size };
+                        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+                    }
+
+                    result.data = (const u8*)data;
+                    result.error = 0;
+                }
+                else
+                {
+                    LOG_ERROR("Win32MapFile: MapViewOfFile error on %s: %d", filepath, GetLastError());
+                }
+
+                // the view keeps the mapping alive on its own
+                CloseHandle(hMapping);
+            }
+            else
+            {
+                LOG_ERROR("Win32MapFile: CreateFileMapping error on %s: %d", filepath, GetLastError());
+            }
+        }
+    }
+
+    CloseHandle(hFile);
+
+    return result;
+}
+
+internal void
+Win32UnmapFile(platform_mapped_file& file)
+{
+    if(file.data)
+    {
+        UnmapViewOfFile(file.data);
+    }
+    ZeroStruct(file);
+    file.error = 1;
+}
+
+internal void
+Win32ListDirectory(memory_arena& arena, platform_file_list& list, FileLocation location, const char* directory, b32 recursive)
+{
+    char pattern[WIN32_STATE_FILE_NAME_COUNT];
+    FormatString(pattern, WIN32_STATE_FILE_NAME_COUNT, "%s%s*", FileLocationsTable[(u32)location].szFolder, directory);
+
+    WIN32_FIND_DATAA findData;
+    HANDLE hFind = FindFirstFileExA(pattern, FindExInfoBasic, &findData, FindExSearchNameMatch, 0, FIND_FIRST_EX_LARGE_FETCH);
+    if(hFind == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    do
+    {
+        const char* filename = findData.cFileName;
+        if(filename[0] == '.' && (!filename[1] || (filename[1] == '.' && !filename[2])))
+        {
+            continue;
+        }
+
+        char name[WIN32_STATE_FILE_NAME_COUNT];
+        FormatString(name, WIN32_STATE_FILE_NAME_COUNT, "%s%s", directory, filename);
+
+        platform_file_info* info = PushFileInfo(arena, list, name);
+        info->isDirectory = (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        info->size = info->isDirectory ? 0 : (((u64)findData.nFileSizeHigh << 32) | (u64)findData.nFileSizeLow);
+        info->writeTime = ((u64)findData.ftLastWriteTime.dwHighDateTime << 32) | (u64)findData.ftLastWriteTime.dwLowDateTime;
+
+        if(recursive && info->isDirectory)
+        {
+            FormatString(name, WIN32_STATE_FILE_NAME_COUNT, "%s%s/", directory, filename);
+            Win32ListDirectory(arena, list, location, name, recursive);
+        }
+    } while(FindNextFileA(hFind, &findData));
+
+    FindClose(hFind);
+}
+
+internal platform_file_list
+Win32ListFiles(memory_arena& arena, FileLocation location, const char* directory, b32 recursive)
+{
+    platform_file_list result = {};
+
+    char prefix[WIN32_STATE_FILE_NAME_COUNT];
+    MakeDirectoryPrefix(directory, prefix, WIN32_STATE_FILE_NAME_COUNT);
+    Win32ListDirectory(arena, result, location, prefix, recursive);
+
+    return result;
+}
+
+internal b32
+Win32ReadDirectoryChanges(win32_directory_watch& watch)
+{
+    ZeroStruct(watch.overlapped);
+    DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME|FILE_NOTIFY_CHANGE_DIR_NAME|FILE_NOTIFY_CHANGE_LAST_WRITE;
+    return ReadDirectoryChangesW(watch.hDirectory, watch.buffer, WIN32_WATCH_BUFFER_SIZE, TRUE, filter, 0, &watch.overlapped, 0);
+}
+
+internal void
+Win32CloseDirectoryWatch(win32_directory_watch& watch)
+{
+    if(watch.hDirectory)
+    {
+        // NOTE(james): the buffer can't go anywhere until the cancelled read has finished with it
+        DWORD bytesTransferred = 0;
+        CancelIoEx(watch.hDirectory, &watch.overlapped);
+        GetOverlappedResult(watch.hDirectory, &watch.overlapped, &bytesTransferred, TRUE);
+        CloseHandle(watch.hDirectory);
+        watch.hDirectory = 0;
+    }
+
+    if(watch.buffer)
+    {
+        VirtualFree(watch.buffer, 0, MEM_RELEASE);
+        watch.buffer = 0;
+    }
+}
+
+internal platform_directory_watch
+Win32WatchDirectory(FileLocation location, const char* directory)
+{
+    platform_directory_watch result = {};
+
+    win32_directory_watch* watch = 0;
+    for(u32 index = 0; index < WIN32_MAX_DIRECTORY_WATCHES; ++index)
+    {
+        if(!GlobalWin32State.directoryWatches[index].id)
+        {
+            watch = GlobalWin32State.directoryWatches + index;
+            break;
+        }
+    }
+    ASSERT(watch);
+
+    MakeDirectoryPrefix(directory, watch->path, WIN32_STATE_FILE_NAME_COUNT);
+
+    char dirpath[WIN32_STATE_FILE_NAME_COUNT];
+    FormatString(dirpath, WIN32_STATE_FILE_NAME_COUNT, "%s%s", FileLocationsTable[(u32)location].szFolder, watch->path);
+
+    // NOTE(james): share everything, we're only watching and shouldn't get in anybody's way
+    HANDLE hDirectory = CreateFileA(dirpath, FILE_LIST_DIRECTORY, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE,
+                                    0, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS|FILE_FLAG_OVERLAPPED, 0);
+    if(hDirectory == INVALID_HANDLE_VALUE)
+    {
+        LOG_ERROR("Win32WatchDirectory: CreateFile error on %s: %d", dirpath, GetLastError());
+        return result;
+    }
+
+    watch->hDirectory = hDirectory;
+    watch->buffer = VirtualAlloc(0, WIN32_WATCH_BUFFER_SIZE, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    if(!watch->buffer || !Win32ReadDirectoryChanges(*watch))
+    {
+        LOG_ERROR("Win32WatchDirectory: ReadDirectoryChanges error on %s: %d", dirpath, GetLastError());
+        Win32CloseDirectoryWatch(*watch);
+        return result;
+    }
+
+    if(!++GlobalWin32State.nextWatchId) ++GlobalWin32State.nextWatchId;
+    watch->id = GlobalWin32State.nextWatchId;
+    watch->location = location;
+
+    result.id = watch->id;
+    return result;
+}
+
+internal void
+Win32UnwatchDirectory(platform_directory_watch watch)
+{
+    if(!watch.id)
+    {
+        return;
+    }
+
+    for(u32 index = 0; index < WIN32_MAX_DIRECTORY_WATCHES; ++index)
+    {
+        win32_directory_watch& directoryWatch = GlobalWin32State.directoryWatches[index];
+        if(directoryWatch.id == watch.id)
+        {
+            Win32CloseDirectoryWatch(directoryWatch);
+            directoryWatch.id = 0;
+        }
     }
-}
\ No newline at end of file
+}
+
+internal void
+Win32PushDirectoryChanges(memory_arena& arena, file_change_builder& changes, win32_directory_watch& watch)
+{
+    FILE_NOTIFY_INFORMATION* notify = (FILE_NOTIFY_INFORMATION*)watch.buffer;
+    for(;;)
+    {
+        char filename[WIN32_STATE_FILE_NAME_COUNT];
+        int length = WideCharToMultiByte(CP_UTF8, 0, notify->FileName, notify->FileNameLength / sizeof(WCHAR),
+                                         filename, WIN32_STATE_FILE_NAME_COUNT - 1, 0, 0);
+        filename[length] = 0;
+        for(char* at = filename; *at; ++at)
+        {
+            if(*at == '\\') *at = '/';
+        }
+
+        char name[WIN32_STATE_FILE_NAME_COUNT];
+        FormatString(name, WIN32_STATE_FILE_NAME_COUNT, "%s%s", watch.path, filename);
+
+        switch(notify->Action)
+        {
+            case FILE_ACTION_ADDED:
+            case FILE_ACTION_RENAMED_NEW_NAME:
+                PushFileChange(arena, changes, watch.location, name, FileChangeType::Added);
+                break;
+            case FILE_ACTION_MODIFIED:
+                PushFileChange(arena, changes, watch.location, name, FileChangeType::Modified);
+                break;
+            case FILE_ACTION_REMOVED:
+            case FILE_ACTION_RENAMED_OLD_NAME:
+                PushFileChange(arena, changes, watch.location, name, FileChangeType::Removed);
+                break;
+        }
+
+        if(!notify->NextEntryOffset)
+        {
+            break;
+        }
+        notify = (FILE_NOTIFY_INFORMATION*)((u8*)notify + notify->NextEntryOffset);
+    }
+}
+
+internal platform_file_change_list
+Win32GetFileChanges(memory_arena& arena)
+{
+    file_change_builder changes = {};
+
+    for(u32 index = 0; index < WIN32_MAX_DIRECTORY_WATCHES; ++index)
+    {
+        win32_directory_watch& watch = GlobalWin32State.directoryWatches[index];
+        if(!watch.id || !watch.hDirectory)
+        {
+            continue;
+        }
+
+        DWORD bytesTransferred = 0;
+        if(GetOverlappedResult(watch.hDirectory, &watch.overlapped, &bytesTransferred, FALSE))
+        {
+            // NOTE(james): zero bytes means the changes didn't fit and got thrown away
+            if(bytesTransferred)
+            {
+                Win32PushDirectoryChanges(arena, changes, watch);
+            }
+            else
+            {
+                changes.list.overflowed = true;
+            }
+        }
+        else if(GetLastError() == ERROR_IO_INCOMPLETE)
+        {
+            continue;
+        }
+        else
+        {
+            LOG_ERROR("Win32GetFileChanges: watch failed: %d", GetLastError());
+            changes.list.overflowed = true;
+        }
+
+        // the OS keeps collecting between reads, so this only has to go back out
+        if(!Win32ReadDirectoryChanges(watch))
+        {
+            // NOTE(james): most likely the directory itself is gone, the watch stays
+            // allocated but quiet until it's unwatched
+            LOG_ERROR("Win32GetFileChanges: ReadDirectoryChanges error: %d", GetLastError());
+            Win32CloseDirectoryWatch(watch);
+        }
+    }
+
+    return changes.list;
+}
@@ -6,6 +6,7 @@
 #include "ps_math.h"
 #include "ps_memory.h"
 #include "ps_collections.h"
+#include "ps_stream.h"
 // #include "ps_graphics.h"
 
 #include <windows.h>
@@ -22,6 +23,7 @@ win32_file_location FileLocationsTable[(u32)FileLocation::LocationsCount];
 
 #include "win32_audio.cpp"
 #include "win32_xinput.cpp"
+#include "ps_file_watch.h"
 #include "win32_file.cpp"
 
 // TODO(james): make this work as a loaded dll
@@ -117,13 +119,14 @@ Win32BeginRecordingInput(win32_state& state, const game_memory& memory)
                 win32_saved_memory_block savedBlock = {};
                 // TODO(james): See if we can find a way to not directly depend on the pointer location for the recording
                 savedBlock.base_pointer = (u64)sourceBlk->block.base;
-                savedBlock.size = sourceBlk->block.size;
+                // NOTE(james): reserved blocks only have their committed pages to save
+                savedBlock.size = sourceBlk->block.committed;
 
                 
                 BOOL success_size = WriteFile(state.hInputRecordHandle, &savedBlock, sizeof(savedBlock), &dwWritten, 0);
                 ASSERT(dwWritten == sizeof(savedBlock));
-                BOOL success_data = WriteFile(state.hInputRecordHandle, sourceBlk->block.base, (u32)sourceBlk->block.size, &dwWritten, 0);
-                ASSERT(dwWritten == (DWORD)sourceBlk->block.size);
+                BOOL success_data = WriteFile(state.hInputRecordHandle, sourceBlk->block.base, (u32)savedBlock.size, &dwWritten, 0);
+                ASSERT(dwWritten == (DWORD)savedBlock.size);
             }
         }
         EndTicketMutex(&GlobalWin32State.memoryMutex);
@@ -268,22 +271,131 @@ Win32GetMemoryStats()
         ASSERT(block->block.size <= U32MAX);
 
         stats.totalSize += block->block.size;
+        ++stats.blockCount;
         stats.totalUsed += block->block.used;
     } 
+    stats.cachedSize = GlobalWin32State.blockCacheSize;
+    stats.cachedBlockCount = GlobalWin32State.blockCacheCount;
+    stats.cacheHits = GlobalWin32State.blockCacheHits;
+    stats.cacheMisses = GlobalWin32State.blockCacheMisses;
+    stats.peakSize = GlobalWin32State.peakBlockSize;
     EndTicketMutex(&GlobalWin32State.memoryMutex);
 
     return stats;
 }
 #endif
 
+internal void
+Win32QueryPageSizes(win32_state& state)
+{
+    SYSTEM_INFO systemInfo = {};
+    GetSystemInfo(&systemInfo);
+    state.pageSize = systemInfo.dwPageSize;
+    state.allocationGranularity = systemInfo.dwAllocationGranularity;
+    state.largePageSize = 0;
+
+    // NOTE(james): large pages need the "Lock pages in memory" right granted to the
+    // user, without it we stick to normal pages
+    HANDLE token = 0;
+    if(OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES|TOKEN_QUERY, &token))
+    {
+        TOKEN_PRIVILEGES privileges = {};
+        privileges.PrivilegeCount = 1;
+        privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+        if(LookupPrivilegeValueA(0, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid))
+        {
+            // AdjustTokenPrivileges still succeeds when the privilege wasn't granted
+            if(AdjustTokenPrivileges(token, FALSE, &privileges, 0, 0, 0) && GetLastError() == ERROR_SUCCESS)
+            {
+                state.largePageSize = GetLargePageMinimum();
+            }
+        }
+        CloseHandle(token);
+    }
+
+    if(!state.largePageSize)
+    {
+        LOG_DEBUG("Large pages unavailable, the user needs the lock pages in memory privilege");
+    }
+}
+
+inline b32
+Win32IsCacheableBlock(PlatformMemoryFlags flags)
+{
+    // NOTE(james): guard pages, reservations and large pages are laid out for one particular size
+    return IS_FLAG_BIT_NOT_SET(flags, PlatformMemoryFlags::OverflowCheck|PlatformMemoryFlags::UnderflowCheck|PlatformMemoryFlags::ReserveOnly|PlatformMemoryFlags::LargePages);
+}
+
+inline s32
+Win32BlockCacheBucket(umm totalSize)
+{
+    if(totalSize > ((umm)1 << (WIN32_BLOCK_CACHE_MIN_SHIFT + WIN32_BLOCK_CACHE_BUCKET_COUNT - 1)))
+    {
+        return -1;
+    }
+    if(totalSize <= ((umm)1 << WIN32_BLOCK_CACHE_MIN_SHIFT))
+    {
+        return 0;
+    }
+
+    bit_scan_result scan = FindMostSignificantSetBit((u32)(totalSize - 1));
+    return (s32)scan.Index + 1 - WIN32_BLOCK_CACHE_MIN_SHIFT;
+}
+
+// NOTE(james): the memory mutex has to be held
+internal b32
+Win32CacheMemoryBlock(win32_state& state, win32_memory_block* block)
+{
+    if(!Win32IsCacheableBlock(block->block.flags))
+    {
+        return false;
+    }
+
+    s32 bucket = Win32BlockCacheBucket(block->totalAllocatedSize);
+    if(bucket < 0 || state.blockCacheSize + block->totalAllocatedSize > state.blockCacheLimit)
+    {
+        return false;
+    }
+
+    block->next = state.blockCache[bucket];
+    block->prev = 0;
+    state.blockCache[bucket] = block;
+    state.blockCacheSize += block->totalAllocatedSize;
+    ++state.blockCacheCount;
+    return true;
+}
+
+internal void
+Win32SetMemoryBlockCacheLimit(umm size)
+{
+    BeginTicketMutex(&GlobalWin32State.memoryMutex);
+    GlobalWin32State.blockCacheLimit = size;
+
+    // hand back the biggest blocks first until we fit again
+    for(s32 bucket = WIN32_BLOCK_CACHE_BUCKET_COUNT - 1;
+        bucket >= 0 && GlobalWin32State.blockCacheSize > size;
+        --bucket)
+    {
+        while(GlobalWin32State.blockCache[bucket] && GlobalWin32State.blockCacheSize > size)
+        {
+            win32_memory_block* block = GlobalWin32State.blockCache[bucket];
+            GlobalWin32State.blockCache[bucket] = block->next;
+            GlobalWin32State.blockCacheSize -= block->totalAllocatedSize;
+            --GlobalWin32State.blockCacheCount;
+            VirtualFree(block, 0, MEM_RELEASE);
+        }
+    }
+    EndTicketMutex(&GlobalWin32State.memoryMutex);
+}
+
 internal platform_memory_block*
 Win32AllocateMemoryBlock(memory_index size, PlatformMemoryFlags flags)
 {
     // NOTE(james): We require memory block headers not to change the cache
     // line alignment of an allocation
-    CompileAssert(sizeof(win32_memory_block) == 64);
+    CompileAssert(sizeof(win32_memory_block) == 128);
     
-    const umm pageSize = 4096; // TODO(james): Query from system?
+    const umm pageSize = GlobalWin32State.pageSize;
     umm totalSize = size + sizeof(win32_memory_block);
     umm baseOffset = sizeof(win32_memory_block);
     umm protectOffset = 0;
@@ -301,9 +413,81 @@ Win32AllocateMemoryBlock(memory_index size, PlatformMemoryFlags flags)
         protectOffset = pageSize + sizeRoundedUp;
     }
     
-    win32_memory_block *block = (win32_memory_block *) VirtualAlloc(0, totalSize, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
-    ASSERT(block);
+    b32 isReserveOnly = IS_FLAG_BIT_SET(flags, PlatformMemoryFlags::ReserveOnly);
+    ASSERT(!isReserveOnly || !IS_ANY_FLAG_SET(flags, PlatformMemoryFlags::OverflowCheck|PlatformMemoryFlags::UnderflowCheck));
+
+    if(IS_FLAG_BIT_SET(flags, PlatformMemoryFlags::LargePages) &&
+       (isReserveOnly || !GlobalWin32State.largePageSize ||
+        IS_ANY_FLAG_SET(flags, PlatformMemoryFlags::OverflowCheck|PlatformMemoryFlags::UnderflowCheck)))
+    {
+        // NOTE(james): MEM_LARGE_PAGES has to be committed all at once and guard
+        // pages only work with normal pages
+        flags &= ~PlatformMemoryFlags::LargePages;
+    }
+
+    win32_memory_block *block = 0;
+    umm committed = size;
+
+    if(IS_FLAG_BIT_SET(flags, PlatformMemoryFlags::LargePages))
+    {
+        umm largeSize = AlignPow2(totalSize, GlobalWin32State.largePageSize);
+        block = (win32_memory_block *) VirtualAlloc(0, largeSize, MEM_RESERVE|MEM_COMMIT|MEM_LARGE_PAGES, PAGE_READWRITE);
+        if(block)
+        {
+            totalSize = largeSize;
+        }
+        else
+        {
+            // physical memory is too fragmented for large pages, take normal ones
+            flags &= ~PlatformMemoryFlags::LargePages;
+        }
+    }
+
+    s32 cacheBucket = Win32IsCacheableBlock(flags) ? Win32BlockCacheBucket(totalSize) : -1;
+    if(cacheBucket >= 0)
+    {
+        // NOTE(james): cached blocks reserve the whole bucket so any of them fits any request in it
+        totalSize = (umm)1 << (cacheBucket + WIN32_BLOCK_CACHE_MIN_SHIFT);
+
+        BeginTicketMutex(&GlobalWin32State.memoryMutex);
+        block = GlobalWin32State.blockCache[cacheBucket];
+        if(block)
+        {
+            GlobalWin32State.blockCache[cacheBucket] = block->next;
+            GlobalWin32State.blockCacheSize -= block->totalAllocatedSize;
+            --GlobalWin32State.blockCacheCount;
+            ++GlobalWin32State.blockCacheHits;
+        }
+        else
+        {
+            ++GlobalWin32State.blockCacheMisses;
+        }
+        EndTicketMutex(&GlobalWin32State.memoryMutex);
+    }
+
+    if(block)
+    {
+        // NOTE(james): either fresh large pages or a recycled block, only the header
+        // needs resetting, the contents are whatever the last owner left
+        ZeroStruct(block->block);
+    }
+    else if(isReserveOnly)
+    {
+        // only the page holding the header is usable until the arena asks for more
+        block = (win32_memory_block *) VirtualAlloc(0, totalSize, MEM_RESERVE, PAGE_NOACCESS);
+        ASSERT(block);
+        void* header = VirtualAlloc(block, pageSize, MEM_COMMIT, PAGE_READWRITE);
+        ASSERT(header);
+        committed = Minimum(size, pageSize - baseOffset);
+    }
+    else
+    {
+        block = (win32_memory_block *) VirtualAlloc(0, totalSize, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+        ASSERT(block);
+    }
+    block->totalAllocatedSize = totalSize;
     block->block.base = (u8 *)block + baseOffset;
+    block->block.committed = committed;
     ASSERT(block->block.used == 0);
     ASSERT(block->block.prev_block == 0);
     
@@ -328,25 +512,65 @@ Win32AllocateMemoryBlock(memory_index size, PlatformMemoryFlags flags)
     block->prev = sentinel->prev;
     block->prev->next = block;
     block->next->prev = block;
+    GlobalWin32State.liveBlockSize += block->block.size;
+    GlobalWin32State.peakBlockSize = Maximum(GlobalWin32State.peakBlockSize, GlobalWin32State.liveBlockSize);
     EndTicketMutex(&GlobalWin32State.memoryMutex);
     
     platform_memory_block *platformBlock = &block->block;
     return platformBlock;
 }
 
+internal b32
+Win32CommitMemoryBlock(platform_memory_block* block, umm size)
+{
+    if(size <= block->committed)
+    {
+        return true;
+    }
+    if(size > block->size)
+    {
+        return false;
+    }
+
+    // NOTE(james): commit in big steps so a growing arena isn't a syscall per push
+    const umm commitGranularity = Kilobytes(64);
+    umm totalSize = ((win32_memory_block *)block)->totalAllocatedSize;
+    u8* commitStart = block->base + block->committed;
+    u8* commitEnd = (u8 *)block + Minimum(AlignPow2((umm)(block->base + size - (u8 *)block), commitGranularity), totalSize);
+
+    // VirtualAlloc rounds the range out to pages itself
+    void* result = VirtualAlloc(commitStart, commitEnd - commitStart, MEM_COMMIT, PAGE_READWRITE);
+    if(!result)
+    {
+        LOG_ERROR("Win32CommitMemoryBlock: VirtualAlloc error: %d", GetLastError());
+        return false;
+    }
+
+    block->committed = Minimum((umm)(commitEnd - block->base), block->size);
+    return true;
+}
+
+// NOTE(james): the memory mutex has to be held
 internal void
-Win32FreeMemoryBlock(win32_memory_block *block)
+Win32ReleaseMemoryBlock(win32_state& state, win32_memory_block *block)
 {
-    BeginTicketMutex(&GlobalWin32State.memoryMutex);
     block->prev->next = block->next;
     block->next->prev = block->prev;
+    state.liveBlockSize -= block->block.size;
+
+    if(!Win32CacheMemoryBlock(state, block))
+    {
+        BOOL Result = VirtualFree(block, 0, MEM_RELEASE);
+        ASSERT(Result);
+    }
+}
+
+internal void
+Win32FreeMemoryBlock(win32_memory_block *block)
+{
+    BeginTicketMutex(&GlobalWin32State.memoryMutex);
+    Win32ReleaseMemoryBlock(GlobalWin32State, block);
     EndTicketMutex(&GlobalWin32State.memoryMutex);
-    
-    // NOTE(james): For porting to other platforms that need the size to unmap
-    // pages, you can get it from Block->Block.Size!
-    
-    BOOL Result = VirtualFree(block, 0, MEM_RELEASE);
-    ASSERT(Result);
 }
 
 internal void
@@ -366,6 +590,125 @@ Win32DeallocateMemoryBlock(platform_memory_block* block)
     }
 }
 
+// NOTE(james): placeholders only showed up in Windows 10 1803 and live in onecore, so
+// these get looked up at startup instead of linked
+#define VIRTUAL_ALLOC_2(name) PVOID WINAPI name(HANDLE process, PVOID baseAddress, SIZE_T size, ULONG allocationType, ULONG pageProtection, MEM_EXTENDED_PARAMETER* extendedParameters, ULONG parameterCount)
+typedef VIRTUAL_ALLOC_2(virtual_alloc_2);
+#define MAP_VIEW_OF_FILE_3(name) PVOID WINAPI name(HANDLE fileMapping, HANDLE process, PVOID baseAddress, ULONG64 offset, SIZE_T viewSize, ULONG allocationType, ULONG pageProtection, MEM_EXTENDED_PARAMETER* extendedParameters, ULONG parameterCount)
+typedef MAP_VIEW_OF_FILE_3(map_view_of_file_3);
+
+global_variable virtual_alloc_2* Win32VirtualAlloc2;
+global_variable map_view_of_file_3* Win32MapViewOfFile3;
+
+internal void
+Win32LoadPlaceholderFunctions()
+{
+    HMODULE hKernelBase = GetModuleHandleA("kernelbase.dll");
+    if(hKernelBase)
+    {
+        Win32VirtualAlloc2 = (virtual_alloc_2*)GetProcAddress(hKernelBase, "VirtualAlloc2");
+        Win32MapViewOfFile3 = (map_view_of_file_3*)GetProcAddress(hKernelBase, "MapViewOfFile3");
+    }
+
+    if(!Win32VirtualAlloc2 || !Win32MapViewOfFile3)
+    {
+        LOG_DEBUG("Memory placeholders unavailable, mirrored memory falls back to remapping a released range");
+    }
+}
+
+internal platform_mirrored_memory
+Win32AllocateMirroredMemory(umm size)
+{
+    platform_mirrored_memory result = {};
+    size = AlignPow2(size, GlobalWin32State.allocationGranularity);
+
+    HANDLE section = CreateFileMappingA(INVALID_HANDLE_VALUE, 0, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, 0);
+    if(!section)
+    {
+        LOG_ERROR("Win32AllocateMirroredMemory: CreateFileMapping error: %d", GetLastError());
+        return result;
+    }
+
+    if(Win32VirtualAlloc2 && Win32MapViewOfFile3)
+    {
+        u8* placeholder = (u8*)Win32VirtualAlloc2(0, 0, 2*size, MEM_RESERVE|MEM_RESERVE_PLACEHOLDER, PAGE_NOACCESS, 0, 0);
+        if(placeholder)
+        {
+            // split the reservation in two so each half can be swapped for a view
+            VirtualFree(placeholder, size, MEM_RELEASE|MEM_PRESERVE_PLACEHOLDER);
+
+            void* view0 = Win32MapViewOfFile3(section, 0, placeholder, 0, size, MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, 0, 0);
+            void* view1 = Win32MapViewOfFile3(section, 0, placeholder + size, 0, size, MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, 0, 0);
+            if(view0 && view1)
+            {
+                result.base = placeholder;
+            }
+            else
+            {
+                LOG_ERROR("Win32AllocateMirroredMemory: MapViewOfFile3 error: %d", GetLastError());
+                if(view0) {UnmapViewOfFile(view0);} else {VirtualFree(placeholder, 0, MEM_RELEASE);}
+                if(view1) {UnmapViewOfFile(view1);} else {VirtualFree(placeholder + size, 0, MEM_RELEASE);}
+            }
+        }
+        else
+        {
+            LOG_ERROR("Win32AllocateMirroredMemory: VirtualAlloc2 error: %d", GetLastError());
+        }
+    }
+    else
+    {
+        // NOTE(james): without placeholders all we can do is find a free range, let go of
+        // it and map into it, hoping no other thread grabs it in between
+        for(u32 attempt = 0; attempt < 16 && !result.base; ++attempt)
+        {
+            u8* address = (u8*)VirtualAlloc(0, 2*size, MEM_RESERVE, PAGE_NOACCESS);
+            if(!address)
+            {
+                break;
+            }
+            VirtualFree(address, 0, MEM_RELEASE);
+
+            void* view0 = MapViewOfFileEx(section, FILE_MAP_ALL_ACCESS, 0, 0, size, address);
+            void* view1 = view0 ? MapViewOfFileEx(section, FILE_MAP_ALL_ACCESS, 0, 0, size, address + size) : 0;
+            if(view0 && view1)
+            {
+                result.base = address;
+            }
+            else if(view0)
+            {
+                UnmapViewOfFile(view0);
+            }
+        }
+
+        if(!result.base)
+        {
+            LOG_ERROR("Win32AllocateMirroredMemory: MapViewOfFileEx error: %d", GetLastError());
+        }
+    }
+
+    // the views keep the section alive on their own
+    CloseHandle(section);
+
+    if(result.base)
+    {
+        result.size = size;
+    }
+
+    return result;
+}
+
+internal void
+Win32DeallocateMirroredMemory(platform_mirrored_memory& memory)
+{
+    if(memory.base)
+    {
+        BOOL Result = UnmapViewOfFile(memory.base);
+        Result &= UnmapViewOfFile(memory.base + memory.size);
+        ASSERT(Result);
+        ZeroStruct(memory);
+    }
+}
+
 internal void
 Win32ClearMemoryBlocksByMask(win32_state& state, MemoryLoopingFlags mask)
 {
@@ -378,7 +721,8 @@ Win32ClearMemoryBlocksByMask(win32_state& state, MemoryLoopingFlags mask)
 
         if((block->loopingFlags & mask) == mask)
         {
-            Win32FreeMemoryBlock(block);
+            // NOTE(james): we already hold the ticket, Win32FreeMemoryBlock would wait on ourselves
+            Win32ReleaseMemoryBlock(state, block);
         }
         else
         {
@@ -390,86 +734,44 @@ Win32ClearMemoryBlocksByMask(win32_state& state, MemoryLoopingFlags mask)
 }
 
 internal void
-Win32AddWorkQueueEntry(platform_work_queue* queue, platform_work_queue_callback* callback, void* data)
+PlatformSemaphoreSignal(platform_semaphore& semaphore, u32 count)
 {
-    // TODO(james): Switch to InterlockedCompareExchange eventually
-    // so that any thread can add?
-    uint32 nextWriteIndex = (queue->writeIndex + 1) % ARRAY_COUNT(queue->entries);
-    ASSERT(nextWriteIndex != queue->readIndex);
-    platform_work_queue_entry *entry = queue->entries + queue->writeIndex;
-    entry->callback = callback;
-    entry->data = data;
-    ++queue->countToComplete;
-    _WriteBarrier();
-    queue->writeIndex = nextWriteIndex;
-    ReleaseSemaphore(queue->semaphore, 1, 0);
+    // NOTE(james): this fails once the count is at the max, which just means
+    // every worker is already awake
+    ReleaseSemaphore(semaphore, count, 0);
 }
 
-internal bool32
-Win32DoNextWorkQueueEntry(platform_work_queue *queue)
+internal void
+PlatformSemaphoreWait(platform_semaphore& semaphore)
 {
-    bool32 didNoWork = false;
-    
-    uint32 readIndex = queue->readIndex;
-    uint32 nextReadIndex = (readIndex + 1) % ARRAY_COUNT(queue->entries);
-    if(readIndex != queue->writeIndex)
-    {
-        uint32 index = InterlockedCompareExchange((LONG volatile *)&queue->readIndex,
-                                                  nextReadIndex,
-                                                  readIndex);
-        if(index == readIndex)
-        {
-            platform_work_queue_entry entry = queue->entries[index];
-            // TODO(james): allocate some thread specific scratch memory
-            // for each task entry to use during execution
-            entry.callback(queue, entry.data);
-            InterlockedIncrement((LONG volatile *)&queue->countCompleted);
-        }
-    }
-    else
-    {
-        didNoWork = true;
-    }
-    
-    return didNoWork;
+    WaitForSingleObjectEx(semaphore, INFINITE, FALSE);
 }
 
 internal void
-Win32CompleteAllWorkQueueWork(platform_work_queue* queue)
+PlatformYieldThread()
 {
-    while(queue->countToComplete != queue->countCompleted)
-    {
-        Win32DoNextWorkQueueEntry(queue);
-    }
-    
-    queue->countToComplete = 0;
-    queue->countCompleted = 0;
+    SwitchToThread();
 }
 
+#include "ps_work_queue.h"
+
+// NOTE(james): these are too big to live on the main thread's stack
+global_variable platform_work_queue GlobalHighPriorityQueue;
+global_variable platform_work_queue GlobalLowPriorityQueue;
+
 DWORD WINAPI
 Win32ThreadProc(LPVOID lpParameter)
 {
-    win32_thread_info *thread = (win32_thread_info *)lpParameter;
-    platform_work_queue *queue = thread->queue;
-        
-    for(;;)
-    {
-        if(Win32DoNextWorkQueueEntry(queue))
-        {
-            WaitForSingleObjectEx(queue->semaphore, INFINITE, FALSE);
-        }
-    }
+    platform_work_worker *worker = (platform_work_worker *)lpParameter;
+    WorkQueueThreadLoop(worker);
     
     //    return(0);
 }
 
 internal void
-Win32InitWorkQueue(platform_work_queue* queue, u32 numThreads, win32_thread_info* threads, u32 threadIndexOffset = 0)
+Win32InitWorkQueue(platform_work_queue* queue, u32 numThreads)
 {
-    queue->countToComplete = 0;
-    queue->countCompleted = 0;
-    queue->writeIndex = 0;
-    queue->readIndex = 0;
+    InitWorkQueueWorkers(queue, numThreads);
 
     u32 initCount = 0;
     // TODO(james): Figure out if we really need the SEMAPHORE_ALL_ACCESS right...
@@ -477,16 +779,116 @@ Win32InitWorkQueue(platform_work_queue* queue, u32 numThreads, win32_thread_info
 
     for(u32 threadIndex = 0; threadIndex < numThreads; ++threadIndex)
     {
-        win32_thread_info* pThreadInfo = threads + threadIndex;
-        pThreadInfo->thread_index = threadIndex + threadIndexOffset;
-        pThreadInfo->queue = queue;
-
         DWORD dwThreadID = 0;
-        HANDLE hThread = CreateThread(0, Megabytes(1), Win32ThreadProc, pThreadInfo, 0, &dwThreadID);
+        HANDLE hThread = CreateThread(0, Megabytes(1), Win32ThreadProc, queue->workers + threadIndex, 0, &dwThreadID);
         CloseHandle(hThread);
     }
 }
 
+#include "ps_async_file.h"
+
+internal void
+PlatformAsyncReadStart(platform_async_read* read, platform_file& file)
+{
+    // NOTE(james): files get opened for plain synchronous reads, so the first async read
+    // reopens them overlapped and ties the new handle to the completion port
+    if(!file.platformAsync)
+    {
+        HANDLE hAsync = ReOpenFile((HANDLE)file.platform, GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE, FILE_FLAG_OVERLAPPED);
+        if(hAsync != INVALID_HANDLE_VALUE &&
+           CreateIoCompletionPort(hAsync, GlobalWin32State.ioCompletionPort, 0, 0))
+        {
+            file.platformAsync = hAsync;
+        }
+        else
+        {
+            LOG_ERROR("Unable to reopen file for async reads: %d", GetLastError());
+            if(hAsync != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(hAsync);
+            }
+        }
+    }
+    read->file.platformAsync = file.platformAsync;
+
+    if(!file.platformAsync)
+    {
+        u64 bytesRead = PlatformReadFileAt(read->file, read->offset, read->size, read->dest);
+        AsyncReadComplete(read, bytesRead);
+        return;
+    }
+
+    OVERLAPPED* overlapped = &read->native.overlapped;
+    ZeroStruct(*overlapped);
+    overlapped->Offset = (DWORD)(read->offset & 0xFFFFFFFF);
+    overlapped->OffsetHigh = (DWORD)(read->offset >> 32);
+
+    // NOTE(james): a read that finishes straight away still posts to the port, so
+    // everything but an outright failure gets picked up by the reaper
+    if(!ReadFile((HANDLE)file.platformAsync, read->dest, (DWORD)read->size, 0, overlapped))
+    {
+        DWORD error = GetLastError();
+        if(error != ERROR_IO_PENDING)
+        {
+            if(error != ERROR_HANDLE_EOF)
+            {
+                LOG_ERROR("Async ReadFile failed: %d", error);
+            }
+            AsyncReadComplete(read, 0);
+        }
+    }
+}
+
+internal void
+PlatformAsyncReadSubmit()
+{
+    // NOTE(james): ReadFile already handed every read to the kernel as it was started
+}
+
+internal void
+PlatformAsyncReadReap(b32 wait)
+{
+    OVERLAPPED_ENTRY entries[64];
+    ULONG removed = 0;
+
+    if(GetQueuedCompletionStatusEx(GlobalWin32State.ioCompletionPort, entries, ARRAY_COUNT(entries), &removed, wait ? INFINITE : 0, FALSE))
+    {
+        for(ULONG index = 0; index < removed; ++index)
+        {
+            platform_async_read* read = CONTAINING_RECORD(entries[index].lpOverlapped, platform_async_read, native.overlapped);
+            // NOTE(james): a failed read just reports whatever made it across, which is
+            // nothing for reads past the end of the file
+            AsyncReadComplete(read, entries[index].dwNumberOfBytesTransferred);
+        }
+    }
+}
+
+internal u64
+PlatformReadFileAt(platform_file& file, u64 offset, u64 size, void* dest)
+{
+    u64 amountRead = 0;
+    HANDLE hFile = (HANDLE)file.platform;
+
+    // have to loop to handle sizes too big to fit into a DWORD
+    while(amountRead < size)
+    {
+        u64 at = offset + amountRead;
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = (DWORD)(at & 0xFFFFFFFF);
+        overlapped.OffsetHigh = (DWORD)(at >> 32);
+
+        DWORD readSize = (DWORD)Minimum(size - amountRead, (u64)U32MAX);
+        DWORD dwReadBytes = 0;
+        if(!ReadFile(hFile, (u8*)dest + amountRead, readSize, &dwReadBytes, &overlapped) || dwReadBytes == 0)
+        {
+            break;
+        }
+        amountRead += dwReadBytes;
+    }
+
+    return amountRead;
+}
+
 
 
 internal
@@ -519,15 +921,17 @@ extern "C" int __stdcall WinMainCRTStartup()
     win32_memory_block* sentinal = &GlobalWin32State.memorySentinal;
     sentinal->next = sentinal;
     sentinal->prev = sentinal;
+    GlobalWin32State.blockCacheLimit = WIN32_BLOCK_CACHE_DEFAULT_LIMIT;
+    Win32QueryPageSizes(GlobalWin32State);
+    Win32LoadPlaceholderFunctions();
 
-    win32_thread_info highPriorityThreadInfos[8];
-    win32_thread_info lowPriorityThreadInfos[2];
-    platform_work_queue highPriorityQueue;
-    platform_work_queue lowPriorityQueue;
     LOG_DEBUG("Main Thread ID: %u", GetCurrentThreadId());
 
-    Win32InitWorkQueue(&highPriorityQueue, ARRAY_COUNT(highPriorityThreadInfos), highPriorityThreadInfos);
-    Win32InitWorkQueue(&lowPriorityQueue, ARRAY_COUNT(lowPriorityThreadInfos), lowPriorityThreadInfos);
+    Win32InitWorkQueue(&GlobalHighPriorityQueue, 8);
+    Win32InitWorkQueue(&GlobalLowPriorityQueue, 2);
+
+    GlobalWin32State.ioCompletionPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, 0, 0, 0);
+    InitAsyncFileIO(GlobalWin32State.ioCompletionPort ? 0 : &GlobalLowPriorityQueue);
 
     WNDCLASSEXA wndClass = {};
     wndClass.cbSize = sizeof(wndClass);
@@ -567,31 +971,58 @@ extern "C" int __stdcall WinMainCRTStartup()
     game_memory gameMemory = {};
     graphics_context gameGraphics = {};
 
-    gameMemory.highPriorityQueue = &highPriorityQueue;
-    gameMemory.lowPriorityQueue = &lowPriorityQueue;
+    gameMemory.highPriorityQueue = &GlobalHighPriorityQueue;
+    gameMemory.lowPriorityQueue = &GlobalLowPriorityQueue;
 
     gameMemory.platformApi.Log = &Win32Log;
-    gameMemory.platformApi.AddWorkEntry = &Win32AddWorkQueueEntry;
-    gameMemory.platformApi.CompleteAllWork = &Win32CompleteAllWorkQueueWork;
+    gameMemory.platformApi.AddWorkEntry = &AddWorkQueueEntry;
+    gameMemory.platformApi.CompleteAllWork = &CompleteAllWorkQueueWork;
+    gameMemory.platformApi.AddCountedWorkEntry = &AddCountedWorkQueueEntry;
+    gameMemory.platformApi.CompleteCounterWork = &CompleteCounterWork;
+    gameMemory.platformApi.AddWorkBatch = &AddWorkQueueBatch;
+    gameMemory.platformApi.WaitForWork = &WaitForWorkQueueBatch;
+    gameMemory.platformApi.IsWorkComplete = &IsWorkQueueBatchComplete;
     gameMemory.platformApi.AllocateMemoryBlock = &Win32AllocateMemoryBlock;
     gameMemory.platformApi.DeallocateMemoryBlock = &Win32DeallocateMemoryBlock;
+    gameMemory.platformApi.CommitMemoryBlock = &Win32CommitMemoryBlock;
+    gameMemory.platformApi.SetMemoryBlockCacheLimit = &Win32SetMemoryBlockCacheLimit;
+    gameMemory.platformApi.AllocateMirroredMemory = &Win32AllocateMirroredMemory;
+    gameMemory.platformApi.DeallocateMirroredMemory = &Win32DeallocateMirroredMemory;
     gameMemory.platformApi.OpenFile = &Win32OpenFile;
     gameMemory.platformApi.ReadFile = &Win32ReadFile;
     gameMemory.platformApi.WriteFile = &Win32WriteFile;
     gameMemory.platformApi.CloseFile = &Win32CloseFile;
+    gameMemory.platformApi.MapFile = &Win32MapFile;
+    gameMemory.platformApi.UnmapFile = &Win32UnmapFile;
+    gameMemory.platformApi.ListFiles = &Win32ListFiles;
+    gameMemory.platformApi.WatchDirectory = &Win32WatchDirectory;
+    gameMemory.platformApi.UnwatchDirectory = &Win32UnwatchDirectory;
+    gameMemory.platformApi.GetFileChanges = &Win32GetFileChanges;
+    gameMemory.platformApi.ReadFileAsync = &ReadFileAsync;
+    gameMemory.platformApi.ReadFileAsyncBatch = &ReadFileAsyncBatch;
+    gameMemory.platformApi.IsFileReadComplete = &IsFileReadComplete;
+    gameMemory.platformApi.WaitForFileRead = &WaitForFileRead;
 
 #if defined(PROJECTSUPER_INTERNAL)
     gameMemory.platformApi.DEBUG_Log = &Win32DebugLog;
+    gameMemory.platformApi.DEBUG_GetMemoryStats = &Win32GetMemoryStats;
 #endif
 
     Platform = gameMemory.platformApi;
 
 #if TEST_COLLECTIONS
     {
-        b32 passed = TestCollections();
+        b32 passed = TestCollections(&GlobalHighPriorityQueue);
+        passed &= TestWorkQueue(&GlobalHighPriorityQueue);
+        passed &= TestStreams(&GlobalHighPriorityQueue);
         ASSERT(passed);
     }
 #endif
+
+#if BENCH_COLLECTIONS
+    BenchSort();
+    BenchParallelSort(&GlobalHighPriorityQueue);
+#endif
     
     // NOTE(james): Set the windows scheduler granularity to 1ms so that our sleep can be more granular
     bool32 bSleepIsMs = timeBeginPeriod(1) == TIMERR_NOERROR;
@@ -47,6 +47,9 @@ struct win32_memory_block
     win32_memory_block* next;
     win32_memory_block* prev;
     MemoryLoopingFlags loopingFlags;
+
+    u64 totalAllocatedSize;
+    u64 pad[6];
 };
 
 enum class RunLoopMode
@@ -57,12 +60,47 @@ enum class RunLoopMode
 };
 
 #define WIN32_STATE_FILE_NAME_COUNT MAX_PATH
+// NOTE(james): freed blocks are kept in power of two buckets of their reserved size,
+// 64 KB up to 64 MB, so the next frame can have them back without a syscall
+#define WIN32_BLOCK_CACHE_MIN_SHIFT 16
+#define WIN32_BLOCK_CACHE_BUCKET_COUNT 11
+#define WIN32_BLOCK_CACHE_DEFAULT_LIMIT Megabytes(64)
+
+#define WIN32_MAX_DIRECTORY_WATCHES 32
+// NOTE(james): ReadDirectoryChangesW won't take more than this over the network
+#define WIN32_WATCH_BUFFER_SIZE Kilobytes(64)
+
+struct win32_directory_watch
+{
+    // NOTE(james): zero when the slot is free
+    u32 id;
+    FileLocation location;
+    // NOTE(james): relative to the file location, ends in a slash unless it's the root
+    char path[WIN32_STATE_FILE_NAME_COUNT];
+
+    HANDLE hDirectory;
+    OVERLAPPED overlapped;
+    // NOTE(james): the kernel fills this in whenever the read completes, so it has to stay
+    // put while there is one outstanding
+    void* buffer;
+};
+
 struct win32_state
 {
-    // NOTE(james): To touch the memory sentinal, you have to
+    // NOTE(james): To touch the memory sentinal or the block cache, you have to
     // take a ticket!
     ticket_mutex memoryMutex;
     win32_memory_block memorySentinal;
+    // NOTE(james): mapped block bytes handed out right now, and the most there ever were
+    umm liveBlockSize;
+    umm peakBlockSize;
+
+    win32_memory_block* blockCache[WIN32_BLOCK_CACHE_BUCKET_COUNT];
+    umm blockCacheSize;
+    umm blockCacheLimit;
+    u32 blockCacheCount;
+    u64 blockCacheHits;
+    u64 blockCacheMisses;
     
     RunLoopMode runMode;
     HANDLE hInputRecordHandle;
@@ -72,31 +110,28 @@ struct win32_state
     
     HINSTANCE Instance;
     HWND mainWindow;    
-};
 
-struct platform_work_queue_entry
-{
-    platform_work_queue_callback *callback;
-    void *data;
-};
+    umm pageSize;
+    // NOTE(james): zero unless we were granted the lock pages privilege
+    umm largePageSize;
+    // NOTE(james): file mapping views have to start on this, not just a page
+    umm allocationGranularity;
 
-struct platform_work_queue
-{
-    u32 volatile countToComplete;
-    u32 volatile countCompleted;
-    
-    u32 volatile writeIndex;
-    u32 volatile readIndex;
-    HANDLE semaphore;
-    
-    platform_work_queue_entry entries[256];
+    // NOTE(james): zero when async reads fall back to the low priority queue
+    HANDLE ioCompletionPort;
+
+    u32 nextWatchId;
+    win32_directory_watch directoryWatches[WIN32_MAX_DIRECTORY_WATCHES];
 };
 
-struct win32_thread_info
+// NOTE(james): the completion port hands back the OVERLAPPED, which leads back to the read
+struct win32_async_read
 {
-    u32 thread_index;
-    platform_work_queue* queue;
+    OVERLAPPED overlapped;
 };
+typedef win32_async_read platform_async_read_native;
+
+typedef HANDLE platform_semaphore;
 
 struct win32_file_location {
     FileLocation location;